@@ -0,0 +1,71 @@
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <thread>
+
+#include "protocol/handshake_encryption.h"
+#include "utils/diffie_hellman.h"
+#include "utils/diffie_hellman_pool.h"
+
+// Measures the key work an encrypted handshake does on the main thread,
+// generating a key and computing the shared secret, during a burst of
+// incoming connections. With the pool, key generation happens on the
+// worker thread before the burst arrives.
+//
+// Both wall clock rate and main thread CPU time are reported, as the
+// worker refilling the pool competes for the CPU on single core hosts.
+
+static const unsigned int burst_size = 256;
+
+double
+thread_cpu_seconds() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+using torrent::HandshakeEncryption;
+
+void
+bench(const char* name, unsigned int reserve) {
+  torrent::DiffieHellmanPool pool(HandshakeEncryption::dh_prime, HandshakeEncryption::dh_prime_length,
+                                  HandshakeEncryption::dh_generator, HandshakeEncryption::dh_generator_length);
+
+  torrent::DiffieHellman peer(HandshakeEncryption::dh_prime, HandshakeEncryption::dh_prime_length,
+                              HandshakeEncryption::dh_generator, HandshakeEncryption::dh_generator_length);
+
+  unsigned char peer_key[96];
+  peer.store_pub_key(peer_key, 96);
+
+  pool.set_reserve(reserve);
+
+  while (pool.size() != reserve)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  auto start     = std::chrono::steady_clock::now();
+  auto start_cpu = thread_cpu_seconds();
+
+  for (unsigned int i = 0; i < burst_size; i++) {
+    auto key = pool.take();
+
+    if (!key->is_valid() || !key->compute_secret(peer_key, 96)) {
+      std::cerr << "key exchange failed" << std::endl;
+      return;
+    }
+  }
+
+  double elapsed_cpu = thread_cpu_seconds() - start_cpu;
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  std::cout << name << ": " << burst_size / elapsed.count() << " handshakes/s, "
+            << elapsed_cpu / burst_size * 1e6 << " us main thread cpu per handshake" << std::endl;
+}
+
+int
+main() {
+  bench("on demand   ", 0);
+  bench("pooled      ", burst_size);
+
+  return 0;
+}
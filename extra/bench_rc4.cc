@@ -0,0 +1,68 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <openssl/rc4.h>
+
+#include "utils/rc4_portable.h"
+
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+
+// Compares the portable RC4 with OpenSSL, both for encrypting in place
+// after a copy, as uploads used to do, and for encrypting directly from
+// the source buffer.
+
+static const unsigned char key[20] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20 };
+
+static const unsigned int block_size = 16 << 10;
+static const unsigned int total_size = 256 << 20;
+
+template <typename Func>
+void
+bench(const char* name, Func func) {
+  auto start = std::chrono::steady_clock::now();
+
+  for (unsigned int i = 0; i < total_size / block_size; i++)
+    func(i);
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  std::cout << name << ": " << (total_size >> 20) / elapsed.count() << " MiB/s" << std::endl;
+}
+
+int
+main() {
+  std::vector<unsigned char> source(block_size * 64);
+  std::vector<unsigned char> target(block_size);
+
+  for (size_t i = 0; i < source.size(); i++)
+    source[i] = std::rand();
+
+  auto source_block = [&](unsigned int i) { return source.data() + (i % 64) * block_size; };
+
+  RC4_KEY openssl_key;
+  RC4_set_key(&openssl_key, sizeof(key), key);
+  torrent::RC4Portable rc4(key, sizeof(key));
+
+  bench("openssl copy+crypt  ", [&](unsigned int i) {
+      std::memcpy(target.data(), source_block(i), block_size);
+      ::RC4(&openssl_key, block_size, target.data(), target.data());
+    });
+
+  bench("openssl crypt       ", [&](unsigned int i) {
+      ::RC4(&openssl_key, block_size, source_block(i), target.data());
+    });
+
+  bench("portable copy+crypt ", [&](unsigned int i) {
+      std::memcpy(target.data(), source_block(i), block_size);
+      rc4.crypt(target.data(), target.data(), block_size);
+    });
+
+  bench("portable crypt      ", [&](unsigned int i) {
+      rc4.crypt(source_block(i), target.data(), block_size);
+    });
+
+  return 0;
+}
@@ -0,0 +1,3 @@
+STUFF="-Wall -O2 -std=c++17 -I.. -I../src/ `pkg-config --cflags openssl`"
+
+g++ $STUFF -o bench_dh bench_dh.cc ../src/protocol/handshake_encryption.cc ../src/utils/diffie_hellman.cc ../src/utils/diffie_hellman_pool.cc ../src/torrent/exceptions.cc -lpthread `pkg-config --libs-only-L openssl` -lcrypto
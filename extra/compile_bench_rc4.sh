@@ -0,0 +1,3 @@
+STUFF="-Wall -O2 -I.. -I../src/ `pkg-config --cflags openssl`"
+
+g++ $STUFF -o bench_rc4 bench_rc4.cc ../src/utils/rc4_portable.cc `pkg-config --libs-only-L openssl` -lcrypto
@@ -31,6 +31,38 @@ AC_DEFUN([TORRENT_WITHOUT_EPOLL], [
 ])
 
 
+AC_DEFUN([TORRENT_CHECK_IO_URING], [
+  AC_MSG_CHECKING(for io_uring support)
+
+  AC_COMPILE_IFELSE([AC_LANG_SOURCE([
+      #include <linux/io_uring.h>
+      #include <sys/syscall.h>
+      int main() {
+        struct io_uring_params p = {};
+        int op = IORING_OP_READ;
+        return syscall(__NR_io_uring_setup, 1, &p) + op;
+      }
+      ])],
+    [
+      AC_DEFINE(USE_IO_URING, 1, Use io_uring.)
+      AC_MSG_RESULT(yes)
+    ], [
+      AC_MSG_RESULT(no)
+    ])
+])
+
+AC_DEFUN([TORRENT_WITHOUT_IO_URING], [
+  AC_ARG_WITH(io-uring,
+    AS_HELP_STRING([--without-io-uring],[do not check for io_uring support]),
+    [
+      if test "$withval" = "yes"; then
+        TORRENT_CHECK_IO_URING
+      fi
+    ], [
+        TORRENT_CHECK_IO_URING
+    ])
+])
+
 AC_DEFUN([TORRENT_CHECK_KQUEUE], [
   AC_MSG_CHECKING(for kqueue support)
 
@@ -80,6 +80,78 @@ AC_DEFUN([TORRENT_CHECK_POSIX_FADVISE], [
   ])
 ])
 
+AC_DEFUN([TORRENT_CHECK_SYNC_FILE_RANGE], [
+  AC_MSG_CHECKING(for sync_file_range)
+
+  AC_COMPILE_IFELSE([AC_LANG_SOURCE([
+      #define _GNU_SOURCE
+      #include <fcntl.h>
+      void f() { sync_file_range(0, 0, 0, SYNC_FILE_RANGE_WRITE); }
+      ])],
+    [
+      AC_MSG_RESULT(yes)
+      AC_DEFINE(USE_SYNC_FILE_RANGE, 1, Use sync_file_range)
+    ], [
+      AC_MSG_RESULT(no)
+  ])
+])
+
+AC_DEFUN([TORRENT_CHECK_SENDFILE], [
+  AC_MSG_CHECKING(for sendfile)
+
+  AC_COMPILE_IFELSE([AC_LANG_SOURCE([
+      #include <sys/types.h>
+      #include <sys/sendfile.h>
+      void f() { off_t offset = 0; sendfile(0, 0, &offset, 0); }
+      ])],
+    [
+      AC_MSG_RESULT(yes)
+      AC_DEFINE(USE_SENDFILE, 1, Use Linux sendfile)
+    ], [
+      AC_MSG_RESULT(no)
+  ])
+])
+
+AC_DEFUN([TORRENT_CHECK_MSG_ZEROCOPY], [
+  AC_MSG_CHECKING(for MSG_ZEROCOPY)
+
+  AC_COMPILE_IFELSE([AC_LANG_SOURCE([
+      #include <sys/socket.h>
+      #include <linux/errqueue.h>
+      void f() {
+        int flags = MSG_ZEROCOPY | MSG_ERRQUEUE;
+        int option = SO_ZEROCOPY;
+        int origin = SO_EE_ORIGIN_ZEROCOPY;
+      }
+      ])],
+    [
+      AC_MSG_RESULT(yes)
+      AC_DEFINE(USE_MSG_ZEROCOPY, 1, Use MSG_ZEROCOPY for sending)
+    ], [
+      AC_MSG_RESULT(no)
+  ])
+])
+
+AC_DEFUN([TORRENT_CHECK_MMSG], [
+  AC_MSG_CHECKING(for recvmmsg and sendmmsg)
+
+  AC_COMPILE_IFELSE([AC_LANG_SOURCE([
+      #define _GNU_SOURCE
+      #include <sys/socket.h>
+      void f() {
+        struct mmsghdr msgs[[2]];
+        recvmmsg(0, msgs, 2, 0, 0);
+        sendmmsg(0, msgs, 2, 0);
+      }
+      ])],
+    [
+      AC_MSG_RESULT(yes)
+      AC_DEFINE(USE_MMSG, 1, Use recvmmsg and sendmmsg for datagram batches)
+    ], [
+      AC_MSG_RESULT(no)
+  ])
+])
+
 AC_DEFUN([TORRENT_CHECK_CACHELINE], [
   AC_REQUIRE([AC_CANONICAL_HOST])
   AC_MSG_CHECKING([for target cacheline size])
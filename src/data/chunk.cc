@@ -64,6 +64,11 @@ Chunk::is_all_valid() const {
   return !empty() && std::all_of(begin(), end(), std::mem_fn(&ChunkPart::is_valid));
 }
 
+bool
+Chunk::is_buffered() const {
+  return std::any_of(begin(), end(), [](auto& part) { return part.mapped() == ChunkPart::MAPPED_BUFFER; });
+}
+
 void
 Chunk::clear() {
   std::for_each(begin(), end(), std::mem_fn(&ChunkPart::clear));
@@ -173,7 +178,7 @@ Chunk::sync(int flags) {
   bool success = true;
 
   for (auto& c : *this)
-    if (!c.chunk().sync(0, c.chunk().size(), flags))
+    if (!c.sync(flags))
       success = false;
 
   return success;
@@ -37,6 +37,7 @@ public:
   Chunk& operator=(const Chunk&) = delete;
 
   bool                is_all_valid() const;
+  bool                is_buffered() const;
 
   // All permissions are set for empty chunks.
   bool                is_readable() const             { return m_prot & MemoryChunk::prot_read; }
@@ -2,8 +2,13 @@
 
 #include "chunk_list.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "data/chunk.h"
 #include "data/chunk_manager.h"
+#include "data/chunk_writeback.h"
+#include "data/thread_disk.h"
 #include "torrent/exceptions.h"
 #include "torrent/data/download_data.h"
 #include "torrent/runtime/memory_manager.h"
@@ -24,6 +29,14 @@ struct chunk_list_earliest_modified {
   std::chrono::microseconds m_time{this_thread::cached_time()};
 };
 
+ChunkList::ChunkList() :
+    m_writeback_id(system::make_callback_id()) {
+}
+
+ChunkList::~ChunkList() {
+  clear();
+}
+
 inline bool
 ChunkList::is_queued(ChunkListNode* node) {
   return std::find(m_queue.begin(), m_queue.end(), node) != m_queue.end();
@@ -55,12 +68,21 @@ void
 ChunkList::clear() {
   LT_LOG_THIS(INFO, "Clearing.", 0);
 
+  wait_for_writeback();
+
   // Don't do any sync'ing as whomever decided to shut down really
   // doesn't care, so just de-reference all chunks in queue.
+  //
+  // Buffered chunks are still written back, as unlike mapped chunks
+  // their modifications are not yet in the page cache.
   for (auto chunk : m_queue) {
     if (chunk->references() != 1 || chunk->writable() != 1)
       throw internal_error("ChunkList::clear() called but a node in the queue is still referenced.");
 
+    if (chunk->chunk()->is_buffered() && !chunk->chunk()->sync(MemoryChunk::sync_async))
+      LT_LOG_THIS(ERROR, "Could not write back buffered chunk: index:%" PRIu32 " errno:%i errmsg:%s.",
+                  chunk->index(), errno, std::strerror(errno));
+
     chunk->dec_rw();
     clear_chunk(chunk, release_default);
   }
@@ -92,6 +114,16 @@ ChunkList::get(size_type index, get_flags flags) {
 
   ChunkListNode* node = &base_type::at(index);
 
+  // Chunks in a writeback batch are being written from the disk
+  // thread, and finishing the batch may release them, so writers must
+  // wait for it to complete.
+  if ((flags & get_writable) && node->is_writeback()) {
+    if ((flags & get_nonblock))
+      return ChunkHandle::from_error(EAGAIN);
+
+    wait_for_writeback();
+  }
+
   int allocate_flags = (flags & get_dont_log) ? ChunkManager::allocate_dont_log : 0;
   int prot_flags = MemoryChunk::prot_read | ((flags & get_writable) ? MemoryChunk::prot_write : 0);
 
@@ -257,14 +289,19 @@ ChunkList::sync_chunks(cache_list& cache, sync_flags flags) {
   if (m_queue.empty())
     return 0;
 
+  bool use_writeback = (flags & sync_use_timeout) && ThreadDisk::thread_disk() != nullptr && ThreadDisk::thread_disk()->is_active();
+
   Queue::iterator split;
 
-  if ((flags & sync_all))
+  if ((flags & sync_all)) {
+    wait_for_writeback();
     split = m_queue.begin();
-  else
+
+  } else {
     split = std::stable_partition(m_queue.begin(), m_queue.end(), [](ChunkListNode* n) {
-      return 1 != n->writable();
+      return 1 != n->writable() || n->is_writeback();
     });
+  }
 
   // Allow a flag that does more culling, so that we only get large
   // continous sections.
@@ -289,6 +326,11 @@ ChunkList::sync_chunks(cache_list& cache, sync_flags flags) {
   if ((flags & sync_use_timeout) && !(flags & sync_force))
     split = partition_optimize(split, m_queue.end(), 50, 5, false);
 
+  if (use_writeback) {
+    start_writeback(split, m_queue.end(), flags);
+    return 0;
+  }
+
   uint32_t failed = 0;
 
   for (auto itr = split, last = m_queue.end(); itr != last; ++itr) {
@@ -340,6 +382,106 @@ ChunkList::sync_chunks_no_cache(sync_flags flags) {
   return sync_chunks(cache, flags);
 }
 
+void
+ChunkList::wait_for_writeback() {
+  if (m_writebacks.empty())
+    return;
+
+  LT_LOG_THIS(DEBUG, "Waiting for writeback: batches:%zu.", m_writebacks.size());
+
+  for (auto& writeback : m_writebacks)
+    writeback->wait_done();
+
+  // Completion callbacks have all been added by now, so cancel them
+  // and finish the batches here.
+  main_thread::cancel_callback(m_writeback_id);
+
+  while (!m_writebacks.empty())
+    finish_writeback(m_writebacks.front().get());
+}
+
+// The chunks stay in 'm_queue' flagged as writeback, so they are
+// neither synced again nor released until the batch is finished.
+void
+ChunkList::start_writeback(Queue::iterator first, Queue::iterator last, sync_flags flags) {
+  if (first == last)
+    return;
+
+  auto writeback = std::make_shared<ChunkWriteback>(flags);
+
+  for (auto itr = first; itr != last; ++itr) {
+    if ((*itr)->references() <= 0 || (*itr)->writable() <= 0)
+      throw internal_error("ChunkList::start_writeback(...) got a node with invalid reference count.");
+
+    auto options = sync_options(*itr, flags);
+
+    (*itr)->set_writeback(true);
+    writeback->push_back(*itr, (*itr)->chunk(), options.first, options.second);
+  }
+
+  writeback->prepare();
+  m_writebacks.push_back(writeback);
+
+  LT_LOG_THIS(DEBUG, "Starting writeback: chunks:%zu ranges:%zu.", writeback->chunks().size(), writeback->ranges().size());
+
+  disk_thread::callback([this, writeback, id = m_writeback_id]() mutable {
+      writeback->perform();
+
+      main_thread::callback(id, [this, writeback]() { finish_writeback(writeback.get()); });
+      writeback->set_done();
+    });
+}
+
+void
+ChunkList::finish_writeback(ChunkWriteback* writeback) {
+  auto itr = std::find_if(m_writebacks.begin(), m_writebacks.end(), [writeback](auto& w) { return w.get() == writeback; });
+
+  // Already finished by wait_for_writeback().
+  if (itr == m_writebacks.end())
+    return;
+
+  auto holder = std::move(*itr);
+  m_writebacks.erase(itr);
+
+  LT_LOG_THIS(DEBUG, "Finished writeback: chunks:%zu failed:%" PRIu32 " latency:%" PRIi64 "us.",
+              writeback->chunks().size(), writeback->failed(), static_cast<int64_t>(writeback->latency().count()));
+
+  Queue released;
+  int    error = 0;
+
+  for (auto& entry : writeback->chunks()) {
+    entry.node->set_writeback(false);
+
+    if (entry.error != 0) {
+      error = entry.error;
+      continue;
+    }
+
+    entry.node->set_sync_triggered(true);
+
+    if (!entry.release)
+      continue;
+
+    entry.node->dec_rw();
+
+    if (entry.node->references() == 0)
+      clear_chunk(entry.node, release_default);
+
+    released.push_back(entry.node);
+  }
+
+  std::sort(released.begin(), released.end());
+
+  m_queue.erase(std::remove_if(m_queue.begin(), m_queue.end(), [&released](ChunkListNode* n) {
+      return std::binary_search(released.begin(), released.end(), n);
+    }), m_queue.end());
+
+  runtime::memory_manager()->release_sync_queue(released.size(), m_chunk_size);
+
+  if (writeback->failed() != 0 && !(writeback->sync_flags() & sync_ignore_error))
+    m_slot_storage_error("Could not sync chunk: " + std::string(std::strerror(error)));
+}
+
 std::pair<int, bool>
 ChunkList::sync_options(ChunkListNode* node, sync_flags flags) {
   if ((flags & sync_force)) {
@@ -2,16 +2,19 @@
 #define LIBTORRENT_DATA_CHUNK_LIST_H
 
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "chunk.h"
 #include "chunk_handle.h"
 #include "chunk_list_node.h"
+#include "torrent/system/callbacks.h"
 
 namespace torrent {
 
 class ChunkManager;
+class ChunkWriteback;
 class Content;
 class download_data;
 class DownloadWrapper;
@@ -68,8 +71,8 @@ public:
 
   static constexpr int flag_active = (1 << 0);
 
-  ChunkList() = default;
-  ~ChunkList() { clear(); }
+  ChunkList();
+  ~ChunkList();
 
   int                 flags() const                       { return m_flags; }
 
@@ -102,6 +105,12 @@ public:
   uint32_t            sync_chunks(cache_list& cache, sync_flags flags);
   uint32_t            sync_chunks_no_cache(sync_flags flags);
 
+  // Periodic syncs with sync_use_timeout are done as a ChunkWriteback
+  // batch on the disk thread, if it is running. Other syncs first wait
+  // for pending batches that could hold the chunks.
+  bool                has_writeback() const               { return !m_writebacks.empty(); }
+  void                wait_for_writeback();
+
   slot_string&        slot_storage_error()        { return m_slot_storage_error; }
   slot_chunk_index&   slot_create_chunk()         { return m_slot_create_chunk; }
   slot_chunk_index&   slot_create_hashing_chunk() { return m_slot_create_hashing_chunk; }
@@ -127,6 +136,9 @@ private:
 
   static std::pair<int,bool> sync_options(ChunkListNode* node, sync_flags flags);
 
+  void                start_writeback(Queue::iterator first, Queue::iterator last, sync_flags flags);
+  void                finish_writeback(ChunkWriteback* writeback);
+
   download_data*      m_data{};
   ChunkManager*       m_manager{};
   Queue               m_queue;
@@ -138,6 +150,9 @@ private:
   slot_chunk_index    m_slot_create_chunk;
   slot_chunk_index    m_slot_create_hashing_chunk;
   slot_free_space     m_slot_free_diskspace;
+
+  std::vector<std::shared_ptr<ChunkWriteback>> m_writebacks;
+  system::callback_id                          m_writeback_id;
 };
 
 inline ChunkList::sync_flags
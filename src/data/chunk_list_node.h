@@ -37,6 +37,11 @@ public:
   bool                sync_triggered() const         { return m_async_triggered; }
   void                set_sync_triggered(bool v)     { m_async_triggered = v; }
 
+  // Set while the chunk is part of a ChunkWriteback batch, which
+  // keeps it queued and mapped.
+  bool                is_writeback() const           { return m_writeback; }
+  void                set_writeback(bool v)          { m_writeback = v; }
+
   int                 references() const             { return m_references; }
   int                 dec_references()               { return --m_references; }
   int                 inc_references()               { return ++m_references; }
@@ -61,6 +66,7 @@ private:
   int                 m_blocking{0};
 
   bool                m_async_triggered{false};
+  bool                m_writeback{false};
 
   std::chrono::microseconds m_time_modified{};
   std::chrono::microseconds m_time_preloaded{};
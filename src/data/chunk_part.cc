@@ -1,9 +1,12 @@
 #include "config.h"
 
 #include <algorithm>
+#include <cstdlib>
+#include <unistd.h>
 
 #include "torrent/exceptions.h"
 #include "chunk_part.h"
+#include "socket_file.h"
 
 namespace torrent {
 
@@ -14,14 +17,47 @@ ChunkPart::clear() {
     m_chunk.unmap();
     break;
 
+  case MAPPED_BUFFER:
+    std::free(m_chunk.ptr());
+
+    if (m_fd != -1)
+      ::close(m_fd);
+
+    m_fd = -1;
+    break;
+
   default:
   case MAPPED_STATIC:
-    throw internal_error("ChunkPart::clear() only MAPPED_MMAP supported.");
+    throw internal_error("ChunkPart::clear() only MAPPED_MMAP and MAPPED_BUFFER supported.");
   }
 
   m_chunk.clear();
 }
 
+// Buffered parts have no dirty page tracking, so writable parts are
+// always written back in full.
+bool
+ChunkPart::sync(int flags) {
+  if (m_mapped != MAPPED_BUFFER)
+    return m_chunk.sync(0, m_chunk.size(), flags);
+
+  if (!m_chunk.is_writable())
+    return true;
+
+  if (m_fd == -1)
+    throw internal_error("ChunkPart::sync(...) buffered part has no file descriptor.");
+
+  SocketFile file(m_fd);
+
+  if (!file.write_buffer(m_file_offset, m_chunk.begin(), m_chunk.size()))
+    return false;
+
+  if ((flags & MemoryChunk::sync_sync) && !file.sync_data())
+    return false;
+
+  return true;
+}
+
 bool
 ChunkPart::is_incore(uint32_t pos, uint32_t length) {
   length = std::min(length, remaining_from(pos));
@@ -13,7 +13,11 @@ class ChunkPart {
 public:
   enum mapped_type {
     MAPPED_MMAP,
-    MAPPED_STATIC
+    MAPPED_STATIC,
+
+    // Heap memory filled with pread, written back with pwrite on sync
+    // using the part's own descriptor.
+    MAPPED_BUFFER
   };
 
   ChunkPart(mapped_type mapped, const MemoryChunk& c, uint32_t pos) :
@@ -41,6 +45,12 @@ public:
 
   void                set_file(File* f, uint64_t f_offset)  { m_file = f; m_file_offset = f_offset; }
 
+  // Only used by MAPPED_BUFFER, the descriptor is closed by clear().
+  int                 file_descriptor() const               { return m_fd; }
+  void                set_file_descriptor(int fd)           { m_fd = fd; }
+
+  bool                sync(int flags);
+
   bool                is_incore(uint32_t pos, uint32_t length = ~uint32_t());
   uint32_t            incore_length(uint32_t pos, uint32_t length = ~uint32_t());
 
@@ -55,6 +65,8 @@ private:
   // temporary storage, etc.
   File*               m_file{};
   uint64_t            m_file_offset{0};
+
+  int                 m_fd{-1};
 };
 
 } // namespace torrent
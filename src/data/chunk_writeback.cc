@@ -0,0 +1,146 @@
+#include "config.h"
+
+#include "data/chunk_writeback.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "data/chunk.h"
+#include "torrent/exceptions.h"
+#include "torrent/data/file.h"
+#include "utils/instrumentation.h"
+
+namespace torrent {
+
+namespace {
+
+instrumentation_enum
+writeback_latency_bucket(std::chrono::microseconds latency) {
+  if (latency < std::chrono::milliseconds(1))
+    return INSTRUMENTATION_WRITEBACK_LATENCY_1MS;
+  else if (latency < std::chrono::milliseconds(10))
+    return INSTRUMENTATION_WRITEBACK_LATENCY_10MS;
+  else if (latency < std::chrono::milliseconds(100))
+    return INSTRUMENTATION_WRITEBACK_LATENCY_100MS;
+  else if (latency < std::chrono::seconds(1))
+    return INSTRUMENTATION_WRITEBACK_LATENCY_1S;
+  else
+    return INSTRUMENTATION_WRITEBACK_LATENCY_SLOW;
+}
+
+} // namespace
+
+void
+ChunkWriteback::push_back(ChunkListNode* node, Chunk* chunk, int flags, bool release) {
+  m_chunks.push_back(chunk_type{node, chunk, flags, release});
+
+  for (auto& part : *chunk) {
+    if (part.file() == nullptr || part.file()->is_padding())
+      continue;
+
+    m_ranges.push_back(file_range{part.file(), part.file_offset(), part.size()});
+  }
+}
+
+void
+ChunkWriteback::prepare() {
+  coalesce(m_ranges);
+
+#ifdef USE_SYNC_FILE_RANGE
+  File* last_file = nullptr;
+  int   fd        = -1;
+
+  for (auto& range : m_ranges) {
+    if (range.file != last_file) {
+      last_file = range.file;
+      fd        = last_file->is_open() ? fcntl(last_file->file_descriptor(), F_DUPFD_CLOEXEC, 0) : -1;
+
+      if (fd != -1)
+        m_fds.push_back(fd);
+    }
+
+    range.fd = fd;
+  }
+#endif
+}
+
+void
+ChunkWriteback::perform() {
+  auto start = std::chrono::steady_clock::now();
+
+  auto sync_chunks = [this](bool buffered) {
+      for (auto& chunk : m_chunks) {
+        if (chunk.chunk->is_buffered() != buffered || chunk.chunk->sync(chunk.flags))
+          continue;
+
+        chunk.error = errno;
+        m_failed++;
+      }
+    };
+
+  // Buffered chunks need to be written to the page cache before the
+  // writeback of their ranges can be started.
+  sync_chunks(true);
+
+#ifdef USE_SYNC_FILE_RANGE
+  for (auto& range : m_ranges)
+    if (range.fd != -1)
+      sync_file_range(range.fd, range.offset, range.length, SYNC_FILE_RANGE_WRITE);
+#endif
+
+  sync_chunks(false);
+
+  m_latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+  instrumentation_update(INSTRUMENTATION_WRITEBACK_BATCHES, 1);
+  instrumentation_update(INSTRUMENTATION_WRITEBACK_CHUNKS, m_chunks.size());
+  instrumentation_update(INSTRUMENTATION_WRITEBACK_RANGES, m_ranges.size());
+  instrumentation_update(INSTRUMENTATION_WRITEBACK_FAILED, m_failed);
+  instrumentation_update(writeback_latency_bucket(m_latency), 1);
+}
+
+void
+ChunkWriteback::set_done() {
+  m_done.store(true, std::memory_order_release);
+  m_done.notify_all();
+}
+
+void
+ChunkWriteback::wait_done() const {
+  m_done.wait(false, std::memory_order_acquire);
+}
+
+void
+ChunkWriteback::coalesce(range_list& ranges) {
+  if (ranges.empty())
+    return;
+
+  std::sort(ranges.begin(), ranges.end(), [](const file_range& a, const file_range& b) {
+      return a.file != b.file ? std::less<File*>()(a.file, b.file) : a.offset < b.offset;
+    });
+
+  auto last = ranges.begin();
+
+  for (auto itr = std::next(ranges.begin()); itr != ranges.end(); ++itr) {
+    if (itr->file == last->file && itr->offset <= last->offset + last->length) {
+      last->length = std::max(last->length, itr->offset + itr->length - last->offset);
+      continue;
+    }
+
+    *++last = *itr;
+  }
+
+  ranges.erase(std::next(last), ranges.end());
+}
+
+void
+ChunkWriteback::close_fds() {
+  for (auto fd : m_fds)
+    ::close(fd);
+
+  m_fds.clear();
+}
+
+} // namespace torrent
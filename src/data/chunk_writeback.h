@@ -0,0 +1,97 @@
+#ifndef LIBTORRENT_DATA_CHUNK_WRITEBACK_H
+#define LIBTORRENT_DATA_CHUNK_WRITEBACK_H
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <vector>
+
+namespace torrent {
+
+class Chunk;
+class ChunkListNode;
+class File;
+
+// A batch of modified chunks synced on the disk thread, so that msync
+// with MS_SYNC doesn't stall the main thread.
+//
+// Writeback of all the files is started with sync_file_range before
+// waiting on any chunk, with contiguous ranges of the same file merged
+// so the kernel can issue large sequential writes. The chunks are then
+// msync'ed in order, which only waits for pages already under
+// writeback.
+//
+// The batch is built and completed on the main thread, which must keep
+// the chunks mapped until is_done() returns true.
+
+class ChunkWriteback {
+public:
+  struct file_range {
+    File*             file;
+    uint64_t          offset;
+    uint64_t          length;
+    int               fd{-1};
+  };
+
+  struct chunk_type {
+    ChunkListNode*    node;
+    Chunk*            chunk;
+    int               flags;
+    bool              release;
+    int               error{0};
+  };
+
+  using range_list = std::vector<file_range>;
+  using chunk_list = std::vector<chunk_type>;
+
+  ChunkWriteback(int sync_flags) : m_sync_flags(sync_flags) {}
+  ~ChunkWriteback() { close_fds(); }
+
+  bool                empty() const                           { return m_chunks.empty(); }
+  int                 sync_flags() const                      { return m_sync_flags; }
+
+  chunk_list&         chunks()                                { return m_chunks; }
+  const range_list&   ranges() const                          { return m_ranges; }
+
+  uint32_t            failed() const                          { return m_failed; }
+  auto                latency() const                         { return m_latency; }
+
+  // Main thread:
+  void                push_back(ChunkListNode* node, Chunk* chunk, int flags, bool release);
+
+  // Merges the file ranges and duplicates a file descriptor per file,
+  // as FileManager may close the files while the batch is in progress.
+  void                prepare();
+
+  // Disk thread:
+  void                perform();
+
+  bool                is_done() const                         { return m_done.load(std::memory_order_acquire); }
+  void                set_done();
+  void                wait_done() const;
+
+  // Sorts ranges by file and offset, merging those that are
+  // contiguous or overlapping.
+  static void         coalesce(range_list& ranges);
+
+private:
+  ChunkWriteback(const ChunkWriteback&) = delete;
+  ChunkWriteback& operator=(const ChunkWriteback&) = delete;
+
+  void                close_fds();
+
+  int                       m_sync_flags;
+
+  chunk_list                m_chunks;
+  range_list                m_ranges;
+  std::vector<int>          m_fds;
+
+  uint32_t                  m_failed{0};
+  std::chrono::microseconds m_latency{};
+
+  std::atomic<bool>         m_done{false};
+};
+
+} // namespace torrent
+
+#endif
@@ -0,0 +1,258 @@
+#include "config.h"
+
+#include "data/hash_cache.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "torrent/exceptions.h"
+#include "torrent/data/file.h"
+#include "torrent/data/file_list.h"
+#include "torrent/utils/log.h"
+
+#define LT_LOG(log_fmt, ...)                                            \
+  lt_log_print(LOG_STORAGE_INFO, "hash_cache: " log_fmt, __VA_ARGS__);
+
+namespace torrent {
+
+struct HashCache::header_type {
+  char                magic[8];
+  uint32_t            version;
+  uint32_t            capacity;
+  char                reserved[48];
+};
+
+struct HashCache::entry_type {
+  char                info_hash[HashString::size_data];
+  uint32_t            index;
+  uint64_t            signature;
+};
+
+namespace {
+
+constexpr char     hash_cache_magic[8] = { 'l', 't', 'h', 'c', 'a', 'c', 'h', 'e' };
+constexpr uint32_t hash_cache_version  = 1;
+
+uint64_t
+signature_mix(uint64_t hash, uint64_t value) {
+  hash ^= value + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+
+  hash ^= hash >> 30;
+  hash *= 0xbf58476d1ce4e5b9;
+  hash ^= hash >> 27;
+  hash *= 0x94d049bb133111eb;
+  hash ^= hash >> 31;
+
+  return hash;
+}
+
+uint64_t
+file_signature(const File* file) {
+  struct stat file_stat;
+
+  if (::stat(file->frozen_path().c_str(), &file_stat) != 0 || !S_ISREG(file_stat.st_mode))
+    return 0;
+
+  if (static_cast<uint64_t>(file_stat.st_size) != file->size_bytes())
+    return 0;
+
+  uint64_t signature = 0;
+  signature = signature_mix(signature, file_stat.st_dev);
+  signature = signature_mix(signature, file_stat.st_ino);
+  signature = signature_mix(signature, file_stat.st_size);
+#ifdef __APPLE__
+  signature = signature_mix(signature, file_stat.st_mtimespec.tv_sec);
+  signature = signature_mix(signature, file_stat.st_mtimespec.tv_nsec);
+#else
+  signature = signature_mix(signature, file_stat.st_mtim.tv_sec);
+  signature = signature_mix(signature, file_stat.st_mtim.tv_nsec);
+#endif
+
+  return signature != 0 ? signature : 1;
+}
+
+} // namespace
+
+void
+HashCache::open(const std::string& path, uint32_t capacity) {
+  static_assert(sizeof(header_type) == 64, "HashCache header must be 64 bytes.");
+  static_assert(sizeof(entry_type) == 32, "HashCache entry must be 32 bytes.");
+
+  if (capacity == 0 || (capacity & (capacity - 1)) != 0)
+    throw internal_error("HashCache::open(...) capacity must be a power of two.");
+
+  close();
+
+  int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+
+  if (fd == -1)
+    throw storage_error("could not open hash cache '" + path + "': " + std::strerror(errno));
+
+  size_t map_size = sizeof(header_type) + static_cast<size_t>(capacity) * sizeof(entry_type);
+
+  header_type header{};
+  bool        valid_header = ::pread(fd, &header, sizeof(header), 0) == sizeof(header) &&
+                             std::memcmp(header.magic, hash_cache_magic, sizeof(hash_cache_magic)) == 0 &&
+                             header.version == hash_cache_version &&
+                             header.capacity == capacity;
+
+  // The file is sparse, so only entries in use take up disk space.
+  if ((!valid_header && ::ftruncate(fd, 0) != 0) || ::ftruncate(fd, map_size) != 0) {
+    int err = errno;
+    ::close(fd);
+    throw storage_error("could not resize hash cache '" + path + "': " + std::strerror(err));
+  }
+
+  void* map = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  int   err = errno;
+
+  ::close(fd);
+
+  if (map == MAP_FAILED)
+    throw storage_error("could not map hash cache '" + path + "': " + std::strerror(err));
+
+  if (!valid_header) {
+    auto new_header = static_cast<header_type*>(map);
+
+    std::memcpy(new_header->magic, hash_cache_magic, sizeof(hash_cache_magic));
+    new_header->version  = hash_cache_version;
+    new_header->capacity = capacity;
+  }
+
+  m_path     = path;
+  m_capacity = capacity;
+  m_map      = map;
+  m_map_size = map_size;
+  m_entries  = reinterpret_cast<entry_type*>(static_cast<char*>(map) + sizeof(header_type));
+
+  LT_LOG("opened : path:%s capacity:%" PRIu32 " reset:%i", path.c_str(), capacity, !valid_header);
+}
+
+void
+HashCache::close() {
+  if (!is_open())
+    return;
+
+  msync(m_map, m_map_size, MS_ASYNC);
+  munmap(m_map, m_map_size);
+
+  LT_LOG("closed : path:%s", m_path.c_str());
+
+  m_path.clear();
+  m_capacity = 0;
+  m_map      = nullptr;
+  m_map_size = 0;
+  m_entries  = nullptr;
+}
+
+bool
+HashCache::contains(const HashString& info_hash, uint32_t index, uint64_t signature) const {
+  if (signature == 0)
+    return false;
+
+  auto entry = find(info_hash, index);
+
+  return entry != nullptr && entry->signature == signature;
+}
+
+void
+HashCache::insert(const HashString& info_hash, uint32_t index, uint64_t signature) {
+  if (!is_open() || signature == 0)
+    return;
+
+  auto entry = find(info_hash, index);
+
+  if (entry == nullptr) {
+    uint32_t slot = home_slot(info_hash, index);
+
+    for (uint32_t i = 0; i < max_probe; i++) {
+      auto candidate = &m_entries[(slot + i) & (m_capacity - 1)];
+
+      if (candidate->signature == 0) {
+        entry = candidate;
+        break;
+      }
+    }
+
+    if (entry == nullptr)
+      entry = &m_entries[slot];
+
+    std::memcpy(entry->info_hash, info_hash.data(), HashString::size_data);
+    entry->index = index;
+  }
+
+  entry->signature = signature;
+}
+
+void
+HashCache::erase(const HashString& info_hash, uint32_t index) {
+  auto entry = find(info_hash, index);
+
+  // Leaving the info hash in place keeps later entries in the probe
+  // sequence reachable, the slot is reused by the next insert.
+  if (entry != nullptr)
+    entry->signature = 0;
+}
+
+void
+HashCache::flush() {
+  if (is_open())
+    msync(m_map, m_map_size, MS_ASYNC);
+}
+
+std::vector<uint64_t>
+HashCache::chunk_signatures(FileList* file_list) {
+  std::vector<uint64_t> signatures(file_list->size_chunks(), 0);
+  std::vector<bool>     missing(file_list->size_chunks(), false);
+
+  for (const auto& file : *file_list) {
+    if (file->is_padding() || file->size_bytes() == 0)
+      continue;
+
+    uint64_t signature = file_signature(file.get());
+
+    for (uint32_t index = file->range_first(); index < file->range_second(); index++) {
+      if (signature == 0)
+        missing[index] = true;
+      else
+        signatures[index] = signature_mix(signatures[index], signature);
+    }
+  }
+
+  for (uint32_t index = 0; index < signatures.size(); index++)
+    if (missing[index])
+      signatures[index] = 0;
+
+  return signatures;
+}
+
+HashCache::entry_type*
+HashCache::find(const HashString& info_hash, uint32_t index) const {
+  if (!is_open())
+    return nullptr;
+
+  uint32_t slot = home_slot(info_hash, index);
+
+  for (uint32_t i = 0; i < max_probe; i++) {
+    auto entry = &m_entries[(slot + i) & (m_capacity - 1)];
+
+    if (entry->index == index && std::memcmp(entry->info_hash, info_hash.data(), HashString::size_data) == 0)
+      return entry;
+  }
+
+  return nullptr;
+}
+
+uint32_t
+HashCache::home_slot(const HashString& info_hash, uint32_t index) const {
+  uint64_t prefix;
+  std::memcpy(&prefix, info_hash.data(), sizeof(prefix));
+
+  return signature_mix(prefix, index) & (m_capacity - 1);
+}
+
+} // namespace torrent
@@ -0,0 +1,79 @@
+#ifndef LIBTORRENT_DATA_HASH_CACHE_H
+#define LIBTORRENT_DATA_HASH_CACHE_H
+
+#include <cinttypes>
+#include <string>
+#include <vector>
+
+#include "torrent/hash_string.h"
+
+namespace torrent {
+
+class FileList;
+
+// Persistent journal of verified chunks, stored in a memory mapped
+// file so it survives unclean shutdowns.
+//
+// Entries are keyed by info hash and chunk index, and hold a signature
+// of the device, inode, size and mtime of every file the chunk spans.
+// A chunk is only considered verified if the signature still matches,
+// so modifying any file invalidates all chunks touching that file.
+//
+// The table uses open addressing with a short probe sequence and
+// evicts the home slot when full, so old entries are silently lost
+// rather than ever growing the file.
+//
+// Only accessed from the main thread.
+
+class HashCache {
+public:
+  static constexpr uint32_t default_capacity = 1 << 20;
+  static constexpr uint32_t max_probe        = 8;
+
+  HashCache() = default;
+  ~HashCache() { close(); }
+
+  bool                is_open() const                         { return m_entries != nullptr; }
+
+  const std::string&  path() const                            { return m_path; }
+  uint32_t            capacity() const                        { return m_capacity; }
+
+  // Creates the file if needed, and resets it if the header does not
+  // match. Capacity must be a power of two. Throws storage_error.
+  void                open(const std::string& path, uint32_t capacity = default_capacity);
+  void                close();
+
+  bool                contains(const HashString& info_hash, uint32_t index, uint64_t signature) const;
+
+  // Zero signatures are never stored.
+  void                insert(const HashString& info_hash, uint32_t index, uint64_t signature);
+  void                erase(const HashString& info_hash, uint32_t index);
+
+  // Schedules writeback of modified entries.
+  void                flush();
+
+  // Signature of each chunk in the file list, zero if any of its files
+  // are missing.
+  static std::vector<uint64_t> chunk_signatures(FileList* file_list);
+
+private:
+  HashCache(const HashCache&) = delete;
+  HashCache& operator=(const HashCache&) = delete;
+
+  struct header_type;
+  struct entry_type;
+
+  entry_type*         find(const HashString& info_hash, uint32_t index) const;
+  uint32_t            home_slot(const HashString& info_hash, uint32_t index) const;
+
+  std::string         m_path;
+  uint32_t            m_capacity{0};
+
+  void*               m_map{nullptr};
+  size_t              m_map_size{0};
+  entry_type*         m_entries{nullptr};
+};
+
+} // namespace torrent
+
+#endif
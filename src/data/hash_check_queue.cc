@@ -2,17 +2,40 @@
 
 #include "hash_check_queue.h"
 
+#include <algorithm>
 #include <cassert>
+#include <pthread.h>
 
 #include "data/hash_chunk.h"
+#include "data/hash_io_uring.h"
 #include "torrent/hash_string.h"
 #include "torrent/system/callbacks.h"
 #include "utils/instrumentation.h"
+#include "utils/io_uring.h"
+#include "utils/sha1_batch.h"
 
 namespace torrent {
 
-HashCheckQueue::HashCheckQueue()  = default;
-HashCheckQueue::~HashCheckQueue() = default;
+namespace {
+
+instrumentation_enum
+hashing_counter(instrumentation_enum first, HashChunk::priority_enum priority) {
+  return static_cast<instrumentation_enum>(static_cast<int>(first) + static_cast<int>(priority));
+}
+
+} // namespace
+
+// Chunks spanning many small files gain little from queued reads, so
+// leave those to the mapping.
+static constexpr unsigned int hash_read_max_parts = 8;
+
+HashCheckQueue::HashCheckQueue() :
+    m_batch_lanes(sha1_batch_lanes()) {
+}
+
+HashCheckQueue::~HashCheckQueue() {
+  stop_workers();
+}
 
 // Always poke thread_disk after calling this.
 void
@@ -24,6 +47,11 @@ HashCheckQueue::push_back(HashChunk* hash_chunk) {
 
   int64_t chunk_size = hash_chunk->chunk()->chunk()->chunk_size();
 
+  // The files may be closed by the main thread while the chunk is
+  // queued, so take our own descriptors here.
+  if (m_read_depth != 0 && m_workers.empty())
+    hash_chunk->dup_part_fds(hash_read_max_parts);
+
   bool should_interrupt{};
 
   {
@@ -35,12 +63,17 @@ HashCheckQueue::push_back(HashChunk* hash_chunk) {
 
     should_interrupt = empty();
 
-    base_type::push_back(hash_chunk);
+    push_unsafe(hash_chunk);
   }
 
   instrumentation_update(INSTRUMENTATION_MEMORY_HASHING_CHUNK_COUNT, 1);
   instrumentation_update(INSTRUMENTATION_MEMORY_HASHING_CHUNK_USAGE, chunk_size);
 
+  if (!m_workers.empty()) {
+    m_workers_cond.notify_one();
+    return;
+  }
+
   if (should_interrupt)
     disk_thread::callback([this] { perform(); });
 }
@@ -65,61 +98,343 @@ HashCheckQueue::remove(HashChunk* hash_chunk) {
 
   auto guard = std::scoped_lock(m_lock);
 
-  bool result;
-  auto itr = std::find(begin(), end(), hash_chunk);
-
-  if (itr != end()) {
-    base_type::erase(itr);
-    result = true;
+  bool result = remove_unsafe(hash_chunk);
 
+  if (result) {
     int64_t size = hash_chunk->chunk()->chunk()->chunk_size();
     instrumentation_update(INSTRUMENTATION_MEMORY_HASHING_CHUNK_COUNT, -1);
     instrumentation_update(INSTRUMENTATION_MEMORY_HASHING_CHUNK_USAGE, -size);
-
-  } else {
-    result = false;
   }
 
   return result;
 }
 
+unsigned int
+HashCheckQueue::thread_count() const {
+  assert(std::this_thread::get_id() == main_thread::thread_id());
+
+  return m_workers.size();
+}
+
+// Workers are only stopped between chunks, so any chunk already being
+// hashed completes and is passed to slot_chunk_done as usual.
+void
+HashCheckQueue::set_thread_count(unsigned int count) {
+  assert(std::this_thread::get_id() == main_thread::thread_id());
+
+  if (count == m_workers.size())
+    return;
+
+  stop_workers();
+
+  {
+    auto guard = std::scoped_lock(m_lock);
+    m_workers_stopping = false;
+  }
+
+  for (unsigned int i = 0; i < count; i++)
+    m_workers.emplace_back([this] { worker_loop(); });
+
+  bool has_queued{};
+
+  {
+    auto guard = std::scoped_lock(m_lock);
+    has_queued = !empty();
+  }
+
+  if (has_queued && m_workers.empty())
+    disk_thread::callback([this] { perform(); });
+}
+
+void
+HashCheckQueue::set_batch_lanes(unsigned int lanes) {
+  if (!sha1_batch_is_supported(lanes))
+    throw internal_error("HashCheckQueue::set_batch_lanes(): lane count not supported.");
+
+  m_batch_lanes = lanes;
+}
+
+void
+HashCheckQueue::set_read_depth(unsigned int depth) {
+  if (depth != 0 && !utils::IoUring::is_supported())
+    throw internal_error("HashCheckQueue::set_read_depth(): io_uring not supported.");
+
+  m_read_depth = depth;
+}
+
 void
 HashCheckQueue::perform() {
   assert(std::this_thread::get_id() == disk_thread::thread_id());
 
-  auto get_next_fn = [this]() -> HashChunk* {
+  unsigned int read_depth = m_read_depth;
+
+  if (m_io_uring != nullptr && m_io_uring->depth() != read_depth)
+    m_io_uring.reset();
+
+  if (m_io_uring == nullptr && read_depth != 0) {
+    m_io_uring = std::make_unique<HashIoUring>(read_depth);
+
+    if (!m_io_uring->is_valid())
+      m_io_uring.reset();
+  }
+
+  if (m_io_uring != nullptr) {
+    perform_io_uring();
+    return;
+  }
+
+  std::vector<HashChunk*> batch;
+
+  while (true) {
+    {
       auto guard = std::scoped_lock(m_lock);
+      pop_batch_unsafe(batch);
+    }
 
-      if (empty())
-        return nullptr;
+    if (batch.empty())
+      break;
 
-      auto* hash_chunk = base_type::front();
-      base_type::pop_front();
+    perform_batch(batch);
+  }
+}
 
-      return hash_chunk;
+// Chunks queued before io_uring was enabled, or with too many parts,
+// have no part descriptors and are hashed directly from the mapping.
+void
+HashCheckQueue::perform_io_uring() {
+  auto slot_done = [this](HashChunk* hash_chunk, const HashString& hash) {
+      hash_chunk->close_part_fds();
+      perform_done(hash_chunk, hash);
     };
 
   while (true) {
-    auto* hash_chunk = get_next_fn();
+    while (!m_io_uring->is_full()) {
+      HashChunk* hash_chunk{};
+
+      {
+        auto guard = std::scoped_lock(m_lock);
+
+        hash_chunk = pop_unsafe();
+      }
+
+      if (hash_chunk == nullptr)
+        break;
 
-    if (hash_chunk == nullptr)
+      if (!hash_chunk->chunk()->is_loaded())
+        throw internal_error("HashCheckQueue::perform_io_uring(): !entry.node->is_loaded().");
+
+      if (hash_chunk->has_part_fds())
+        m_io_uring->push(hash_chunk);
+      else
+        perform_chunk(hash_chunk);
+    }
+
+    if (m_io_uring->is_empty())
       break;
 
-    if (!hash_chunk->chunk()->is_loaded())
-      throw internal_error("HashCheckQueue::perform(): !entry.node->is_loaded().");
+    m_io_uring->process(slot_done);
+  }
+}
+
+void
+HashCheckQueue::push_unsafe(HashChunk* hash_chunk) {
+  auto& queue = m_classes[hash_chunk->priority()];
+  auto  itr   = std::find_if(queue.begin(), queue.end(), [hash_chunk](auto& q) { return q.owner == hash_chunk->owner(); });
 
-    int64_t size = hash_chunk->chunk()->chunk()->chunk_size();
-    instrumentation_update(INSTRUMENTATION_MEMORY_HASHING_CHUNK_COUNT, -1);
-    instrumentation_update(INSTRUMENTATION_MEMORY_HASHING_CHUNK_USAGE, -size);
+  if (itr == queue.end())
+    itr = queue.insert(queue.end(), owner_queue{hash_chunk->owner(), {}});
 
-    if (!hash_chunk->perform(~uint32_t(), true))
-      throw internal_error("HashCheckQueue::perform(): !hash_chunk->perform(~uint32_t(), true).");
+  itr->chunks.push_back(hash_chunk);
+  hash_chunk->set_queued_time(std::chrono::steady_clock::now());
+
+  m_size++;
+  instrumentation_update(hashing_counter(INSTRUMENTATION_HASHING_QUEUED_DOWNLOAD, hash_chunk->priority()), 1);
+}
+
+bool
+HashCheckQueue::remove_unsafe(HashChunk* hash_chunk) {
+  auto& queue = m_classes[hash_chunk->priority()];
+  auto  itr   = std::find_if(queue.begin(), queue.end(), [hash_chunk](auto& q) { return q.owner == hash_chunk->owner(); });
 
-    HashString hash;
-    hash_chunk->hash_c(hash.data());
+  if (itr == queue.end())
+    return false;
 
-    m_slot_chunk_done(hash_chunk, hash);
+  auto chunk_itr = std::find(itr->chunks.begin(), itr->chunks.end(), hash_chunk);
+
+  if (chunk_itr == itr->chunks.end())
+    return false;
+
+  itr->chunks.erase(chunk_itr);
+
+  if (itr->chunks.empty())
+    queue.erase(itr);
+
+  m_size--;
+  instrumentation_update(hashing_counter(INSTRUMENTATION_HASHING_QUEUED_DOWNLOAD, hash_chunk->priority()), -1);
+
+  return true;
+}
+
+HashChunk*
+HashCheckQueue::pop_unsafe() {
+  for (auto& queue : m_classes) {
+    if (queue.empty())
+      continue;
+
+    auto       itr        = queue.begin();
+    HashChunk* hash_chunk = itr->chunks.front();
+
+    itr->chunks.pop_front();
+
+    if (itr->chunks.empty())
+      queue.erase(itr);
+    else
+      queue.splice(queue.end(), queue, itr);
+
+    account_started(hash_chunk);
+    return hash_chunk;
+  }
+
+  return nullptr;
+}
+
+// Takes the front chunks of the next owner in turn as long as they are
+// of the same size, which is usually a run of chunks of a single
+// torrent being checked.
+void
+HashCheckQueue::pop_batch_unsafe(std::vector<HashChunk*>& batch) {
+  batch.clear();
+
+  auto queue_itr = std::find_if(m_classes.begin(), m_classes.end(), [](auto& q) { return !q.empty(); });
+
+  if (queue_itr == m_classes.end())
+    return;
+
+  auto& queue = *queue_itr;
+  auto  itr   = queue.begin();
+
+  uint32_t chunk_size = itr->chunks.front()->chunk()->chunk()->chunk_size();
+
+  while (!itr->chunks.empty() && batch.size() < m_batch_lanes &&
+         itr->chunks.front()->chunk()->chunk()->chunk_size() == chunk_size) {
+    batch.push_back(itr->chunks.front());
+    itr->chunks.pop_front();
+
+    account_started(batch.back());
+  }
+
+  if (itr->chunks.empty())
+    queue.erase(itr);
+  else
+    queue.splice(queue.end(), queue, itr);
+}
+
+void
+HashCheckQueue::account_started(HashChunk* hash_chunk) {
+  auto wait = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - hash_chunk->queued_time());
+  auto priority = hash_chunk->priority();
+
+  m_size--;
+
+  instrumentation_update(hashing_counter(INSTRUMENTATION_HASHING_QUEUED_DOWNLOAD, priority), -1);
+  instrumentation_update(hashing_counter(INSTRUMENTATION_HASHING_STARTED_DOWNLOAD, priority), 1);
+  instrumentation_update(hashing_counter(INSTRUMENTATION_HASHING_WAIT_USEC_DOWNLOAD, priority), wait.count());
+}
+
+// Partially filled batches cost as much as full ones, so only use the
+// batch hasher when at least half the lanes are in use.
+void
+HashCheckQueue::perform_batch(std::vector<HashChunk*>& batch) {
+  if (batch.size() < 2 || batch.size() < m_batch_lanes / 2) {
+    for (auto hash_chunk : batch)
+      perform_chunk(hash_chunk);
+
+    return;
   }
+
+  std::vector<sha1_segments> messages(batch.size());
+
+  for (size_t i = 0; i < batch.size(); i++) {
+    if (!batch[i]->chunk()->is_loaded())
+      throw internal_error("HashCheckQueue::perform_batch(): !entry.node->is_loaded().");
+
+    for (auto& part : *batch[i]->chunk()->chunk())
+      messages[i].emplace_back(part.chunk().begin(), part.size());
+  }
+
+  std::vector<char> digests(batch.size() * HashString::size_data);
+
+  sha1_batch(messages.data(), batch.size(), digests.data(), m_batch_lanes);
+
+  for (size_t i = 0; i < batch.size(); i++)
+    perform_done(batch[i], *HashString::cast_from(digests.data() + i * HashString::size_data));
+}
+
+void
+HashCheckQueue::perform_chunk(HashChunk* hash_chunk) {
+  if (!hash_chunk->chunk()->is_loaded())
+    throw internal_error("HashCheckQueue::perform_chunk(): !entry.node->is_loaded().");
+
+  if (!hash_chunk->perform(~uint32_t(), true))
+    throw internal_error("HashCheckQueue::perform_chunk(): !hash_chunk->perform(~uint32_t(), true).");
+
+  HashString hash;
+  hash_chunk->hash_c(hash.data());
+
+  perform_done(hash_chunk, hash);
+}
+
+void
+HashCheckQueue::perform_done(HashChunk* hash_chunk, const HashString& hash) {
+  int64_t size = hash_chunk->chunk()->chunk()->chunk_size();
+  instrumentation_update(INSTRUMENTATION_MEMORY_HASHING_CHUNK_COUNT, -1);
+  instrumentation_update(INSTRUMENTATION_MEMORY_HASHING_CHUNK_USAGE, -size);
+
+  m_slot_chunk_done(hash_chunk, hash);
+}
+
+void
+HashCheckQueue::worker_loop() {
+#if defined(HAS_PTHREAD_SETNAME_NP_DARWIN)
+  pthread_setname_np("rtorrent-hash");
+#elif defined(HAS_PTHREAD_SETNAME_NP_GENERIC)
+  pthread_setname_np(pthread_self(), "rtorrent-hash");
+#endif
+
+  std::vector<HashChunk*> batch;
+
+  while (true) {
+    {
+      auto guard = std::unique_lock(m_lock);
+
+      m_workers_cond.wait(guard, [this] { return m_workers_stopping || !empty(); });
+
+      if (m_workers_stopping)
+        return;
+
+      pop_batch_unsafe(batch);
+    }
+
+    perform_batch(batch);
+  }
+}
+
+void
+HashCheckQueue::stop_workers() {
+  if (m_workers.empty())
+    return;
+
+  {
+    auto guard = std::scoped_lock(m_lock);
+    m_workers_stopping = true;
+  }
+
+  m_workers_cond.notify_all();
+
+  for (auto& worker : m_workers)
+    worker.join();
+
+  m_workers.clear();
 }
 
 } // namespace torrent
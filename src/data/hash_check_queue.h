@@ -1,10 +1,18 @@
 #ifndef LIBTORRENT_DATA_HASH_CHECK_QUEUE_H
 #define LIBTORRENT_DATA_HASH_CHECK_QUEUE_H
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
 #include <deque>
 #include <functional>
+#include <list>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <vector>
 
+#include "data/hash_chunk.h"
 #include "torrent/common.h"
 
 // TODO: Create separate directory for thread_disk's hash checking code.
@@ -12,37 +20,83 @@
 namespace torrent {
 
 class HashString;
-class HashChunk;
+class HashIoUring;
 
-class align_cacheline HashCheckQueue : private std::deque<HashChunk*> {
+// Chunks are taken from the highest priority class that is not empty,
+// see HashChunk::priority_enum, so verifying downloaded chunks is never
+// stuck behind a full recheck. Within a class each owner gets a turn in
+// round-robin order, taking up to a batch of chunks at a time.
+
+class align_cacheline HashCheckQueue {
 public:
-  using base_type         = std::deque<HashChunk*>;
   using slot_chunk_handle = std::function<void(HashChunk*, const HashString&)>;
 
-  using base_type::iterator;
-
-  using base_type::empty;
-  using base_type::size;
-
-  using base_type::begin;
-  using base_type::end;
-  using base_type::front;
-  using base_type::back;
-
   HashCheckQueue();
   ~HashCheckQueue();
 
   // Guarded functions for adding new...
 
+  bool                empty() const                      { return m_size == 0; }
+  size_t              size() const                       { return m_size; }
+
   void                push_back(HashChunk* node);
   void                perform();
 
   bool                remove(HashChunk* node);
 
+  // When thread count is zero the queue is drained by perform() on
+  // thread_disk, else by a pool of dedicated hashing threads.
+  unsigned int        thread_count() const;
+  void                set_thread_count(unsigned int count);
+
+  // Queued chunks of equal size are hashed together in batches of up
+  // to this many chunks, defaults to sha1_batch_lanes().
+  unsigned int        batch_lanes() const                { return m_batch_lanes; }
+  void                set_batch_lanes(unsigned int lanes);
+
+  // When non-zero and there are no hashing threads, thread_disk reads
+  // up to this many chunks in parallel with io_uring instead of
+  // faulting in the mapped chunks.
+  unsigned int        read_depth() const                 { return m_read_depth; }
+  void                set_read_depth(unsigned int depth);
+
   slot_chunk_handle&  slot_chunk_done() { return m_slot_chunk_done; }
 
 private:
-  std::mutex          m_lock;
+  struct owner_queue {
+    const void*            owner;
+    std::deque<HashChunk*> chunks;
+  };
+
+  using class_queue = std::list<owner_queue>;
+
+  void                push_unsafe(HashChunk* hash_chunk);
+  bool                remove_unsafe(HashChunk* hash_chunk);
+  HashChunk*          pop_unsafe();
+  void                pop_batch_unsafe(std::vector<HashChunk*>& batch);
+  void                account_started(HashChunk* hash_chunk);
+
+  void                perform_io_uring();
+  void                perform_batch(std::vector<HashChunk*>& batch);
+  void                perform_chunk(HashChunk* hash_chunk);
+  void                perform_done(HashChunk* hash_chunk, const HashString& hash);
+
+  void                worker_loop();
+  void                stop_workers();
+
+  std::mutex               m_lock;
+  std::array<class_queue, HashChunk::priority_size> m_classes;
+  std::atomic<size_t>      m_size{0};
+
+  std::condition_variable  m_workers_cond;
+  bool                     m_workers_stopping{false};
+  std::vector<std::thread> m_workers;
+  std::atomic<unsigned int> m_batch_lanes;
+  std::atomic<unsigned int> m_read_depth{0};
+
+  // Only accessed from thread_disk.
+  std::unique_ptr<HashIoUring> m_io_uring;
+
   slot_chunk_handle   m_slot_chunk_done;
 };
 
@@ -1,8 +1,12 @@
 #include "config.h"
 
+#include <fcntl.h>
+#include <unistd.h>
+
 #include "chunk.h"
 #include "chunk_list_node.h"
 #include "hash_chunk.h"
+#include "torrent/data/file.h"
 
 namespace torrent {
 
@@ -62,6 +66,47 @@ HashChunk::advise_willneed(uint32_t length) {
   }
 }
 
+void
+HashChunk::dup_part_fds(unsigned int max_parts) {
+  close_part_fds();
+
+  auto chunk = m_chunk.chunk();
+
+  if (std::distance(chunk->begin(), chunk->end()) > max_parts)
+    return;
+
+  bool has_fds = false;
+
+  for (auto& part : *chunk) {
+    File* file = part.file();
+
+    // Buffered parts may hold data not yet written back, so they are
+    // hashed from memory.
+    if (file == nullptr || file->is_padding() || !file->is_open() ||
+        part.mapped() == ChunkPart::MAPPED_BUFFER) {
+      m_part_fds.push_back(-1);
+      continue;
+    }
+
+    int fd = fcntl(file->file_descriptor(), F_DUPFD_CLOEXEC, 0);
+
+    m_part_fds.push_back(fd);
+    has_fds |= fd != -1;
+  }
+
+  if (!has_fds)
+    close_part_fds();
+}
+
+void
+HashChunk::close_part_fds() {
+  for (auto fd : m_part_fds)
+    if (fd != -1)
+      ::close(fd);
+
+  m_part_fds.clear();
+}
+
 uint32_t
 HashChunk::perform_part(Chunk::iterator itr, uint32_t length) {
   length = std::min(length, remaining_part(itr, m_position));
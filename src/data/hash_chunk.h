@@ -1,10 +1,14 @@
 #ifndef LIBTORRENT_HASH_CHUNK_H
 #define LIBTORRENT_HASH_CHUNK_H
 
+#include <chrono>
+#include <list>
 #include <memory>
+#include <vector>
 
 #include "chunk.h"
 #include "chunk_handle.h"
+#include "hash_queue_node.h"
 #include "torrent/exceptions.h"
 #include "utils/sha1.h"
 
@@ -18,8 +22,18 @@ class ChunkListNode;
 
 class HashChunk {
 public:
+  using queue_iterator = std::list<HashQueueNode>::iterator;
+
+  // Scheduling classes in HashCheckQueue, highest priority first.
+  enum priority_enum {
+    priority_download,
+    priority_resume,
+    priority_recheck,
+    priority_size
+  };
+
   HashChunk(ChunkHandle h);
-  ~HashChunk() = default;
+  ~HashChunk() { close_part_fds(); }
 
   ChunkHandle*        chunk()                                 { return &m_chunk; }
   ChunkHandle&        handle()                                { return m_chunk; }
@@ -34,6 +48,31 @@ public:
 
   void                advise_willneed(uint32_t length);
 
+  // Duplicated file descriptors for each chunk part, allowing the
+  // chunk to be read without touching the mapping even if FileManager
+  // closes the files. Parts without a file, e.g. padding, are -1.
+  //
+  // dup_part_fds() must be called from the main thread.
+  bool                has_part_fds() const                    { return !m_part_fds.empty(); }
+  const std::vector<int>& part_fds() const                    { return m_part_fds; }
+
+  void                dup_part_fds(unsigned int max_parts);
+  void                close_part_fds();
+
+  // Chunks of the same owner, usually the download, are scheduled
+  // round-robin against other owners of the same priority.
+  priority_enum       priority() const                        { return m_priority; }
+  const void*         owner() const                           { return m_owner; }
+  void                set_priority(priority_enum p, const void* owner) { m_priority = p; m_owner = owner; }
+
+  auto                queued_time() const                     { return m_queued_time; }
+  void                set_queued_time(std::chrono::steady_clock::time_point t) { m_queued_time = t; }
+
+  // Position of the owning node in HashQueue, only valid while the
+  // chunk is queued there.
+  queue_iterator      queue_node() const                      { return m_queue_node; }
+  void                set_queue_node(queue_iterator itr)      { m_queue_node = itr; }
+
 private:
   HashChunk(const HashChunk&) = delete;
   HashChunk& operator=(const HashChunk&) = delete;
@@ -45,6 +84,14 @@ private:
 
   ChunkHandle         m_chunk;
   Sha1                m_hash;
+
+  std::vector<int>    m_part_fds;
+  queue_iterator      m_queue_node;
+
+  priority_enum       m_priority{priority_download};
+  const void*         m_owner{nullptr};
+
+  std::chrono::steady_clock::time_point m_queued_time;
 };
 
 inline
@@ -0,0 +1,87 @@
+#include "config.h"
+
+#include "data/hash_incremental.h"
+
+#include <algorithm>
+
+#include "data/chunk.h"
+#include "torrent/exceptions.h"
+#include "torrent/data/block.h"
+#include "torrent/data/block_list.h"
+
+namespace torrent {
+
+uint32_t
+HashIncremental::position(uint32_t index) const {
+  auto itr = m_states.find(index);
+
+  if (itr == m_states.end())
+    return 0;
+
+  return itr->second->position;
+}
+
+uint32_t
+HashIncremental::finished_length(const BlockList* block_list) {
+  auto itr = std::find_if(block_list->begin(), block_list->end(), [](const Block& b) { return !b.is_finished(); });
+
+  if (itr == block_list->end())
+    return block_list->piece().length();
+
+  return itr->piece().offset();
+}
+
+void
+HashIncremental::update(uint32_t index, Chunk* chunk, uint32_t length) {
+  if (length > chunk->chunk_size())
+    throw internal_error("HashIncremental::update(...) length out of range.");
+
+  auto& state = m_states[index];
+
+  if (state == nullptr) {
+    state = std::make_unique<state_type>();
+    state->sha1.init();
+  }
+
+  hash_range(state.get(), chunk, length);
+}
+
+bool
+HashIncremental::finish(uint32_t index, Chunk* chunk, char* hash) {
+  auto itr = m_states.find(index);
+
+  if (itr == m_states.end())
+    return false;
+
+  auto state = std::move(itr->second);
+  m_states.erase(itr);
+
+  if (state->position > chunk->chunk_size())
+    throw internal_error("HashIncremental::finish(...) position out of range.");
+
+  if (chunk->chunk_size() - state->position > max_remaining)
+    return false;
+
+  hash_range(state.get(), chunk, chunk->chunk_size());
+  state->sha1.final_c(hash);
+
+  return true;
+}
+
+void
+HashIncremental::hash_range(state_type* state, Chunk* chunk, uint32_t length) {
+  while (state->position < length) {
+    auto part = chunk->at_position(state->position);
+
+    if (part == chunk->end())
+      throw internal_error("HashIncremental::hash_range(...) could not find chunk part.");
+
+    uint32_t offset = state->position - part->position();
+    uint32_t l      = std::min(part->size() - offset, length - state->position);
+
+    state->sha1.update(part->chunk().begin() + offset, l);
+    state->position += l;
+  }
+}
+
+} // namespace torrent
@@ -0,0 +1,63 @@
+#ifndef LIBTORRENT_DATA_HASH_INCREMENTAL_H
+#define LIBTORRENT_DATA_HASH_INCREMENTAL_H
+
+#include <cinttypes>
+#include <map>
+#include <memory>
+
+#include "utils/sha1.h"
+
+namespace torrent {
+
+class BlockList;
+class Chunk;
+
+// Running SHA-1 state of chunks being downloaded, fed with the leading
+// finished blocks as they complete while the data is still in the CPU
+// cache. When the last block arrives only the unhashed tail needs to
+// be read, instead of hashing the whole chunk again in HashCheckQueue.
+//
+// Blocks finished out of order are hashed once the gap before them is
+// filled. If too much is left unhashed when the chunk completes, the
+// caller falls back to the regular hash queue.
+//
+// Only accessed from the main thread.
+
+class HashIncremental {
+public:
+  static constexpr uint32_t max_remaining = 256 << 10;
+
+  bool                empty() const                           { return m_states.empty(); }
+  size_t              size() const                            { return m_states.size(); }
+
+  // Bytes hashed so far, zero if the index has no state.
+  uint32_t            position(uint32_t index) const;
+
+  // Length of the leading blocks that are all finished.
+  static uint32_t     finished_length(const BlockList* block_list);
+
+  // Hashes the chunk data from the current position up to 'length'.
+  void                update(uint32_t index, Chunk* chunk, uint32_t length);
+
+  // Hashes the rest of the chunk and writes the 20 byte digest to
+  // 'hash', unless more than max_remaining bytes are left. The state is
+  // always removed.
+  bool                finish(uint32_t index, Chunk* chunk, char* hash);
+
+  void                erase(uint32_t index)                   { m_states.erase(index); }
+  void                clear()                                 { m_states.clear(); }
+
+private:
+  struct state_type {
+    uint32_t          position{0};
+    Sha1              sha1;
+  };
+
+  static void         hash_range(state_type* state, Chunk* chunk, uint32_t length);
+
+  std::map<uint32_t, std::unique_ptr<state_type>> m_states;
+};
+
+} // namespace torrent
+
+#endif
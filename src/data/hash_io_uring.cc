@@ -0,0 +1,174 @@
+#include "config.h"
+
+#include "data/hash_io_uring.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "data/hash_chunk.h"
+#include "torrent/exceptions.h"
+#include "torrent/hash_string.h"
+
+namespace torrent {
+
+// Each chunk has at most a handful of parts, so size the rings to hold
+// a few requests per chunk in flight.
+HashIoUring::HashIoUring(unsigned int depth) :
+    m_ring(depth * 4),
+    m_slots(depth) {
+}
+
+HashIoUring::~HashIoUring() {
+  for (auto& slot : m_slots)
+    std::free(slot.buffer);
+}
+
+void
+HashIoUring::push(HashChunk* hash_chunk) {
+  if (!hash_chunk->has_part_fds())
+    throw internal_error("HashIoUring::push() chunk has no part file descriptors.");
+
+  auto slot_itr = std::find_if(m_slots.begin(), m_slots.end(), [](auto& s) { return s.hash_chunk == nullptr; });
+
+  if (slot_itr == m_slots.end())
+    throw internal_error("HashIoUring::push() no free slots.");
+
+  auto& slot = *slot_itr;
+  auto  chunk = hash_chunk->chunk()->chunk();
+
+  if (slot.buffer_size < chunk->chunk_size()) {
+    std::free(slot.buffer);
+    slot.buffer      = nullptr;
+    slot.buffer_size = 0;
+
+    void* buffer;
+
+    if (posix_memalign(&buffer, 4096, chunk->chunk_size()) != 0)
+      throw internal_error("HashIoUring::push() could not allocate read buffer.");
+
+    slot.buffer      = static_cast<char*>(buffer);
+    slot.buffer_size = chunk->chunk_size();
+  }
+
+  slot.hash_chunk  = hash_chunk;
+  slot.outstanding = 0;
+  slot.failed      = false;
+  slot.requests.clear();
+
+  auto fd_itr = hash_chunk->part_fds().begin();
+
+  for (auto& part : *chunk) {
+    int fd = *fd_itr++;
+
+    // Padding is never written to disk and buffered parts may not
+    // have been written back yet, so copy those from memory.
+    if (fd == -1) {
+      std::memcpy(slot.buffer + part.position(), part.chunk().begin(), part.size());
+      continue;
+    }
+
+    if (part.size() != 0)
+      slot.requests.push_back(request_type{fd, part.position(), part.size(), part.file_offset()});
+  }
+
+  m_active++;
+
+  uint32_t slot_index = std::distance(m_slots.begin(), slot_itr);
+
+  for (uint32_t i = 0; i < slot.requests.size(); i++)
+    m_pending.emplace_back(slot_index, i);
+
+  slot.outstanding = slot.requests.size();
+
+  submit_pending();
+}
+
+void
+HashIoUring::submit_pending() {
+  while (!m_pending.empty()) {
+    auto [slot_index, request_index] = m_pending.front();
+    auto& request = m_slots[slot_index].requests[request_index];
+
+    uint64_t user_data = (static_cast<uint64_t>(slot_index) << 32) | request_index;
+
+    if (!m_ring.prepare_read(request.fd, m_slots[slot_index].buffer + request.buffer_offset, request.length, request.file_offset, user_data))
+      break;
+
+    m_pending.pop_front();
+  }
+}
+
+void
+HashIoUring::process(const slot_chunk_handle& slot_done) {
+  // Chunks without any file backed parts complete without reads.
+  for (auto& slot : m_slots)
+    if (slot.hash_chunk != nullptr && slot.outstanding == 0)
+      complete(slot, slot_done);
+
+  if (m_active == 0)
+    return;
+
+  if (!m_ring.submit_and_wait(1))
+    throw internal_error("HashIoUring::process() io_uring_enter failed: " + std::string(std::strerror(errno)));
+
+  uint64_t user_data;
+  int32_t  result;
+
+  while (m_ring.pop_completion(&user_data, &result)) {
+    auto& slot    = m_slots.at(user_data >> 32);
+    auto& request = slot.requests.at(user_data & 0xffffffff);
+
+    if (result == -EAGAIN || result == -EINTR) {
+      m_pending.emplace_back(user_data >> 32, user_data & 0xffffffff);
+      continue;
+    }
+
+    if (result <= 0) {
+      slot.failed = true;
+
+    } else if (static_cast<uint32_t>(result) < request.length) {
+      request.buffer_offset += result;
+      request.file_offset   += result;
+      request.length        -= result;
+
+      m_pending.emplace_back(user_data >> 32, user_data & 0xffffffff);
+      continue;
+    }
+
+    if (--slot.outstanding == 0)
+      complete(slot, slot_done);
+  }
+
+  submit_pending();
+}
+
+void
+HashIoUring::complete(slot_type& slot, const slot_chunk_handle& slot_done) {
+  HashChunk* hash_chunk = slot.hash_chunk;
+  HashString hash;
+
+  if (slot.failed) {
+    // Unable to read the file, e.g. it was truncated, so let the
+    // mapping decide the outcome as it would without io_uring.
+    if (!hash_chunk->perform(~uint32_t(), true))
+      throw internal_error("HashIoUring::complete(): !hash_chunk->perform(~uint32_t(), true).");
+
+    hash_chunk->hash_c(hash.data());
+
+  } else {
+    m_sha1.init();
+    m_sha1.update(slot.buffer, hash_chunk->chunk()->chunk()->chunk_size());
+    m_sha1.final_c(hash.data());
+  }
+
+  slot.hash_chunk = nullptr;
+  slot.requests.clear();
+  m_active--;
+
+  slot_done(hash_chunk, hash);
+}
+
+} // namespace torrent
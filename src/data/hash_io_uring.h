@@ -0,0 +1,79 @@
+#ifndef LIBTORRENT_DATA_HASH_IO_URING_H
+#define LIBTORRENT_DATA_HASH_IO_URING_H
+
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include "utils/io_uring.h"
+#include "utils/sha1.h"
+
+namespace torrent {
+
+class HashChunk;
+class HashString;
+
+// Hashes chunks by reading their parts into private buffers with
+// io_uring rather than faulting in the mapping, keeping up to 'depth'
+// chunks in flight on thread_disk.
+//
+// Chunks must have part file descriptors, see
+// HashChunk::dup_part_fds(). Reads that fail fall back to hashing the
+// mapped chunk.
+
+class HashIoUring {
+public:
+  using slot_chunk_handle = std::function<void(HashChunk*, const HashString&)>;
+
+  HashIoUring(unsigned int depth);
+  ~HashIoUring();
+
+  bool                is_valid() const        { return m_ring.is_valid(); }
+  bool                is_empty() const        { return m_active == 0; }
+  bool                is_full() const         { return m_active == m_slots.size(); }
+
+  unsigned int        depth() const           { return m_slots.size(); }
+
+  void                push(HashChunk* hash_chunk);
+
+  // Waits for at least one read to complete, calling 'slot_done' for
+  // each chunk that has been fully read and hashed.
+  void                process(const slot_chunk_handle& slot_done);
+
+private:
+  HashIoUring(const HashIoUring&) = delete;
+  HashIoUring& operator=(const HashIoUring&) = delete;
+
+  struct request_type {
+    int               fd;
+    uint32_t          buffer_offset;
+    uint32_t          length;
+    uint64_t          file_offset;
+  };
+
+  struct slot_type {
+    HashChunk*        hash_chunk{};
+    char*             buffer{};
+    uint32_t          buffer_size{};
+    uint32_t          outstanding{};
+    bool              failed{};
+
+    std::vector<request_type> requests;
+  };
+
+  void                submit_pending();
+  void                complete(slot_type& slot, const slot_chunk_handle& slot_done);
+
+  utils::IoUring           m_ring;
+  std::vector<slot_type>   m_slots;
+  unsigned int             m_active{0};
+  Sha1                     m_sha1;
+
+  // Requests, as slot and request index, that did not fit in the
+  // submission queue.
+  std::deque<std::pair<uint32_t, uint32_t>> m_pending;
+};
+
+} // namespace torrent
+
+#endif
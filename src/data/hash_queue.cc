@@ -2,8 +2,10 @@
 
 #include "data/hash_queue.h"
 
+#include <algorithm>
 #include <cassert>
 #include <functional>
+#include <iterator>
 #include <utility>
 
 #include "data/hash_check_queue.h"
@@ -45,19 +47,43 @@ struct HashQueueWillneed {
 // If we're done immediately, move the chunk to the front of the list so
 // the next work cycle gets stuff done.
 void
-HashQueue::push_back(ChunkHandle handle, HashQueueNode::id_type id, slot_done_type d) {
+HashQueue::push_back(ChunkHandle handle, HashQueueNode::id_type id, slot_done_type d, HashChunk::priority_enum priority) {
   LT_LOG_DATA(id, DEBUG, "Adding index:%" PRIu32 " to queue.", handle.index());
 
   if (!handle.is_loaded())
     throw internal_error("HashQueue::add(...) received an invalid chunk");
 
   auto hash_chunk = new HashChunk(handle);
+  hash_chunk->set_priority(priority, id);
 
   base_type::push_back(HashQueueNode(id, hash_chunk, std::move(d)));
+  hash_chunk->set_queue_node(std::prev(end()));
 
   ThreadDisk::thread_disk()->hash_check_queue()->push_back(hash_chunk);
 }
 
+void
+HashQueue::push_back_hashed(ChunkHandle handle, HashQueueNode::id_type id, slot_done_type d, const HashString& hash_value) {
+  assert(std::this_thread::get_id() == main_thread::thread_id());
+
+  LT_LOG_DATA(id, DEBUG, "Adding hashed index:%" PRIu32 " to queue.", handle.index());
+
+  if (!handle.is_loaded())
+    throw internal_error("HashQueue::push_back_hashed(...) received an invalid chunk");
+
+  auto hash_chunk = new HashChunk(handle);
+
+  base_type::push_back(HashQueueNode(id, hash_chunk, std::move(d)));
+  hash_chunk->set_queue_node(std::prev(end()));
+
+  // Never call the owner from within push_back, as it may be in the
+  // middle of modifying the transfer list.
+  if (m_deferred_chunks.empty())
+    main_thread::callback([this] { work(); });
+
+  m_deferred_chunks.emplace_back(hash_chunk, hash_value);
+}
+
 bool
 HashQueue::has(HashQueueNode::id_type id) {
   return std::any_of(begin(), end(), [id](const auto& n) { return id == n.id(); });
@@ -70,11 +96,15 @@ HashQueue::has(HashQueueNode::id_type id, uint32_t index) {
 
 void
 HashQueue::remove(HashQueueNode::id_type id) {
-  base_type::erase(std::remove_if(begin(), end(), [id, this](auto& itr) {
-    if (itr.id() != id)
-      return false;
+  // Erase the nodes in place, as each HashChunk holds an iterator to
+  // its own node.
+  for (auto itr = begin(); itr != end();) {
+    if (itr->id() != id) {
+      itr++;
+      continue;
+    }
 
-    HashChunk *hash_chunk = itr.get_chunk();
+    HashChunk *hash_chunk = itr->get_chunk();
 
     LT_LOG_DATA(id, DEBUG, "Removing index:%" PRIu32 " from queue.", hash_chunk->handle().index());
 
@@ -82,28 +112,18 @@ HashQueue::remove(HashQueueNode::id_type id) {
 
     // The hash chunk was not found, so we need to wait until the hash
     // check finishes.
-    if (!result) {
-      while (true) {
-        {
-          auto lock = std::scoped_lock(m_done_chunks_lock);
+    if (!result)
+      wait_for_done_chunk(hash_chunk);
 
-          auto itr = m_done_chunks.find(hash_chunk);
+    itr->slot_done()(*hash_chunk->chunk(), NULL);
+    itr->clear();
 
-          if (itr != m_done_chunks.end()) {
-            m_done_chunks.erase(itr);
-            break;
-          }
-        }
-
-        m_has_done_chunks.wait(false);
-      }
-    }
-
-    itr.slot_done()(*hash_chunk->chunk(), NULL);
-    itr.clear();
+    itr = base_type::erase(itr);
+  }
 
-    return true;
-  }), end());
+  // Completions popped while waiting belong to other nodes.
+  if (!m_deferred_chunks.empty())
+    main_thread::callback([this] { work(); });
 }
 
 void
@@ -120,34 +140,23 @@ void
 HashQueue::work() {
   assert(std::this_thread::get_id() == main_thread::thread_id());
 
-  auto pop_next_fn = [this]() -> done_chunks_type::value_type {
-      auto guard = std::scoped_lock(m_done_chunks_lock);
-
-      if (m_done_chunks.empty()) {
-        // Only clear the flag at the to ensure no unnessary callbacks are added.
-        m_has_done_chunks = false;
-        return {nullptr, {}};
-      }
-
-      auto value = std::move(*m_done_chunks.begin());
-      m_done_chunks.erase(m_done_chunks.begin());
-
-      return value;
-    };
+  done_chunk_type done_chunk;
 
   while (true) {
-    auto [hash_chunk, hash_value] = pop_next_fn();
-
-    if (hash_chunk == nullptr)
-      break;
-
-    // TODO: This is not optimal as we jump around... Check for front
-    // of HashQueue in done_chunks instead.
+    if (!pop_done_chunk(done_chunk)) {
+      // Only clear the flag once empty to ensure no unnecessary
+      // callbacks are added, then check again for chunks pushed after
+      // the last pop but before the flag was cleared.
+      m_has_done_chunks = false;
+
+      if (!pop_done_chunk(done_chunk))
+        break;
+    }
 
-    auto itr = std::find_if(begin(), end(), [hash_chunk](auto& node) { return node.get_chunk() == hash_chunk; });
+    auto [hash_chunk, hash_value] = done_chunk;
+    auto itr = hash_chunk->queue_node();
 
-    // TODO: Fix this...
-    if (itr == end())
+    if (itr->get_chunk() != hash_chunk)
       throw internal_error("Could not find done chunk's node.");
 
     LT_LOG_DATA(itr->id(), DEBUG, "Passing index:%" PRIu32 " to owner: %s.",
@@ -163,12 +172,15 @@ HashQueue::work() {
 
 void
 HashQueue::chunk_done(HashChunk* hash_chunk, const HashString& hash_value) {
-  assert(std::this_thread::get_id() == disk_thread::thread_id());
+  // Called from either thread_disk or one of HashCheckQueue's hashing threads.
+  assert(std::this_thread::get_id() != main_thread::thread_id());
 
-  auto lock = std::scoped_lock(m_done_chunks_lock);
+  if (!m_done_chunks.try_push(done_chunk_type(hash_chunk, hash_value))) {
+    auto lock = std::scoped_lock(m_overflow_lock);
 
-  // TODO: Should we use try_emplace and check for duplicates here?
-  m_done_chunks[hash_chunk] = hash_value;
+    m_overflow_chunks.emplace_back(hash_chunk, hash_value);
+    m_has_overflow_chunks = true;
+  }
 
   bool expected = false;
 
@@ -179,4 +191,65 @@ HashQueue::chunk_done(HashChunk* hash_chunk, const HashString& hash_value) {
   }
 }
 
+bool
+HashQueue::pop_done_chunk(done_chunk_type& done_chunk) {
+  if (m_deferred_chunks.empty())
+    return pop_completed_chunk(done_chunk);
+
+  done_chunk = m_deferred_chunks.back();
+  m_deferred_chunks.pop_back();
+  return true;
+}
+
+bool
+HashQueue::pop_completed_chunk(done_chunk_type& done_chunk) {
+  if (m_done_chunks.try_pop(done_chunk))
+    return true;
+
+  if (!m_has_overflow_chunks)
+    return false;
+
+  auto lock = std::scoped_lock(m_overflow_lock);
+
+  if (m_overflow_chunks.empty()) {
+    m_has_overflow_chunks = false;
+    return false;
+  }
+
+  done_chunk = m_overflow_chunks.back();
+  m_overflow_chunks.pop_back();
+  return true;
+}
+
+// Completions for other chunks are kept in m_deferred_chunks for the
+// next call to work().
+void
+HashQueue::wait_for_done_chunk(HashChunk* hash_chunk) {
+  auto itr = std::find_if(m_deferred_chunks.begin(), m_deferred_chunks.end(), [hash_chunk](auto& c) { return c.first == hash_chunk; });
+
+  if (itr != m_deferred_chunks.end()) {
+    m_deferred_chunks.erase(itr);
+    return;
+  }
+
+  done_chunk_type done_chunk;
+
+  while (true) {
+    if (!pop_completed_chunk(done_chunk)) {
+      // Producers that see the flag cleared will notify after pushing.
+      m_has_done_chunks = false;
+
+      if (!pop_completed_chunk(done_chunk)) {
+        m_has_done_chunks.wait(false);
+        continue;
+      }
+    }
+
+    if (done_chunk.first == hash_chunk)
+      return;
+
+    m_deferred_chunks.push_back(done_chunk);
+  }
+}
+
 } // namespace torrent
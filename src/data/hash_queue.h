@@ -1,19 +1,20 @@
 #ifndef LIBTORRENT_DATA_HASH_QUEUE_H
 #define LIBTORRENT_DATA_HASH_QUEUE_H
 
-#include <condition_variable>
-#include <deque>
+#include <atomic>
 #include <functional>
-#include <map>
+#include <list>
 #include <mutex>
+#include <vector>
 
 #include "torrent/hash_string.h"
+#include "hash_chunk.h"
 #include "hash_queue_node.h"
 #include "chunk_handle.h"
+#include "utils/mpsc_ring.h"
 
 namespace torrent {
 
-class HashChunk;
 class ThreadDisk;
 
 // Calculating hash of incore memory is blindingly fast, it's always
@@ -21,11 +22,15 @@ class ThreadDisk;
 // of large resumed downloads, try to check the hash immediately. This
 // helps us in getting as much done as possible while the pages are in
 // memory.
+//
+// Hashing threads hand finished chunks back through a lock-free ring,
+// and each HashChunk keeps the position of its node so completions
+// are matched in constant time.
 
-class HashQueue : private std::deque<HashQueueNode> {
+class HashQueue : private std::list<HashQueueNode> {
 public:
-  using base_type        = std::deque<HashQueueNode>;
-  using done_chunks_type = std::map<HashChunk*, torrent::HashString>;
+  using base_type        = std::list<HashQueueNode>;
+  using done_chunk_type  = std::pair<HashChunk*, torrent::HashString>;
 
   using slot_done_type = HashQueueNode::slot_done_type;
   using slot_bool      = std::function<void(bool)>;
@@ -40,10 +45,18 @@ public:
   using base_type::front;
   using base_type::back;
 
+  static constexpr size_t done_chunks_capacity = 1024;
+
   HashQueue() = default;
   ~HashQueue() { clear(); }
 
-  void                push_back(ChunkHandle handle, HashQueueNode::id_type id, slot_done_type d);
+  void                push_back(ChunkHandle handle, HashQueueNode::id_type id, slot_done_type d,
+                                HashChunk::priority_enum priority = HashChunk::priority_download);
+
+  // Adds a chunk whose hash is already known, e.g. from incremental
+  // hashing, so the owner receives it through the same path as
+  // chunks hashed by HashCheckQueue.
+  void                push_back_hashed(ChunkHandle handle, HashQueueNode::id_type id, slot_done_type d, const HashString& hash_value);
 
   bool                has(HashQueueNode::id_type id);
   bool                has(HashQueueNode::id_type id, uint32_t index);
@@ -56,8 +69,21 @@ public:
   void                chunk_done(HashChunk* hash_chunk, const HashString& hash_value);
 
 private:
-  align_cacheline std::mutex m_done_chunks_lock;
-  done_chunks_type           m_done_chunks;
+  bool                pop_done_chunk(done_chunk_type& done_chunk);
+  bool                pop_completed_chunk(done_chunk_type& done_chunk);
+  void                wait_for_done_chunk(HashChunk* hash_chunk);
+
+  utils::MpscRing<done_chunk_type> m_done_chunks{done_chunks_capacity};
+
+  // Used only if the ring is full, so producers never wait on the main
+  // thread.
+  align_cacheline std::mutex   m_overflow_lock;
+  std::vector<done_chunk_type> m_overflow_chunks;
+  std::atomic<bool>            m_has_overflow_chunks{};
+
+  // Chunks popped by remove() while waiting for another chunk, or
+  // added by push_back_hashed(). Only accessed from the main thread.
+  std::vector<done_chunk_type> m_deferred_chunks;
 
   align_cacheline std::atomic<bool> m_has_done_chunks{};
 };
@@ -41,11 +41,21 @@
 
 namespace torrent {
 
+ChunkHandle&
+HashQueueNode::handle() {
+  return *m_chunk->chunk();
+}
+
 uint32_t
 HashQueueNode::get_index() const {
   return m_chunk->chunk()->index();
 }
 
+bool
+HashQueueNode::perform_remaining(bool force) {
+  return m_chunk->perform(m_chunk->remaining(), force);
+}
+
 void
 HashQueueNode::clear() {
   delete m_chunk;
@@ -43,11 +43,11 @@
 #include <utility>
 
 #include "chunk_handle.h"
-#include "hash_chunk.h"
 
 namespace torrent {
 
 class download_data;
+class HashChunk;
 
 class HashQueueNode {
 public:
@@ -58,14 +58,14 @@ public:
       m_id(id), m_chunk(c),  m_slot_done(std::move(d)) {}
 
   id_type             id() const                    { return m_id; }
-  ChunkHandle&        handle()                      { return *m_chunk->chunk(); }
+  ChunkHandle&        handle();
 
   uint32_t            get_index() const;
 
   HashChunk*          get_chunk() const             { return m_chunk; }
   bool                get_willneed() const          { return m_willneed; }
 
-  bool                perform_remaining(bool force) { return m_chunk->perform(m_chunk->remaining(), force); }
+  bool                perform_remaining(bool force);
 
   void                clear();
 
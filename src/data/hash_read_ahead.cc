@@ -0,0 +1,56 @@
+#include "config.h"
+
+#include "data/hash_read_ahead.h"
+
+#include <algorithm>
+
+namespace torrent {
+
+uint32_t
+HashReadAhead::window_chunks() const {
+  if (m_chunk_size == 0)
+    return 0;
+
+  return std::max<uint64_t>(m_window_bytes / m_chunk_size, 1);
+}
+
+void
+HashReadAhead::reset(uint32_t chunk_size, uint64_t max_bytes, std::chrono::microseconds now) {
+  m_position   = 0;
+  m_chunk_size = chunk_size;
+  m_max_bytes  = max_bytes;
+  m_rate       = 0;
+
+  // Start with a quarter of the maximum until the first sample is in.
+  m_window_bytes = std::clamp<uint64_t>(max_bytes / 4, std::min<uint64_t>(2 * uint64_t(chunk_size), max_bytes), max_bytes);
+
+  m_sample_bytes = 0;
+  m_sample_start = now;
+}
+
+void
+HashReadAhead::record_hashed(uint32_t bytes, std::chrono::microseconds now) {
+  if (!is_enabled())
+    return;
+
+  m_sample_bytes += bytes;
+
+  auto elapsed = now - m_sample_start;
+
+  if (elapsed < sample_interval)
+    return;
+
+  m_rate = m_sample_bytes * 1000000 / elapsed.count();
+
+  // Average with the previous window to avoid overreacting to short
+  // stalls, e.g. while waiting on the hash queue of other downloads.
+  uint64_t target = m_rate * sample_interval.count();
+  uint64_t min    = std::min<uint64_t>(2 * uint64_t(m_chunk_size), m_max_bytes);
+
+  m_window_bytes = std::clamp<uint64_t>((m_window_bytes + target) / 2, min, m_max_bytes);
+
+  m_sample_bytes = 0;
+  m_sample_start = now;
+}
+
+} // namespace torrent
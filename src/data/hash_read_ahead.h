@@ -0,0 +1,53 @@
+#ifndef LIBTORRENT_DATA_HASH_READ_AHEAD_H
+#define LIBTORRENT_DATA_HASH_READ_AHEAD_H
+
+#include <chrono>
+#include <cinttypes>
+
+namespace torrent {
+
+// Tracks how far ahead of the hash checker the files have been advised
+// with POSIX_FADV_WILLNEED, and sizes that window from the measured
+// hashing throughput.
+//
+// The window aims to cover one sample interval of hashing, so slow
+// disks keep enough requests queued to stream while fast disks don't
+// evict the page cache with data that won't be hashed for a while. It
+// is never smaller than two chunks nor larger than the configured
+// maximum.
+
+class HashReadAhead {
+public:
+  static constexpr auto sample_interval = std::chrono::seconds(1);
+
+  bool                is_enabled() const                      { return m_max_bytes != 0; }
+
+  uint32_t            position() const                        { return m_position; }
+  void                set_position(uint32_t p)                { m_position = p; }
+
+  uint64_t            max_bytes() const                       { return m_max_bytes; }
+  uint64_t            window_bytes() const                    { return m_window_bytes; }
+  uint32_t            window_chunks() const;
+
+  // Bytes hashed per second as of the last completed sample.
+  uint64_t            rate() const                            { return m_rate; }
+
+  void                reset(uint32_t chunk_size, uint64_t max_bytes, std::chrono::microseconds now);
+
+  void                record_hashed(uint32_t bytes, std::chrono::microseconds now);
+
+private:
+  uint32_t                  m_position{0};
+  uint32_t                  m_chunk_size{0};
+
+  uint64_t                  m_max_bytes{0};
+  uint64_t                  m_window_bytes{0};
+  uint64_t                  m_rate{0};
+
+  uint64_t                  m_sample_bytes{0};
+  std::chrono::microseconds m_sample_start{};
+};
+
+} // namespace torrent
+
+#endif
@@ -1,10 +1,12 @@
 #include "config.h"
 
+#include <algorithm>
 #include <cstring>
 
 #include "data/chunk_list.h"
 #include "torrent/exceptions.h"
 #include "torrent/data/download_data.h"
+#include "torrent/runtime/memory_manager.h"
 #include "torrent/system/types.h"
 #include "torrent/utils/log.h"
 
@@ -32,6 +34,10 @@ HashTorrent::start(bool try_quick) {
 
   m_error_message.clear();
   m_outstanding = 0;
+  m_partial     = m_ranges.intersect_distance(0, m_chunk_list->size()) < m_chunk_list->size();
+
+  // Quick hashing maps at most a single chunk, so skip read-ahead.
+  m_read_ahead.reset(m_chunk_list->chunk_size(), try_quick ? 0 : runtime::memory_manager()->hash_read_ahead(), this_thread::cached_time());
 
   queue(try_quick);
   return m_position == m_chunk_list->size();
@@ -83,6 +89,7 @@ HashTorrent::receive_chunkdone(uint32_t index) {
   // Make sure we call chunkdone before torrentDone has a chance to
   // trigger.
   m_outstanding--;
+  m_read_ahead.record_hashed(m_chunk_list->chunk_size(), this_thread::cached_time());
 
   queue(false);
 }
@@ -113,7 +120,7 @@ HashTorrent::queue(bool quick) {
 
   while (m_position < m_chunk_list->size()) {
     if (m_outstanding > 10 && m_outstanding * m_chunk_list->chunk_size() > (128 << 20))
-      return;
+      break;
 
     // Not very efficient, but this is seldomly done.
     auto itr = m_ranges.find(m_position);
@@ -125,6 +132,14 @@ HashTorrent::queue(bool quick) {
       m_position = itr->first;
     }
 
+    // Skip mapping chunks that the hash cache has already verified.
+    if (!quick && m_slot_check_cached && m_slot_check_cached(m_position)) {
+      LT_LOG_THIS(DEBUG, "skip cached chunk : position:%u", m_position);
+
+      m_position++;
+      continue;
+    }
+
     // Need to do increment later if we're going to support resume
     // hashing a quick hashed torrent.
     ChunkHandle handle = m_chunk_list->get(m_position, ChunkList::get_dont_log | ChunkList::get_hashing);
@@ -206,6 +221,8 @@ HashTorrent::queue(bool quick) {
     m_outstanding++;
   }
 
+  queue_read_ahead();
+
   if (m_outstanding == 0) {
     LT_LOG_THIS(INFO, "completed : position:%u", m_position);
 
@@ -215,4 +232,43 @@ HashTorrent::queue(bool quick) {
   }
 }
 
+// Advise chunks from the current position up to the read-ahead
+// window, skipping those already advised and those outside the hashing
+// ranges.
+//
+// Chunks verified by the hash cache are never read by queue(), so
+// they are passed over without counting against the window.
+void
+HashTorrent::queue_read_ahead() {
+  if (!m_read_ahead.is_enabled() || !m_slot_read_ahead)
+    return;
+
+  uint32_t position = std::max(m_read_ahead.position(), m_position);
+  uint32_t last     = std::min<uint64_t>(uint64_t(m_position) + m_read_ahead.window_chunks(), m_chunk_list->size());
+
+  while (position < last) {
+    auto itr = m_ranges.find(position);
+
+    if (itr == m_ranges.end()) {
+      position = m_chunk_list->size();
+      break;
+    }
+
+    position = std::max(position, itr->first);
+
+    if (position >= last)
+      break;
+
+    if (m_slot_check_cached && m_slot_check_cached(position)) {
+      position++;
+      last = std::min<uint64_t>(uint64_t(last) + 1, m_chunk_list->size());
+      continue;
+    }
+
+    m_slot_read_ahead(position++);
+  }
+
+  m_read_ahead.set_position(position);
+}
+
 } // namespace torrent
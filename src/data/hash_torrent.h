@@ -6,6 +6,7 @@
 #include <string>
 
 #include "data/chunk_handle.h"
+#include "data/hash_read_ahead.h"
 #include "torrent/utils/ranges.h"
 #include "torrent/utils/scheduler.h"
 
@@ -18,6 +19,8 @@ public:
   using Ranges = ranges<uint32_t>;
 
   using slot_chunk_handle = std::function<void(ChunkHandle)>;
+  using slot_chunk_index  = std::function<bool(uint32_t)>;
+  using slot_chunk_advise = std::function<void(uint32_t)>;
 
   HashTorrent(ChunkList* c);
   ~HashTorrent() { clear(); }
@@ -28,6 +31,10 @@ public:
   bool                is_checking() const                    { return m_outstanding >= 0; }
   bool                is_checked() const;
 
+  // True if only some of the chunks are being checked, e.g. the
+  // uncertain chunks of resumed downloads.
+  bool                is_partial() const                     { return m_partial; }
+
   void                confirm_checked();
 
   Ranges&             hashing_ranges()                       { return m_ranges; }
@@ -39,6 +46,18 @@ public:
 
   slot_chunk_handle&  slot_check_chunk() { return m_slot_check_chunk; }
 
+  // Returns true if the chunk is known to be valid without hashing,
+  // in which case the slot is responsible for marking it completed.
+  // Both read-ahead and queuing check a chunk, so it may be called
+  // more than once per index.
+  slot_chunk_index&   slot_check_cached() { return m_slot_check_cached; }
+
+  // Called for chunks ahead of the hash checker, within the window
+  // sized by HashReadAhead, so their data is read before being mapped.
+  slot_chunk_advise&  slot_read_ahead() { return m_slot_read_ahead; }
+
+  const HashReadAhead& read_ahead() const                    { return m_read_ahead; }
+
   auto&               delay_checked()                        { return m_delay_checked; }
   auto&               delay_retry()                          { return m_delay_retry; }
 
@@ -47,17 +66,22 @@ public:
 
 private:
   void                queue(bool quick);
+  void                queue_read_ahead();
 
   unsigned int        m_position{0};
   int                 m_outstanding{-1};
+  bool                m_partial{false};
   Ranges              m_ranges;
 
   int                 m_errno{0};
   std::string         m_error_message;
 
   ChunkList*          m_chunk_list;
+  HashReadAhead       m_read_ahead;
 
   slot_chunk_handle     m_slot_check_chunk;
+  slot_chunk_index      m_slot_check_cached;
+  slot_chunk_advise     m_slot_read_ahead;
   utils::SchedulerEntry m_delay_checked;
   utils::SchedulerEntry m_delay_retry;
 };
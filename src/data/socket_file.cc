@@ -2,6 +2,7 @@
 
 #include "data/socket_file.h"
 
+#include <cstdlib>
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/types.h>
@@ -155,4 +156,82 @@ SocketFile::create_chunk(uint64_t offset, uint32_t length, int prot, int flags)
   return MemoryChunk(ptr, ptr + align, ptr + align + length, prot, flags);
 }
 
+MemoryChunk
+SocketFile::read_chunk(uint64_t offset, uint32_t length, int prot) const {
+  if (!is_open())
+    throw internal_error("SocketFile::read_chunk() called on a closed file");
+
+  if (length == 0 || offset > size() || offset + length > size())
+    return MemoryChunk();
+
+  uint32_t page_size = MemoryChunk::page_size();
+  auto ptr = static_cast<char*>(std::aligned_alloc(page_size, (length + page_size - 1) / page_size * page_size));
+
+  if (ptr == nullptr)
+    return MemoryChunk();
+
+  for (uint32_t position = 0; position != length; ) {
+    ssize_t result = ::pread(m_fd, ptr + position, length - position, offset + position);
+
+    if (result > 0) {
+      position += result;
+      continue;
+    }
+
+    if (result == -1 && errno == EINTR)
+      continue;
+
+    // The file was truncated after the size check.
+    if (result == 0)
+      errno = EIO;
+
+    int err = errno;
+    std::free(ptr);
+    errno = err;
+
+    return MemoryChunk();
+  }
+
+  return MemoryChunk(ptr, ptr, ptr + length, prot, 0);
+}
+
+bool
+SocketFile::write_buffer(uint64_t offset, const char* buffer, uint32_t length) const {
+  if (!is_open())
+    throw internal_error("SocketFile::write_buffer() called on a closed file");
+
+  while (length != 0) {
+    ssize_t result = ::pwrite(m_fd, buffer, length, offset);
+
+    if (result == -1 && errno == EINTR)
+      continue;
+
+    if (result == 0)
+      errno = EIO;
+
+    if (result <= 0) {
+      LT_LOG_ERROR("pwrite failed : %s", std::strerror(errno));
+      return false;
+    }
+
+    buffer += result;
+    offset += result;
+    length -= result;
+  }
+
+  return true;
+}
+
+bool
+SocketFile::sync_data() const {
+  if (!is_open())
+    throw internal_error("SocketFile::sync_data() called on a closed file");
+
+#if defined(__APPLE__)
+  return ::fsync(m_fd) == 0;
+#else
+  return ::fdatasync(m_fd) == 0;
+#endif
+}
+
 } // namespace torrent
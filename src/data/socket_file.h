@@ -40,6 +40,13 @@ public:
   static MemoryChunk  create_padding_chunk(uint32_t length, int prot, int flags);
   MemoryChunk         create_chunk(uint64_t offset, uint32_t length, int prot, int flags) const;
 
+  // Reads the range into page aligned heap memory instead of mapping
+  // it, the caller must free() the returned chunk's ptr().
+  MemoryChunk         read_chunk(uint64_t offset, uint32_t length, int prot) const;
+
+  bool                write_buffer(uint64_t offset, const char* buffer, uint32_t length) const;
+  bool                sync_data() const;
+
   fd_type             fd() const                                        { return m_fd; }
 
 private:
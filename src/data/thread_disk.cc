@@ -9,6 +9,7 @@
 #include "data/hash_queue.h"
 #include "torrent/exceptions.h"
 #include "torrent/net/resolver.h"
+#include "torrent/runtime/memory_manager.h"
 #include "utils/instrumentation.h"
 
 namespace torrent {
@@ -67,6 +68,9 @@ ThreadDisk::init_thread() {
   m_hash_check_queue->slot_chunk_done() = [](auto hc, const auto& hv) {
       ThreadMain::thread_main()->hash_queue()->chunk_done(hc, hv);
     };
+
+  m_hash_check_queue->set_thread_count(runtime::memory_manager()->hash_thread_count());
+  m_hash_check_queue->set_read_depth(runtime::memory_manager()->hash_read_depth());
 }
 
 void
@@ -732,167 +732,208 @@ DhtServer::clear_transactions() {
 
 void
 DhtServer::event_read() {
+  // Each batch is processed before reading the next, as the messages
+  // refer directly to the receive buffers.
+  char         buffers[max_batch][2048];
+  sockaddr_in6 addresses[max_batch];
+  read_entry   entries[max_batch];
+
   while (true) {
-    Object request;
-    int type = '?';
-    DhtMessage message;
-    raw_string nodeIdStr;
-    const HashString* nodeId = NULL;
-    char buffer[2048];
+    for (unsigned int i = 0; i < max_batch; i++) {
+      addresses[i] = sockaddr_in6{};
+      entries[i]   = read_entry{buffers[i], sizeof(buffers[i]), reinterpret_cast<sockaddr*>(&addresses[i]), sizeof(addresses[i])};
+    }
 
-    sockaddr_in6 sa_raw{};
-    sockaddr* sa = reinterpret_cast<sockaddr*>(&sa_raw);
+    int count = read_datagrams_sa(entries, max_batch);
 
-    try {
-      int32_t read = read_datagram_sa(buffer, sizeof(buffer), sa, sizeof(sa_raw));
+    if (count <= 0)
+      break;
 
-      if (read < 0)
-        break;
+    for (int i = 0; i < count; i++)
+      process_datagram(buffers[i], entries[i].length, &addresses[i]);
 
-      // We can currently only process mapped-IPv4 addresses, not real IPv6.
-      // Translate them to an af_inet socket_address.
-      if (sa_is_v4mapped(sa)) {
-        auto sa_unmapped = sin_from_v4mapped_in6(&sa_raw);
-        *reinterpret_cast<sockaddr_in*>(&sa_raw) = *sa_unmapped.get();
-      }
+    // The socket is level triggered, so a short batch means there's no
+    // need for another read that would fail with EAGAIN.
+    if (static_cast<unsigned int>(count) < max_batch)
+      break;
+  }
 
-      if (sa->sa_family != AF_INET)
-        continue;
+  start_write();
+}
 
-      // If it's not a valid bencode dictionary at all, it's probably not a DHT
-      // packet at all, so we don't throw an error to prevent bounce loops.
-      try {
-        static_map_read_bencode(buffer, buffer + read, message);
-      } catch (const bencode_error&) {
-        continue;
-      }
+void
+DhtServer::process_datagram(char* buffer, uint32_t length, sockaddr_in6* sa_raw) {
+  int type = '?';
+  DhtMessage message;
+  raw_string nodeIdStr;
+  const HashString* nodeId = NULL;
 
-      if (!message[key_t].is_raw_string())
-        throw dht_error(dht_error_protocol, "No transaction ID");
+  sockaddr* sa = reinterpret_cast<sockaddr*>(sa_raw);
 
-      // Restrict the length of Transaction IDs. We echo them in our replies.
-      if(message[key_t].as_raw_string().size() > 20) {
-		  throw dht_error(dht_error_protocol, "Transaction ID length too long");
-      }
+  try {
+    // We can currently only process mapped-IPv4 addresses, not real IPv6.
+    // Translate them to an af_inet socket_address.
+    if (sa_is_v4mapped(sa)) {
+      auto sa_unmapped = sin_from_v4mapped_in6(sa_raw);
+      *reinterpret_cast<sockaddr_in*>(sa_raw) = *sa_unmapped.get();
+    }
 
-      if (!message[key_y].is_raw_string())
-        throw dht_error(dht_error_protocol, "No message type");
+    if (sa->sa_family != AF_INET)
+      return;
+
+    // If it's not a valid bencode dictionary at all, it's probably not a DHT
+    // packet at all, so we don't throw an error to prevent bounce loops.
+    try {
+      static_map_read_bencode(buffer, buffer + length, message);
+    } catch (const bencode_error&) {
+      return;
+    }
 
-      if (message[key_y].as_raw_string().size() != 1)
-        throw dht_error(dht_error_bad_method, "Unsupported message type");
+    if (!message[key_t].is_raw_string())
+      throw dht_error(dht_error_protocol, "No transaction ID");
 
-      type = message[key_y].as_raw_string().data()[0];
+    // Restrict the length of Transaction IDs. We echo them in our replies.
+    if(message[key_t].as_raw_string().size() > 20) {
+      throw dht_error(dht_error_protocol, "Transaction ID length too long");
+    }
 
-      // Queries and replies have node ID in different dictionaries.
-      if (type == 'r' || type == 'q') {
-        if (!message[type == 'q' ? key_a_id : key_r_id].is_raw_string())
-          throw dht_error(dht_error_protocol, "Invalid `id' value");
+    if (!message[key_y].is_raw_string())
+      throw dht_error(dht_error_protocol, "No message type");
 
-        nodeIdStr = message[type == 'q' ? key_a_id : key_r_id].as_raw_string();
+    if (message[key_y].as_raw_string().size() != 1)
+      throw dht_error(dht_error_bad_method, "Unsupported message type");
 
-        if (nodeIdStr.size() < HashString::size_data)
-          throw dht_error(dht_error_protocol, "`id' value too short");
+    type = message[key_y].as_raw_string().data()[0];
 
-        nodeId = HashString::cast_from(nodeIdStr.data());
-      }
+    // Queries and replies have node ID in different dictionaries.
+    if (type == 'r' || type == 'q') {
+      if (!message[type == 'q' ? key_a_id : key_r_id].is_raw_string())
+        throw dht_error(dht_error_protocol, "Invalid `id' value");
 
-      // Sanity check the returned transaction ID.
-      if ((type == 'r' || type == 'e') &&
-          (!message[key_t].is_raw_string() || message[key_t].as_raw_string().size() != 1))
-        throw dht_error(dht_error_protocol, "Invalid transaction ID type/length.");
+      nodeIdStr = message[type == 'q' ? key_a_id : key_r_id].as_raw_string();
 
-      // Stupid broken implementations.
-      if (nodeId != NULL && *nodeId == m_router->id())
-        throw dht_error(dht_error_protocol, "Send your own ID, not mine");
+      if (nodeIdStr.size() < HashString::size_data)
+        throw dht_error(dht_error_protocol, "`id' value too short");
 
-      switch (type) {
-        case 'q':
-          process_query(*nodeId, sa, message);
-          break;
+      nodeId = HashString::cast_from(nodeIdStr.data());
+    }
 
-        case 'r':
-          process_response(*nodeId, sa, message);
-          break;
+    // Sanity check the returned transaction ID.
+    if ((type == 'r' || type == 'e') &&
+        (!message[key_t].is_raw_string() || message[key_t].as_raw_string().size() != 1))
+      throw dht_error(dht_error_protocol, "Invalid transaction ID type/length.");
 
-        case 'e':
-          process_error(sa, message);
-          break;
+    // Stupid broken implementations.
+    if (nodeId != NULL && *nodeId == m_router->id())
+      throw dht_error(dht_error_protocol, "Send your own ID, not mine");
 
-        default:
-          throw dht_error(dht_error_bad_method, "Unknown message type.");
-      }
+    switch (type) {
+      case 'q':
+        process_query(*nodeId, sa, message);
+        break;
 
-    // If node was querying us, reply with error packet, otherwise mark the node as "query failed",
-    // so that if it repeatedly sends malformed replies we will drop it instead of propagating it
-    // to other nodes.
-    } catch (const bencode_error& e) {
-      if ((type == 'r' || type == 'e') && nodeId != NULL) {
-        m_router->node_inactive(*nodeId, sa);
-      } else {
-        snprintf(message.data_end, message.data + torrent::DhtMessage::data_size - message.data_end - 1, "Malformed packet: %s", e.what());
-        message.data[torrent::DhtMessage::data_size - 1] = '\0';
-        create_error(message, sa, dht_error_protocol, message.data_end);
-      }
+      case 'r':
+        process_response(*nodeId, sa, message);
+        break;
 
-    } catch (const dht_error& e) {
-      if ((type == 'r' || type == 'e') && nodeId != NULL)
-        m_router->node_inactive(*nodeId, sa);
-      else
-        create_error(message, sa, e.code(), e.what());
+      case 'e':
+        process_error(sa, message);
+        break;
 
-    } catch (const network_error&) {
+      default:
+        throw dht_error(dht_error_bad_method, "Unknown message type.");
     }
-  }
 
-  start_write();
+  // If node was querying us, reply with error packet, otherwise mark the node as "query failed",
+  // so that if it repeatedly sends malformed replies we will drop it instead of propagating it
+  // to other nodes.
+  } catch (const bencode_error& e) {
+    if ((type == 'r' || type == 'e') && nodeId != NULL) {
+      m_router->node_inactive(*nodeId, sa);
+    } else {
+      snprintf(message.data_end, message.data + torrent::DhtMessage::data_size - message.data_end - 1, "Malformed packet: %s", e.what());
+      message.data[torrent::DhtMessage::data_size - 1] = '\0';
+      create_error(message, sa, dht_error_protocol, message.data_end);
+    }
+
+  } catch (const dht_error& e) {
+    if ((type == 'r' || type == 'e') && nodeId != NULL)
+      m_router->node_inactive(*nodeId, sa);
+    else
+      create_error(message, sa, e.code(), e.what());
+
+  } catch (const network_error&) {
+  }
 }
 
 void
 DhtServer::process_queue(packet_queue& queue) {
-  while (!queue.empty()) {
-    auto packet = queue.front();
-    DhtTransaction::key_type transactionKey = 0;
+  std::shared_ptr<DhtTransactionPacket> packets[max_batch];
+  DhtTransaction::key_type              keys[max_batch];
+  write_entry                           entries[max_batch];
 
-    if(packet->has_transaction())
-      transactionKey = packet->transaction()->key(packet->id());
+  while (!queue.empty()) {
+    unsigned int count = 0;
 
-    // Make sure its transaction hasn't timed out yet, if it has/had one
-    // and don't bother sending non-transaction packets (replies) after
-    // more than 15 seconds in the queue.
-    if (packet->has_failed() || packet->age() > 15) {
+    while (!queue.empty() && count < max_batch) {
+      auto packet = std::move(queue.front());
       queue.pop_front();
-      continue;
-    }
 
-    queue.pop_front();
-
-    try {
-      int written = write_datagram_sa(packet->c_str(), packet->length(), packet->address());
+      // Make sure its transaction hasn't timed out yet, if it has/had one
+      // and don't bother sending non-transaction packets (replies) after
+      // more than 15 seconds in the queue.
+      if (packet->has_failed() || packet->age() > 15)
+        continue;
 
-      if (written == -1)
-        throw network_error();
+      // The transaction may be deleted by a failed write earlier in the
+      // batch, so get the key before sending.
+      keys[count]    = packet->has_transaction() ? packet->transaction()->key(packet->id()) : 0;
+      entries[count] = write_entry{packet->c_str(), static_cast<unsigned int>(packet->length()), packet->address()};
+      packets[count] = std::move(packet);
+      count++;
+    }
 
-      if (static_cast<unsigned int>(written) != packet->length())
-        throw network_error();
+    unsigned int sent = 0;
 
-    } catch (const network_error&) {
-      // Couldn't write packet, maybe something wrong with node address or routing, so mark node as bad.
-      if (packet->has_transaction()) {
-        auto itr = m_transactions.find(transactionKey);
-        if (itr == m_transactions.end())
-          throw internal_error("DhtServer::process_queue could not find transaction.");
+    while (sent < count) {
+      int written = write_datagrams_sa(entries + sent, count - sent);
 
-        failed_transaction(itr, false);
+      // Only the first datagram of the remaining batch failed, retry
+      // with the rest.
+      if (written == -1) {
+        process_written(packets[sent].get(), keys[sent], false);
+        sent++;
+        continue;
       }
-    }
 
-    if (packet->has_transaction()) {
-      // here transaction can be already deleted by failed_transaction.
-      auto itr = m_transactions.find(transactionKey);
+      for (unsigned int i = sent; i < sent + written; i++)
+        process_written(packets[i].get(), keys[i], entries[i].length == packets[i]->length());
 
-      if (itr != m_transactions.end())
-        packet->transaction()->reset_packet();
+      sent += written;
     }
+
+    for (unsigned int i = 0; i < count; i++)
+      packets[i].reset();
+  }
+}
+
+void
+DhtServer::process_written(DhtTransactionPacket* packet, DhtTransaction::key_type transactionKey, bool success) {
+  // Couldn't write packet, maybe something wrong with node address or routing, so mark node as bad.
+  if (!success && packet->has_transaction()) {
+    auto itr = m_transactions.find(transactionKey);
+    if (itr == m_transactions.end())
+      throw internal_error("DhtServer::process_queue could not find transaction.");
+
+    failed_transaction(itr, false);
+  }
+
+  if (packet->has_transaction()) {
+    // here transaction can be already deleted by failed_transaction.
+    auto itr = m_transactions.find(transactionKey);
+
+    if (itr != m_transactions.end())
+      packet->transaction()->reset_packet();
   }
 }
 
@@ -107,6 +107,7 @@ private:
 
   void                start_write();
 
+  void                process_datagram(char* buffer, uint32_t length, sockaddr_in6* sa_raw);
   void                process_query(const HashString& id, const sockaddr* sa, const DhtMessage& req);
   void                process_response(const HashString& id, const sockaddr* sa, const DhtMessage& req);
   void                process_error(const sockaddr* sa, const DhtMessage& error);
@@ -135,6 +136,7 @@ private:
   void                clear_transactions();
 
   void                process_queue(packet_queue& queue);
+  void                process_written(DhtTransactionPacket* packet, DhtTransaction::key_type transactionKey, bool success);
   void                receive_timeout();
 
   DhtRouter*          m_router{};
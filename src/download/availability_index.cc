@@ -0,0 +1,96 @@
+#include "config.h"
+
+#include "download/availability_index.h"
+
+#include "torrent/exceptions.h"
+
+namespace torrent {
+
+void
+AvailabilityIndex::initialize(uint32_t size) {
+  if (!empty())
+    throw internal_error("AvailabilityIndex::initialize(...) called on an initialized object.");
+
+  m_availability.assign(size, 0);
+  m_slots.assign(size, invalid_index);
+}
+
+void
+AvailabilityIndex::clear() {
+  m_availability.clear();
+  m_slots.clear();
+  m_buckets.clear();
+  m_size_tracked = 0;
+}
+
+void
+AvailabilityIndex::insert(uint32_t index) {
+  if (is_tracked(index))
+    throw internal_error("AvailabilityIndex::insert(...) index already tracked.");
+
+  bucket_insert(index);
+  m_size_tracked++;
+}
+
+void
+AvailabilityIndex::erase(uint32_t index) {
+  if (!is_tracked(index))
+    throw internal_error("AvailabilityIndex::erase(...) index not tracked.");
+
+  bucket_erase(index);
+  m_size_tracked--;
+}
+
+uint32_t
+AvailabilityIndex::increment(uint32_t index) {
+  if (!is_tracked(index))
+    return ++m_availability[index];
+
+  bucket_erase(index);
+  m_availability[index]++;
+  bucket_insert(index);
+
+  return m_availability[index];
+}
+
+uint32_t
+AvailabilityIndex::decrement(uint32_t index) {
+  if (m_availability[index] == 0)
+    throw internal_error("AvailabilityIndex::decrement(...) availability is already zero.");
+
+  if (!is_tracked(index))
+    return --m_availability[index];
+
+  bucket_erase(index);
+  m_availability[index]--;
+  bucket_insert(index);
+
+  return m_availability[index];
+}
+
+void
+AvailabilityIndex::bucket_insert(uint32_t index) {
+  uint32_t availability = m_availability[index];
+
+  if (availability >= m_buckets.size())
+    m_buckets.resize(availability + 1);
+
+  auto& bucket = m_buckets[availability];
+
+  m_slots[index] = bucket.size();
+  bucket.push_back(index);
+}
+
+void
+AvailabilityIndex::bucket_erase(uint32_t index) {
+  auto& bucket = m_buckets[m_availability[index]];
+  uint32_t slot = m_slots[index];
+
+  bucket[slot] = bucket.back();
+  m_slots[bucket[slot]] = slot;
+
+  bucket.pop_back();
+  m_slots[index] = invalid_index;
+}
+
+} // namespace torrent
@@ -0,0 +1,107 @@
+#ifndef LIBTORRENT_DOWNLOAD_AVAILABILITY_INDEX_H
+#define LIBTORRENT_DOWNLOAD_AVAILABILITY_INDEX_H
+
+#include <algorithm>
+#include <cinttypes>
+#include <vector>
+
+namespace torrent {
+
+// Keeps the tracked chunks bucketed by the number of peers that have
+// them, so the rarest chunks can be found without scanning bitfields.
+//
+// Availability is counted for all chunks, while only tracked chunks,
+// i.e. those not yet downloaded or in progress, are kept in buckets.
+// All updates are constant time.
+
+class AvailabilityIndex {
+public:
+  static constexpr uint32_t invalid_index = ~uint32_t{0};
+
+  bool                empty() const                         { return m_availability.empty(); }
+  uint32_t            size() const                          { return m_availability.size(); }
+  uint32_t            size_tracked() const                  { return m_size_tracked; }
+
+  void                initialize(uint32_t size);
+  void                clear();
+
+  uint32_t            availability(uint32_t index) const    { return m_availability[index]; }
+  bool                is_tracked(uint32_t index) const      { return m_slots[index] != invalid_index; }
+
+  void                insert(uint32_t index);
+  void                erase(uint32_t index);
+
+  // Returns the new availability.
+  uint32_t            increment(uint32_t index);
+  uint32_t            decrement(uint32_t index);
+
+  // Returns the first tracked chunk accepted by 'func' in order of
+  // increasing availability, skipping buckets below 'min_availability'.
+  // Each bucket is searched starting from 'seed' modulo its size, so
+  // that peers with the same chunks do not all pick the same one.
+  //
+  // Every chunk rejected by 'func' uses up one of '*budget', and the
+  // search gives up when it reaches zero. Callers check '*budget' to
+  // tell that apart from there being no such chunk.
+  template <typename Func>
+  uint32_t            find_rarest(uint32_t seed, uint32_t min_availability, uint32_t* budget, Func func) const;
+
+  template <typename Func>
+  uint32_t            find_rarest(uint32_t seed, uint32_t min_availability, Func func) const;
+
+private:
+  void                bucket_insert(uint32_t index);
+  void                bucket_erase(uint32_t index);
+
+  std::vector<uint32_t>              m_availability;
+  std::vector<uint32_t>              m_slots;
+  std::vector<std::vector<uint32_t>> m_buckets;
+
+  uint32_t                           m_size_tracked{0};
+};
+
+template <typename Func>
+uint32_t
+AvailabilityIndex::find_rarest(uint32_t seed, uint32_t min_availability, uint32_t* budget, Func func) const {
+  auto accept = [budget, &func](uint32_t index) {
+      if (func(index))
+        return true;
+
+      (*budget)--;
+      return false;
+    };
+
+  for (auto first = m_buckets.begin() + std::min<size_t>(min_availability, m_buckets.size()); first != m_buckets.end(); ++first) {
+    const auto& bucket = *first;
+
+    if (bucket.empty())
+      continue;
+
+    auto start = seed % bucket.size();
+
+    for (auto itr = bucket.begin() + start; itr != bucket.end() && *budget != 0; ++itr)
+      if (accept(*itr))
+        return *itr;
+
+    for (auto itr = bucket.begin(), last = bucket.begin() + start; itr != last && *budget != 0; ++itr)
+      if (accept(*itr))
+        return *itr;
+
+    if (*budget == 0)
+      break;
+  }
+
+  return invalid_index;
+}
+
+template <typename Func>
+uint32_t
+AvailabilityIndex::find_rarest(uint32_t seed, uint32_t min_availability, Func func) const {
+  uint32_t budget = ~uint32_t{0};
+
+  return find_rarest(seed, min_availability, &budget, func);
+}
+
+} // namespace torrent
+
+#endif
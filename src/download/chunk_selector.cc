@@ -8,9 +8,14 @@
 #include "download/chunk_statistics.h"
 #include "protocol/peer_chunks.h"
 #include "torrent/exceptions.h"
+#include "utils/bitfield_ops.h"
 
 namespace torrent {
 
+// Number of chunks the peer lacks that find_rarest() may walk past in
+// the availability index before switching to search_rarest().
+static constexpr uint32_t rarest_max_misses = 1024;
+
 // Consider making statistics a part of selector.
 void
 ChunkSelector::initialize(ChunkStatistics* cs) {
@@ -27,12 +32,29 @@ ChunkSelector::initialize(ChunkStatistics* cs) {
 
   m_sharedQueue.enable(32);
   m_sharedQueue.clear();
+
+  update_availability_index();
 }
 
 void
 ChunkSelector::cleanup() {
   m_data->mutable_untouched_bitfield()->clear();
   m_statistics = NULL;
+
+  clear_deadlines();
+}
+
+void
+ChunkSelector::set_picker(picker_enum t) {
+  if (t >= PICKER_MAX_SIZE)
+    throw internal_error("ChunkSelector::set_picker(...) received an invalid picker.");
+
+  if (t == PICKER_RAREST_FIRST && m_statistics != NULL && m_statistics->availability_index() == NULL)
+    throw internal_error("ChunkSelector::set_picker(...) availability index not enabled.");
+
+  m_picker = t;
+
+  update_availability_index();
 }
 
 // Consider if ChunksSelector::not_using_index(...) needs to be
@@ -56,6 +78,9 @@ ChunkSelector::find(PeerChunks* pc, [[maybe_unused]] bool highPriority) {
   if (m_position == invalid_chunk)
     return invalid_chunk;
 
+  if (m_picker == PICKER_RAREST_FIRST)
+    return find_rarest(pc);
+
   // When we're a seeder, 'm_sharedQueue' is used. Since the peer's
   // bitfield is guaranteed to be filled we can use the same code as
   // for non-seeders. This generalization does incur a slight
@@ -77,7 +102,7 @@ ChunkSelector::find(PeerChunks* pc, [[maybe_unused]] bool highPriority) {
     while (queue->prepare_pop()) {
       uint32_t pos = queue->pop();
 
-      if (!m_data->untouched_bitfield()->get(pos))
+      if (!m_data->untouched_bitfield()->get(pos) || is_deadline_reserved(pos))
         continue;
 
       return pos;
@@ -118,6 +143,57 @@ ChunkSelector::find(PeerChunks* pc, [[maybe_unused]] bool highPriority) {
   return pos;
 }
 
+uint32_t
+ChunkSelector::find_deadline(PeerChunks* pc) {
+  if (m_picker != PICKER_DEADLINE)
+    return invalid_chunk;
+
+  for (const auto& [deadline, index] : m_deadline_queue) {
+    if (m_data->untouched_bitfield()->get(index) && pc->bitfield()->get(index) && is_wanted(index))
+      return index;
+  }
+
+  return invalid_chunk;
+}
+
+std::chrono::microseconds
+ChunkSelector::deadline(uint32_t index) const {
+  auto itr = m_deadlines.find(index);
+
+  return itr != m_deadlines.end() ? itr->second : std::chrono::microseconds{};
+}
+
+void
+ChunkSelector::set_deadline(uint32_t index, std::chrono::microseconds t) {
+  if (index >= size())
+    throw internal_error("ChunkSelector::set_deadline(...) index out of range.");
+
+  erase_deadline(index);
+
+  if (t == std::chrono::microseconds{} || m_data->completed_bitfield()->get(index))
+    return;
+
+  m_deadlines.emplace(index, t);
+  m_deadline_queue.emplace(t, index);
+}
+
+void
+ChunkSelector::erase_deadline(uint32_t index) {
+  auto itr = m_deadlines.find(index);
+
+  if (itr == m_deadlines.end())
+    return;
+
+  m_deadline_queue.erase(std::make_pair(itr->second, index));
+  m_deadlines.erase(itr);
+}
+
+void
+ChunkSelector::clear_deadlines() {
+  m_deadlines.clear();
+  m_deadline_queue.clear();
+}
+
 bool
 ChunkSelector::is_wanted(uint32_t index) const {
   return m_data->untouched_bitfield()->get(index) && (m_data->normal_priority()->has(index) || m_data->high_priority()->has(index));
@@ -133,6 +209,9 @@ ChunkSelector::using_index(uint32_t index) {
 
   m_data->mutable_untouched_bitfield()->unset(index);
 
+  if (auto index_list = m_statistics->availability_index(); index_list != NULL)
+    index_list->erase(index);
+
   // We always know 'm_position' points to a wanted chunk. If it
   // changes, we need to move m_position to the next one.
   if (index == m_position)
@@ -149,6 +228,9 @@ ChunkSelector::not_using_index(uint32_t index) {
 
   m_data->mutable_untouched_bitfield()->set(index);
 
+  if (auto index_list = m_statistics->availability_index(); index_list != NULL)
+    index_list->insert(index);
+
   // This will make sure that if we enable new chunks, it will start
   // downloading them event when 'index == invalid_chunk'.
   if (m_position == invalid_chunk)
@@ -171,7 +253,7 @@ ChunkSelector::received_have_chunk(PeerChunks* pc, uint32_t index) {
   if (!m_data->high_priority()->has(index) && !m_data->normal_priority()->has(index))
     return false;
 
-  if (pc->download_cache()->is_enabled())
+  if (m_picker == PICKER_DEFAULT && pc->download_cache()->is_enabled())
     pc->download_cache()->insert(m_statistics->rarity(index), index);
 
   return true;
@@ -199,40 +281,142 @@ ChunkSelector::search_linear_range(const Bitfield* bf, utils::PartialQueue* pq,
   if (first >= last || last > size())
     throw internal_error("ChunkSelector::search_linear_range(...) received an invalid range.");
 
-  auto local  = m_data->untouched_bitfield()->begin() + first / 8;
-  auto source = bf->begin() + first / 8;
+  auto source = bf->begin();
+  auto local  = m_data->untouched_bitfield()->begin();
 
-  // Unset any bits before 'first'.
-  Bitfield::value_type wanted = (*source & *local) & Bitfield::mask_from(first % 8);
+  for (uint32_t index = bitfield_find_next(source, local, first, last);
+       index != last;
+       index = bitfield_find_next(source, local, index + 1, last)) {
+
+    if (is_deadline_reserved(index))
+      continue;
 
-  while (m_data->untouched_bitfield()->position(local + 1) < last) {
-    if (wanted && !search_linear_byte(pq, m_data->untouched_bitfield()->position(local), wanted))
+    if (!pq->insert(m_statistics->rarity(index), index) && pq->is_full())
       return false;
+  }
+
+  return true;
+}
 
-    wanted = (*++source & *++local);
+// Picks the rarest untouched chunk the peer has, preferring high
+// priority chunks. The random seed spreads peers over chunks of equal
+// availability.
+//
+// Chunks a counted peer has are in the index with an availability of
+// at least one, so those peers never need to search the first bucket.
+//
+// Walking the buckets costs a bitfield lookup for every chunk the
+// peer lacks, so with a sparse peer bitfield it degrades to a scan of
+// all tracked chunks. After 'rarest_max_misses' rejected chunks the
+// search falls back to search_rarest(), which skips a word at a time.
+uint32_t
+ChunkSelector::find_rarest(PeerChunks* pc) {
+  auto index_list = m_statistics->availability_index();
+  auto bitfield   = pc->bitfield();
+  auto seed       = static_cast<uint32_t>(random());
+  auto first      = (pc->using_counter() && !pc->is_seeder()) ? 1 : 0;
+  auto budget     = rarest_max_misses;
+
+  uint32_t pos = AvailabilityIndex::invalid_index;
+
+  if (!m_data->high_priority()->empty()) {
+    pos = index_list->find_rarest(seed, first, &budget, [this, bitfield](uint32_t index) {
+        return bitfield->get(index) && m_data->high_priority()->has(index);
+      });
+
+    if (budget == 0)
+      pos = search_rarest(bitfield, m_data->high_priority(), seed, first);
   }
 
-  // Unset any bits from 'last'.
-  wanted &= Bitfield::mask_before(last - m_data->untouched_bitfield()->position(local));
+  if (pos == AvailabilityIndex::invalid_index && !m_data->normal_priority()->empty()) {
+    if (budget != 0)
+      pos = index_list->find_rarest(seed, first, &budget, [this, bitfield](uint32_t index) {
+          return bitfield->get(index) && m_data->normal_priority()->has(index);
+        });
+
+    if (budget == 0)
+      pos = search_rarest(bitfield, m_data->normal_priority(), seed, first);
+  }
+
+  if (pos == AvailabilityIndex::invalid_index)
+    return invalid_chunk;
 
-  if (wanted)
-    return search_linear_byte(pq, m_data->untouched_bitfield()->position(local), wanted);
-  else
-    return true;
+  if (!m_data->untouched_bitfield()->get(pos))
+    throw internal_error("ChunkSelector::find_rarest(...) bad index.");
+
+  return pos;
 }
 
-// Take pointer to partial_queue
-inline bool
-ChunkSelector::search_linear_byte(utils::PartialQueue* pq, uint32_t index, Bitfield::value_type wanted) {
-  for (int i = 0; i < 8; ++i) {
-    if (!(wanted & Bitfield::mask_at(i)))
-      continue;
+// Returns the untouched chunk with the lowest availability among those
+// the peer has in 'ranges', starting from 'seed' modulo the size so
+// ties are spread like in find_rarest(). Stops early at an
+// availability of 'min_availability'.
+uint32_t
+ChunkSelector::search_rarest(const Bitfield* bf, const download_data::priority_ranges* ranges, uint32_t seed, uint32_t min_availability) {
+  auto index_list = m_statistics->availability_index();
+  auto source     = bf->begin();
+  auto local      = m_data->untouched_bitfield()->begin();
+  auto start      = seed % size();
+
+  uint32_t pos          = AvailabilityIndex::invalid_index;
+  uint32_t availability = ~uint32_t{0};
+
+  auto search_range = [&](uint32_t first, uint32_t last) {
+      for (auto itr = ranges->find(first); itr != ranges->end() && itr->first < last; ++itr) {
+        uint32_t range_last = std::min(last, itr->second);
+
+        for (uint32_t index = bitfield_find_next(source, local, std::max(first, itr->first), range_last);
+             index != range_last;
+             index = bitfield_find_next(source, local, index + 1, range_last)) {
+
+          if (index_list->availability(index) >= availability)
+            continue;
+
+          pos          = index;
+          availability = index_list->availability(index);
+
+          if (availability <= min_availability)
+            return true;
+        }
+      }
 
-    if (!pq->insert(m_statistics->rarity(index + i), index + i) && pq->is_full())
       return false;
-  }
+    };
 
-  return true;
+  search_range(start, size()) || search_range(0, start);
+
+  return pos;
+}
+
+// Chunks with a deadline are left to find_deadline(), so that only
+// peers Delegator considers fast enough are given them.
+bool
+ChunkSelector::is_deadline_reserved(uint32_t index) const {
+  return m_picker == PICKER_DEADLINE && m_deadlines.find(index) != m_deadlines.end();
+}
+
+// Makes the tracked chunks of the availability index match the
+// untouched bitfield.
+void
+ChunkSelector::update_availability_index() {
+  if (m_statistics == NULL || m_statistics->availability_index() == NULL)
+    return;
+
+  auto index_list = m_statistics->availability_index();
+  auto untouched  = m_data->untouched_bitfield();
+
+  if (index_list->size() != untouched->size_bits())
+    return;
+
+  for (uint32_t index = 0; index < index_list->size(); index++) {
+    if (untouched->get(index) == index_list->is_tracked(index))
+      continue;
+
+    if (untouched->get(index))
+      index_list->insert(index);
+    else
+      index_list->erase(index);
+  }
 }
 
 // First untouched index in [first, last) that lies in priority ranges.
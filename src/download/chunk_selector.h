@@ -1,10 +1,14 @@
 #ifndef LIBTORRENT_DOWNLOAD_CHUNK_SELECTOR_H
 #define LIBTORRENT_DOWNLOAD_CHUNK_SELECTOR_H
 
+#include <chrono>
 #include <cinttypes>
+#include <map>
+#include <set>
 
 #include "torrent/bitfield.h"
 #include "torrent/data/download_data.h"
+#include "torrent/download/types.h"
 #include "torrent/utils/ranges.h"
 #include "utils/partial_queue.h"
 
@@ -17,12 +21,22 @@ namespace torrent {
 //
 // When updating Content::bitfield, make sure you update this bitfield
 // and unmark any chunks in Delegator.
+//
+// With PICKER_RAREST_FIRST the untouched chunks are kept in the
+// statistics' availability index, and find() picks the rarest chunk
+// the peer has instead of searching from the current position.
+//
+// With PICKER_DEADLINE chunks may be given a deadline, and those are
+// only handed out by find_deadline() in order of the earliest
+// deadline. Delegator decides which peers are fast enough for them.
 
 class ChunkStatistics;
 class PeerChunks;
 
 class ChunkSelector {
 public:
+  using deadline_map = std::map<uint32_t, std::chrono::microseconds>;
+
   static constexpr auto invalid_chunk = ~uint32_t{0};
 
   ChunkSelector(download_data* data) : m_data(data) {}
@@ -40,6 +54,11 @@ public:
   void                initialize(ChunkStatistics* cs);
   void                cleanup();
 
+  // The statistics' availability index must be enabled before
+  // setting PICKER_RAREST_FIRST.
+  picker_enum         picker() const                { return m_picker; }
+  void                set_picker(picker_enum t);
+
   // Call this once you've modified the bitfield or priorities to
   // update cached information. This must be called once before using
   // find.
@@ -47,6 +66,20 @@ public:
 
   uint32_t            find(PeerChunks* pc, bool highPriority);
 
+  // Returns the untouched chunk the peer has with the earliest
+  // deadline, or invalid_chunk.
+  uint32_t            find_deadline(PeerChunks* pc);
+
+  // Deadlines are absolute times in the same clock as
+  // this_thread::cached_time(), zero meaning none. Completed chunks
+  // have their deadline removed.
+  const deadline_map& deadlines() const             { return m_deadlines; }
+
+  std::chrono::microseconds deadline(uint32_t index) const;
+  void                set_deadline(uint32_t index, std::chrono::microseconds t);
+  void                erase_deadline(uint32_t index);
+  void                clear_deadlines();
+
   bool                is_wanted(uint32_t index) const;
 
   // Call this to set the index as being downloaded, finished etc,
@@ -67,21 +100,29 @@ public:
 private:
   bool                search_linear(const Bitfield* bf, utils::PartialQueue* pq, const download_data::priority_ranges* ranges, uint32_t first, uint32_t last);
   inline bool         search_linear_range(const Bitfield* bf, utils::PartialQueue* pq, uint32_t first, uint32_t last);
-  inline bool         search_linear_byte(utils::PartialQueue* pq, uint32_t index, Bitfield::value_type wanted);
 
 //   inline uint32_t     search_rarest(const Bitfield* bf, priority_ranges* ranges, uint32_t first, uint32_t last);
 //   inline uint32_t     search_rarest_range(const Bitfield* bf, uint32_t first, uint32_t last);
 //   inline uint32_t     search_rarest_byte(uint8_t wanted);
 
+  uint32_t            find_rarest(PeerChunks* pc);
+  uint32_t            search_rarest(const Bitfield* bf, const download_data::priority_ranges* ranges, uint32_t seed, uint32_t min_availability);
+  bool                is_deadline_reserved(uint32_t index) const;
+  void                update_availability_index();
+
   void                advance_position();
 
   download_data*      m_data;
 
-  ChunkStatistics*    m_statistics;
+  ChunkStatistics*    m_statistics{};
 
   utils::PartialQueue m_sharedQueue;
 
-  uint32_t            m_position;
+  uint32_t            m_position{invalid_chunk};
+  picker_enum         m_picker{PICKER_DEFAULT};
+
+  deadline_map        m_deadlines;
+  std::set<std::pair<std::chrono::microseconds, uint32_t>> m_deadline_queue;
 };
 
 } // namespace torrent
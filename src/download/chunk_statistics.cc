@@ -39,6 +39,7 @@
 #include "torrent/exceptions.h"
 
 #include "protocol/peer_chunks.h"
+#include "utils/bitfield_ops.h"
 
 #include "chunk_statistics.h"
 
@@ -48,7 +49,29 @@ namespace torrent {
 
 inline bool
 ChunkStatistics::should_add(PeerChunks* pc) const {
-  return m_accounted < max_accounted;
+  return m_availability != nullptr || m_accounted < max_accounted;
+}
+
+inline void
+ChunkStatistics::add_chunk(size_type index) {
+  if (m_availability == nullptr) {
+    base_type::operator[](index)++;
+    return;
+  }
+
+  auto availability = m_availability->increment(index);
+  base_type::operator[](index) = std::min<size_type>(availability, max_accounted);
+}
+
+inline void
+ChunkStatistics::remove_chunk(size_type index) {
+  if (m_availability == nullptr) {
+    base_type::operator[](index)--;
+    return;
+  }
+
+  auto availability = m_availability->decrement(index);
+  base_type::operator[](index) = std::min<size_type>(availability, max_accounted);
 }
 
 void
@@ -57,6 +80,9 @@ ChunkStatistics::initialize(size_type s) {
     throw internal_error("ChunkStatistics::initialize(...) called on an initialized object.");
 
   base_type::resize(s);
+
+  if (m_availability != nullptr)
+    m_availability->initialize(s);
 }
 
 void
@@ -65,6 +91,28 @@ ChunkStatistics::clear() {
     throw internal_error("ChunkStatistics::clear() m_complete != 0.");
 
   base_type::clear();
+
+  if (m_availability != nullptr)
+    m_availability->clear();
+}
+
+void
+ChunkStatistics::set_availability_index(bool enabled) {
+  if (enabled == (m_availability != nullptr))
+    return;
+
+  if (m_accounted != 0 || m_complete != 0)
+    throw internal_error("ChunkStatistics::set_availability_index(...) called with accounted peers.");
+
+  if (!enabled) {
+    m_availability.reset();
+    return;
+  }
+
+  m_availability = std::make_unique<AvailabilityIndex>();
+
+  if (!empty())
+    m_availability->initialize(size());
 }
 
 void
@@ -82,11 +130,18 @@ ChunkStatistics::received_connect(PeerChunks* pc) {
     pc->set_using_counter(true);
     m_accounted++;
 
-    auto itr = base_type::begin();
+    auto bitfield = pc->bitfield();
 
-    // Use a bitfield iterator instead.
-    for (Bitfield::size_type index = 0; index < pc->bitfield()->size_bits(); ++index, ++itr)
-      *itr += pc->bitfield()->get(index);
+    if (m_availability != nullptr) {
+      for (auto index = bitfield->find_first_set(0, bitfield->size_bits());
+           index != bitfield->size_bits();
+           index = bitfield->find_first_set(index + 1, bitfield->size_bits()))
+        add_chunk(index);
+
+      return;
+    }
+
+    bitfield_increment_counters(base_type::data(), bitfield->begin(), bitfield->size_bits());
   }
 }
 
@@ -110,11 +165,18 @@ ChunkStatistics::received_disconnect(PeerChunks* pc) {
 
     m_accounted--;
 
-    auto itr = base_type::begin();
+    auto bitfield = pc->bitfield();
+
+    if (m_availability != nullptr) {
+      for (auto index = bitfield->find_first_set(0, bitfield->size_bits());
+           index != bitfield->size_bits();
+           index = bitfield->find_first_set(index + 1, bitfield->size_bits()))
+        remove_chunk(index);
 
-    // Use a bitfield iterator instead.
-    for (Bitfield::size_type index = 0; index < pc->bitfield()->size_bits(); ++index, ++itr)
-      *itr -= pc->bitfield()->get(index);
+      return;
+    }
+
+    bitfield_decrement_counters(base_type::data(), bitfield->begin(), bitfield->size_bits());
   }
 }
 
@@ -137,7 +199,7 @@ ChunkStatistics::received_have_chunk(PeerChunks* pc, uint32_t index, uint32_t le
   
   if (pc->using_counter()) {
 
-    base_type::operator[](index)++;
+    add_chunk(index);
 
     // The below code should not cause useless work to be done in case
     // of immediate disconnect.
@@ -148,7 +210,12 @@ ChunkStatistics::received_have_chunk(PeerChunks* pc, uint32_t index, uint32_t le
       m_complete++;
       m_accounted--;
 
-      std::transform(base_type::begin(), base_type::end(), base_type::begin(), [] (auto c) { return c - 1; });
+      if (m_availability != nullptr) {
+        for (size_type i = 0; i < size(); i++)
+          remove_chunk(i);
+      } else {
+        std::transform(base_type::begin(), base_type::end(), base_type::begin(), [] (auto c) { return c - 1; });
+      }
     }
 
   } else {
@@ -38,8 +38,11 @@
 #define LIBTORRENT_DOWNLOAD_CHUNK_STATISTICS_H
 
 #include <cinttypes>
+#include <memory>
 #include <vector>
 
+#include "download/availability_index.h"
+
 namespace torrent {
 
 class PeerChunks;
@@ -76,6 +79,12 @@ public:
   void                initialize(size_type s);
   void                clear();
 
+  // The availability index counts every peer, without the
+  // 'max_accounted' limit, in which case 'rarity()' saturates. It may
+  // only be toggled while no peers are accounted.
+  AvailabilityIndex*  availability_index()          { return m_availability.get(); }
+  void                set_availability_index(bool enabled);
+
   // When a peer connects and sends a non-empty bitfield and is not a
   // seeder, we can be fairly sure it won't just disconnect
   // immediately. Thus it should be resonable to possibly spend the
@@ -104,8 +113,14 @@ public:
 
 private:
   inline bool         should_add(PeerChunks* pc) const;
+
+  inline void         add_chunk(size_type index);
+  inline void         remove_chunk(size_type index);
+
   size_type           m_complete{};
   size_type           m_accounted{};
+
+  std::unique_ptr<AvailabilityIndex> m_availability;
 };
 
 } // namespace torrent
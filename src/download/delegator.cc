@@ -1,10 +1,13 @@
 #include "config.h"
 
+#include <algorithm>
+
 #include "torrent/bitfield.h"
 #include "torrent/data/block.h"
 #include "torrent/data/block_list.h"
 #include "torrent/data/block_transfer.h"
 #include "protocol/peer_chunks.h"
+#include "utils/instrumentation.h"
 
 #include "delegator.h"
 
@@ -17,6 +20,15 @@ Delegator::delegate(PeerChunks* peerChunks, std::optional<uint32_t> affinity, ui
   std::vector<BlockTransfer*> new_transfers;
   PeerInfo* peerInfo = peerChunks->peer_info();
 
+  // Time-critical chunks go before the affinity, so a fast peer
+  // does not keep working on a normal chunk while a deadline nears.
+  if (m_deadline_mode) {
+    delegate_deadlines(new_transfers, maxPieces, peerChunks);
+
+    if (new_transfers.size() >= maxPieces)
+      return new_transfers;
+  }
+
   // Find piece with same index as affinity. This affinity should ensure that we
   // never start another piece while the chunk this peer used to download is still
   // in progress.
@@ -75,36 +87,152 @@ Delegator::delegate(PeerChunks* peerChunks, std::optional<uint32_t> affinity, ui
   // Create new normal priority pieces.
   delegate_new_chunks(new_transfers, maxPieces, peerChunks, false);
 
-  if (!m_aggressive)
-    return new_transfers;
+  if (m_aggressive)
+    delegate_endgame(new_transfers, maxPieces, peerChunks);
+
+  return new_transfers;
+}
+
+uint64_t
+Delegator::fast_peer_rate() {
+  if (!m_slot_fast_peer_rate)
+    return 0;
+
+  if (m_fast_peer_rate_updated == std::chrono::microseconds{} ||
+      this_thread::cached_time() >= m_fast_peer_rate_updated + fast_peer_rate_interval) {
+    m_fast_peer_rate         = m_slot_fast_peer_rate();
+    m_fast_peer_rate_updated = this_thread::cached_time();
+  }
+
+  return m_fast_peer_rate;
+}
+
+uint32_t
+Delegator::unrequested_blocks() const {
+  uint32_t result = 0;
+
+  for (const BlockList* itr : m_transfers)
+    result += std::count_if(itr->begin(), itr->end(), [](const Block& block) {
+        return !block.is_finished() && block.size_not_stalled() == 0;
+      });
 
-  // In aggressive mode, look for possible downloads that already have
-  // one or more transfers queued.
+  return result;
+}
 
-  // No more than 4 per piece.
-  uint16_t overlapped = 5;
+void
+Delegator::delegate_deadlines(std::vector<BlockTransfer*> &transfers, uint32_t maxPieces, PeerChunks* pc) {
+  if (pc->download_throttle()->rate()->rate() < fast_peer_rate())
+    return;
+
+  std::vector<std::pair<std::chrono::microseconds, BlockList*>> started;
 
   for (BlockList* itr : m_transfers) {
-    if (new_transfers.size() >= maxPieces)
-      return new_transfers;
+    auto deadline = m_slot_chunk_deadline(itr->index());
+
+    if (deadline != std::chrono::microseconds{} && pc->bitfield()->get(itr->index()))
+      started.emplace_back(deadline, itr);
+  }
+
+  std::sort(started.begin(), started.end(), [](auto& a, auto& b) { return a.first < b.first; });
+
+  for (auto& [deadline, block_list] : started) {
+    if (transfers.size() >= maxPieces)
+      return;
+
+    delegate_from_blocklist(transfers, maxPieces, block_list, pc->peer_info());
+  }
+
+  while (transfers.size() < maxPieces) {
+    uint32_t index = m_slot_deadline_find(pc);
+
+    if (index == ~uint32_t{0})
+      break;
 
-    if (peerChunks->bitfield()->get(itr->index()) && itr->priority() != PRIORITY_OFF) {
-      for (auto bl_itr = itr->begin(); bl_itr != itr->end() && overlapped != 0; bl_itr++) {
-        if (new_transfers.size() >= maxPieces || bl_itr->size_not_stalled() >= overlapped)
-          break;
-
-        if (!bl_itr->is_finished()) {
-          BlockTransfer* inserted_info = bl_itr->insert(peerInfo);
-          if (inserted_info != NULL) {
-            new_transfers.push_back(inserted_info);
-            overlapped = bl_itr->size_not_stalled();
-          }
+    auto itr = m_transfers.insert(Piece(index, 0, m_slot_chunk_size(index)), block_size);
+
+    (*itr)->set_by_seeder(pc->is_seeder());
+    (*itr)->set_priority(PRIORITY_HIGH);
+
+    delegate_from_blocklist(transfers, maxPieces, *itr, pc->peer_info());
+  }
+
+  // Like end-game, but limited to chunks at risk.
+  for (auto& [deadline, block_list] : started) {
+    if (!is_deadline_at_risk(block_list, deadline))
+      continue;
+
+    for (auto& block : *block_list) {
+      if (transfers.size() >= maxPieces)
+        return;
+
+      if (block.is_finished() || block.size_not_stalled() > deadline_max_duplicates)
+        continue;
+
+      BlockTransfer* inserted_info = block.insert(pc->peer_info());
+
+      if (inserted_info != NULL) {
+        transfers.push_back(inserted_info);
+        m_deadline_duplicates++;
+        instrumentation_update(INSTRUMENTATION_TRANSFER_REQUESTS_DUPLICATED, 1);
+      }
+    }
+  }
+}
+
+// Slow peers are left out as a duplicate from them is unlikely to
+// finish before the original request. Blocks are visited in order of
+// their number of requests, so that each gets a second request
+// before any gets a third.
+void
+Delegator::delegate_endgame(std::vector<BlockTransfer*> &transfers, uint32_t maxPieces, PeerChunks* pc) {
+  if (pc->download_throttle()->rate()->rate() < fast_peer_rate())
+    return;
+
+  for (uint32_t requests = 1; requests <= endgame_max_duplicates; requests++) {
+    for (BlockList* itr : m_transfers) {
+      if (!pc->bitfield()->get(itr->index()) || itr->priority() == PRIORITY_OFF)
+        continue;
+
+      for (auto& block : *itr) {
+        if (transfers.size() >= maxPieces)
+          return;
+
+        if (block.is_finished() || block.size_not_stalled() != requests)
+          continue;
+
+        BlockTransfer* inserted_info = block.insert(pc->peer_info());
+
+        if (inserted_info != NULL) {
+          transfers.push_back(inserted_info);
+          m_endgame_duplicates++;
+          instrumentation_update(INSTRUMENTATION_TRANSFER_REQUESTS_DUPLICATED, 1);
         }
       }
     }
   }
+}
 
-  return new_transfers;
+// Estimates the time left at the fast peer rate, as any of the
+// peers downloading the chunk might be that slow.
+bool
+Delegator::is_deadline_at_risk(BlockList* c, std::chrono::microseconds deadline) {
+  auto now = this_thread::cached_time();
+
+  if (deadline <= now + deadline_risk_margin)
+    return true;
+
+  uint64_t rate = fast_peer_rate();
+
+  if (rate == 0)
+    return false;
+
+  uint64_t remaining = 0;
+
+  for (auto& block : *c)
+    if (!block.is_finished())
+      remaining += block.piece().length();
+
+  return now + deadline_risk_margin + std::chrono::microseconds(remaining * 1000000 / rate) >= deadline;
 }
 
 void
@@ -1,6 +1,7 @@
 #ifndef LIBTORRENT_DELEGATOR_H
 #define LIBTORRENT_DELEGATOR_H
 
+#include <chrono>
 #include <functional>
 #include <optional>
 #include <string>
@@ -17,13 +18,39 @@ class Piece;
 class PeerChunks;
 class PeerInfo;
 
+// In deadline mode, chunks with a deadline are requested before
+// anything else, but only from peers whose download rate is at least
+// the average. When the remaining blocks of a chunk are unlikely to
+// arrive in time at that rate, its blocks are also requested from
+// additional fast peers.
+//
+// In end-game mode, blocks already requested from other peers are
+// requested again by fast peers, those with the fewest requests
+// first. Once a block completes, the remaining requests for it are
+// cancelled by Block::completed().
+
 class Delegator {
 public:
-  using slot_peer_chunk = std::function<uint32_t(PeerChunks*, bool)>;
-  using slot_size       = std::function<uint32_t(uint32_t)>;
+  using slot_peer_chunk    = std::function<uint32_t(PeerChunks*, bool)>;
+  using slot_size          = std::function<uint32_t(uint32_t)>;
+  using slot_deadline_find = std::function<uint32_t(PeerChunks*)>;
+  using slot_deadline      = std::function<std::chrono::microseconds(uint32_t)>;
+  using slot_rate          = std::function<uint64_t()>;
 
   static constexpr unsigned int block_size = 1 << 14;
 
+  // Extra requests allowed per block of a chunk at risk of missing
+  // its deadline.
+  static constexpr unsigned int deadline_max_duplicates = 2;
+
+  // Chunks are always at risk this close to their deadline.
+  static constexpr auto         deadline_risk_margin   = std::chrono::seconds(2);
+
+  // Extra requests allowed per block in end-game mode.
+  static constexpr unsigned int endgame_max_duplicates = 2;
+
+  static constexpr auto         fast_peer_rate_interval = std::chrono::seconds(1);
+
   TransferList*       transfer_list()                     { return &m_transfers; }
   const TransferList* transfer_list() const               { return &m_transfers; }
 
@@ -32,22 +59,67 @@ public:
   bool               get_aggressive() const               { return m_aggressive; }
   void               set_aggressive(bool a)               { m_aggressive = a; }
 
+  bool               is_deadline_mode() const             { return m_deadline_mode; }
+  void               set_deadline_mode(bool state)        { m_deadline_mode = state; }
+
+  // Lets RequestList size request pipelines from the measured
+  // round-trip time of each peer.
+  bool               is_adaptive_pipelining() const       { return m_adaptive_pipelining; }
+  void               set_adaptive_pipelining(bool state)  { m_adaptive_pipelining = state; }
+
+  // The minimum download rate of peers given deadline chunks and
+  // end-game duplicates, updated from 'slot_fast_peer_rate' at most
+  // once per interval.
+  uint64_t           fast_peer_rate();
+
+  // Number of block requests made to duplicate those of chunks at
+  // risk of missing their deadline.
+  uint64_t           deadline_duplicates() const          { return m_deadline_duplicates; }
+
+  // Number of block requests made to duplicate others in end-game
+  // mode.
+  uint64_t           endgame_duplicates() const           { return m_endgame_duplicates; }
+
+  // Unfinished blocks of started chunks that have not been requested
+  // from a peer that isn't stalled.
+  uint32_t           unrequested_blocks() const;
+
   slot_peer_chunk&   slot_chunk_find()                    { return m_slot_chunk_find; }
   slot_size&         slot_chunk_size()                    { return m_slot_chunk_size; }
 
+  slot_deadline_find& slot_deadline_find_chunk()          { return m_slot_deadline_find; }
+  slot_deadline&     slot_chunk_deadline()                { return m_slot_chunk_deadline; }
+  slot_rate&         slot_fast_peer_rate()                { return m_slot_fast_peer_rate; }
+
 private:
   static void        delegate_from_blocklist(std::vector<BlockTransfer*> &transfers, uint32_t maxPieces, BlockList* c, PeerInfo* peerInfo);
   void               delegate_new_chunks(std::vector<BlockTransfer*> &transfers, uint32_t maxPieces, PeerChunks* pc, bool highPriority);
   Block*             delegate_seeder(PeerChunks* peerChunks);
 
+  void               delegate_deadlines(std::vector<BlockTransfer*> &transfers, uint32_t maxPieces, PeerChunks* pc);
+  bool               is_deadline_at_risk(BlockList* c, std::chrono::microseconds deadline);
+
+  void               delegate_endgame(std::vector<BlockTransfer*> &transfers, uint32_t maxPieces, PeerChunks* pc);
+
   TransferList       m_transfers;
 
   bool               m_aggressive{false};
+  bool               m_deadline_mode{false};
+  bool               m_adaptive_pipelining{false};
+
+  uint64_t                  m_fast_peer_rate{0};
+  std::chrono::microseconds m_fast_peer_rate_updated{};
+  uint64_t                  m_deadline_duplicates{0};
+  uint64_t                  m_endgame_duplicates{0};
 
   // Propably should add a m_slotChunkStart thing, which will take
   // care of enabling etc, and will be possible to listen to.
   slot_peer_chunk    m_slot_chunk_find;
   slot_size          m_slot_chunk_size;
+
+  slot_deadline_find m_slot_deadline_find;
+  slot_deadline      m_slot_chunk_deadline;
+  slot_rate          m_slot_fast_peer_rate;
 };
 
 } // namespace torrent
@@ -2,6 +2,7 @@
 
 #include "download/download_main.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 
@@ -35,7 +36,7 @@
 #include "tracker/tracker_list.h"
 
 #define LT_LOG_THIS(log_level, log_fmt, ...)                         \
-  lt_log_print_info(LOG_TORRENT_##log_level, m_ptr->info(), "download", log_fmt, __VA_ARGS__);
+  lt_log_print_info(LOG_TORRENT_##log_level, info(), "download", log_fmt, __VA_ARGS__);
 
 namespace torrent {
 
@@ -55,7 +56,11 @@ DownloadMain::DownloadMain()
   m_delegator.slot_chunk_find() = [this](auto pc, auto prio) { return m_chunkSelector->find(pc, prio); };
   m_delegator.slot_chunk_size() = [this](auto i) { return file_list()->chunk_index_size(i); };
 
-  m_delegator.transfer_list()->slot_canceled()  = [this](auto i) { m_chunkSelector->not_using_index(i); };
+  m_delegator.slot_deadline_find_chunk() = [this](auto pc) { return m_chunkSelector->find_deadline(pc); };
+  m_delegator.slot_chunk_deadline()      = [this](auto i) { return m_chunkSelector->deadline(i); };
+  m_delegator.slot_fast_peer_rate()      = [this] { return receive_average_peer_rate(); };
+
+  m_delegator.transfer_list()->slot_canceled()  = [this](auto i) { m_chunkSelector->not_using_index(i); m_hash_incremental.erase(i); };
   m_delegator.transfer_list()->slot_queued()    = [this](auto i) { m_chunkSelector->using_index(i); };
   m_delegator.transfer_list()->slot_completed() = [this](auto i) { receive_chunk_done(i); };
   m_delegator.transfer_list()->slot_corrupt()   = [this](auto i) { receive_corrupt_chunk(i); };
@@ -243,11 +248,62 @@ DownloadMain::want_pex_msg() {
   return m_info->is_pex_active() && m_peerList.available_list()->want_more();
 }
 
+// Enter end-game once the blocks left to request would fit in the
+// request pipelines of the peers we are downloading from, as peers
+// would otherwise start going idle while the last blocks trickle in
+// from slower ones.
 void
 DownloadMain::update_endgame() {
-  if (!m_delegator.get_aggressive() &&
-      file_list()->completed_chunks() + m_delegator.transfer_list()->size() + 5 >= file_list()->size_chunks())
+  if (m_delegator.get_aggressive() || file_list()->data()->wanted_chunks() == 0)
+    return;
+
+  m_endgame_checked = this_thread::cached_time();
+
+  uint64_t pipeline_capacity = 0;
+
+  for (auto& connection : *m_connectionList) {
+    auto pcb = connection->m_ptr();
+
+    if (pcb->is_down_remote_unchoked() && pcb->is_down_interested())
+      pipeline_capacity += pcb->request_list()->calculate_pipe_size(pcb->c_peer_chunks()->download_throttle()->rate()->rate());
+  }
+
+  uint32_t wanted_chunks    = file_list()->data()->wanted_chunks();
+  uint64_t untouched_chunks = wanted_chunks - std::min<uint32_t>(wanted_chunks, m_delegator.transfer_list()->size());
+  uint64_t chunk_blocks     = (file_list()->chunk_size() + Delegator::block_size - 1) / Delegator::block_size;
+  uint64_t remaining_blocks = untouched_chunks * chunk_blocks + m_delegator.unrequested_blocks();
+
+  if (remaining_blocks == 0 || remaining_blocks < pipeline_capacity) {
+    LT_LOG_THIS(INFO, "entering end-game: remaining_blocks:%" PRIu64 " pipeline_capacity:%" PRIu64,
+                remaining_blocks, pipeline_capacity);
     m_delegator.set_aggressive(true);
+  }
+}
+
+void
+DownloadMain::try_update_endgame() {
+  if (m_endgame_checked != std::chrono::microseconds{} &&
+      this_thread::cached_time() < m_endgame_checked + endgame_check_interval)
+    return;
+
+  update_endgame();
+}
+
+// Average download rate of the peers we are currently receiving data
+// from, or zero if there are none.
+uint64_t
+DownloadMain::receive_average_peer_rate() {
+  uint64_t total = 0;
+  uint64_t count = 0;
+
+  for (auto& connection : *m_connectionList) {
+    auto rate = connection->m_ptr()->c_peer_chunks()->download_throttle()->rate()->rate();
+
+    total += rate;
+    count += rate != 0;
+  }
+
+  return count != 0 ? total / count : 0;
 }
 
 void
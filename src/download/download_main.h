@@ -5,6 +5,7 @@
 #include <utility>
 
 #include "data/chunk_handle.h"
+#include "data/hash_incremental.h"
 #include "download/delegator.h"
 #include "net/address_list.h"
 #include "net/data_buffer.h"
@@ -33,6 +34,8 @@ public:
   using have_queue_type = std::deque<std::pair<std::chrono::microseconds, uint32_t>>;
   using pex_list        = std::vector<SocketAddressCompact>;
 
+  static constexpr auto endgame_check_interval = std::chrono::seconds(1);
+
   DownloadMain();
   ~DownloadMain();
 
@@ -62,6 +65,7 @@ public:
   ChunkStatistics*    chunk_statistics()                         { return m_chunkStatistics; }
 
   Delegator*          delegator()                                { return &m_delegator; }
+  HashIncremental*    hash_incremental()                         { return &m_hash_incremental; }
 
   have_queue_type*    have_queue()                               { return &m_haveQueue; }
 
@@ -107,6 +111,7 @@ public:
 
   void                receive_connect_peers();
   void                receive_chunk_done(unsigned int index);
+  uint64_t            receive_average_peer_rate();
   void                receive_corrupt_chunk(PeerInfo* peerInfo);
 
   void                receive_tracker_success();
@@ -116,7 +121,11 @@ public:
 
   void                do_peer_exchange();
 
+  // try_update_endgame() only checks once per
+  // 'endgame_check_interval', as peers call it whenever they run out
+  // of blocks to request.
   void                update_endgame();
+  void                try_update_endgame();
 
   auto&               delay_download_done()       { return m_delay_download_done; }
   auto&               delay_partially_done()      { return m_delay_partially_done; }
@@ -143,6 +152,7 @@ private:
   ChunkStatistics*    m_chunkStatistics;
 
   Delegator           m_delegator;
+  HashIncremental     m_hash_incremental;
   have_queue_type     m_haveQueue;
   std::unique_ptr<InitialSeeding> m_initial_seeding;
 
@@ -157,6 +167,8 @@ private:
   ThrottleList*       m_upload_throttle{};
   ThrottleList*       m_download_throttle{};
 
+  std::chrono::microseconds m_endgame_checked{};
+
   slot_start_handshake_type  m_slot_start_handshake;
   slot_stop_handshakes_type  m_slot_stop_handshakes;
 
@@ -2,7 +2,9 @@
 
 #include "download/download_wrapper.h"
 
+#include "thread_main.h"
 #include "data/chunk_list.h"
+#include "data/hash_cache.h"
 #include "data/hash_queue.h"
 #include "data/hash_torrent.h"
 #include "download/chunk_selector.h"
@@ -86,6 +88,8 @@ DownloadWrapper::initialize(const std::string& hash, const std::string& id, uint
 
   // Connect various signals and slots.
   m_hash_checker->slot_check_chunk()     = [this](auto h) { check_chunk_hash(h, true); };
+  m_hash_checker->slot_check_cached()    = [this](auto i) { return check_cached_hash(i); };
+  m_hash_checker->slot_read_ahead()      = [this](auto i) { file_list()->advise_willneed_index(i); };
   m_hash_checker->delay_checked().slot() = [this]         { receive_initial_hash(); };
 
   m_main->post_initialize();
@@ -95,9 +99,12 @@ DownloadWrapper::initialize(const std::string& hash, const std::string& id, uint
 
 void
 DownloadWrapper::close() {
+  bool was_checked = m_hash_checker->is_checked();
+
   // Stop the hashing first as we need to make sure all chunks are
   // released when DownloadMain::close() is called.
   m_hash_checker->clear();
+  m_hash_cache_signatures.clear();
 
   // Clear after m_hash_checker to ensure that the empty hash done signal does
   // not get passed to HashTorrent.
@@ -108,6 +115,10 @@ DownloadWrapper::close() {
   // hash_resume_save get ignored anyway.
   m_main->chunk_list()->sync_chunks_no_cache(ChunkList::sync_all | ChunkList::sync_force | ChunkList::sync_sloppy | ChunkList::sync_ignore_error);
 
+  // Written after syncing so the signatures see the final mtimes.
+  if (was_checked)
+    update_hash_cache();
+
   m_main->close();
 
   // Should this perhaps be in stop?
@@ -121,6 +132,8 @@ DownloadWrapper::receive_initial_hash() {
   if (info()->is_active())
     throw internal_error("DownloadWrapper::receive_initial_hash() but we're in a bad state.");
 
+  m_hash_cache_signatures.clear();
+
   if (!m_hash_checker->is_checking()) {
     receive_storage_error("Hash checker was unable to map chunk: " + std::string(std::strerror(m_hash_checker->error_number())));
 
@@ -135,6 +148,7 @@ DownloadWrapper::receive_initial_hash() {
     m_main->chunk_selector()->initialize(m_main->chunk_statistics());
 
     receive_update_priorities();
+    update_hash_cache();
   }
 
   if (data()->slot_initial_hash())
@@ -179,6 +193,7 @@ DownloadWrapper::receive_hash_done(ChunkHandle handle, const char* hash) {
       bool was_partial = data()->wanted_chunks() != 0;
 
       m_main->file_list()->mark_completed(handle.index());
+      m_main->chunk_selector()->erase_deadline(handle.index());
       m_main->delegator()->transfer_list()->hash_succeeded(handle.index(), handle.chunk());
       m_main->update_endgame();
 
@@ -218,7 +233,42 @@ DownloadWrapper::check_chunk_hash(ChunkHandle handle, bool hashing) {
   ChunkHandle new_handle = m_main->chunk_list()->get(handle.index(), flags);
   m_main->chunk_list()->release(&handle, ChunkList::release_default);
 
-  hash_queue()->push_back(new_handle, data(), [this](auto c, auto h) { receive_hash_done(c, h); });
+  auto slot_done = [this](auto c, auto h) { receive_hash_done(c, h); };
+
+  if (!hashing) {
+    HashString hash;
+
+    if (m_main->hash_incremental()->finish(new_handle.index(), new_handle.chunk(), hash.data()))
+      return hash_queue()->push_back_hashed(new_handle, data(), slot_done, hash);
+  }
+
+  auto priority = HashChunk::priority_download;
+
+  if (hashing)
+    priority = m_hash_checker->is_partial() ? HashChunk::priority_resume : HashChunk::priority_recheck;
+
+  hash_queue()->push_back(new_handle, data(), slot_done, priority);
+}
+
+// Signatures are taken once per hash check, as stat'ing every file
+// for each chunk would cost more than it saves.
+bool
+DownloadWrapper::check_cached_hash(uint32_t index) {
+  auto hash_cache = ThreadMain::thread_main()->hash_cache();
+
+  if (!hash_cache->is_open())
+    return false;
+
+  if (m_hash_cache_signatures.empty())
+    m_hash_cache_signatures = HashCache::chunk_signatures(file_list());
+
+  if (!hash_cache->contains(info()->hash(), index, m_hash_cache_signatures[index]))
+    return false;
+
+  if (!file_list()->bitfield()->get(index))
+    m_main->file_list()->mark_completed(index);
+
+  return true;
 }
 
 void
@@ -289,6 +339,11 @@ DownloadWrapper::receive_tick(uint32_t ticks) {
                                    }).base(),
                     have_queue->end());
 
+  // The request pipelines change with the peers, so end-game is not
+  // only checked as chunks complete.
+  if (info()->is_active())
+    m_main->update_endgame();
+
   m_main->receive_connect_peers();
 }
 
@@ -349,6 +404,28 @@ DownloadWrapper::receive_update_priorities() {
   }
 }
 
+// Records completed chunks and drops the rest, so chunks that failed
+// or were never finished are hashed on the next check.
+void
+DownloadWrapper::update_hash_cache() {
+  auto hash_cache = ThreadMain::thread_main()->hash_cache();
+
+  if (!hash_cache->is_open())
+    return;
+
+  auto signatures = HashCache::chunk_signatures(file_list());
+  auto bitfield   = file_list()->bitfield();
+
+  for (uint32_t index = 0; index < signatures.size(); index++) {
+    if (bitfield->get(index))
+      hash_cache->insert(info()->hash(), index, signatures[index]);
+    else
+      hash_cache->erase(info()->hash(), index);
+  }
+
+  hash_cache->flush();
+}
+
 void
 DownloadWrapper::finished_download() {
   // We delay emitting the signal to allow the delegator to
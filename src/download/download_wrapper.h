@@ -59,6 +59,7 @@ public:
   void                receive_hash_done(ChunkHandle handle, const char* hash);
 
   void                check_chunk_hash(ChunkHandle handle, bool hashing);
+  bool                check_cached_hash(uint32_t index);
 
   void                receive_storage_error(const std::string& str);
   uint32_t            receive_tracker_success(AddressList* l);
@@ -70,6 +71,7 @@ public:
 
 private:
   void                finished_download();
+  void                update_hash_cache();
 
   std::unique_ptr<DownloadMain> m_main;
   std::unique_ptr<Object>       m_bencode;
@@ -78,6 +80,8 @@ private:
 
   std::string         m_hash;
 
+  std::vector<uint64_t> m_hash_cache_signatures;
+
   int                 m_connectionType{0};
 };
 
@@ -8,6 +8,7 @@
 #include "download/download_main.h"
 #include "download/download_wrapper.h"
 #include "net/listen.h"
+#include "net/peer_read_threads.h"
 #include "protocol/handshake_manager.h"
 #include "torrent/throttle.h"
 #include "torrent/data/file_manager.h"
@@ -16,6 +17,7 @@
 #include "torrent/download/download_manager.h"
 #include "torrent/download/resource_manager.h"
 #include "torrent/peer/client_list.h"
+#include "torrent/runtime/network_config.h"
 #include "torrent/runtime/network_manager.h"
 #include "torrent/runtime/socket_manager.h"
 #include "utils/instrumentation.h"
@@ -60,6 +62,8 @@ Manager::cleanup() {
   m_handshake_manager->clear();
   m_download_manager->clear();
 
+  m_peer_read_threads.reset();
+
   Throttle::destroy_throttle(m_uploadThrottle);
   Throttle::destroy_throttle(m_downloadThrottle);
 
@@ -101,6 +105,23 @@ Manager::cleanup_download(DownloadWrapper* d) {
   m_download_manager->erase(d);
 }
 
+// Connections keep the read threads they were opened with, so a new
+// number of threads only applies to new connections.
+std::shared_ptr<PeerReadThreads>
+Manager::peer_read_threads() {
+  auto threads = runtime::network_config()->peer_read_threads();
+
+  if (threads == 0) {
+    m_peer_read_threads.reset();
+    return nullptr;
+  }
+
+  if (m_peer_read_threads == nullptr || m_peer_read_threads->size() != static_cast<size_t>(threads))
+    m_peer_read_threads = std::make_shared<PeerReadThreads>(threads);
+
+  return m_peer_read_threads;
+}
+
 void
 Manager::receive_tick() {
   m_ticks++;
@@ -12,6 +12,7 @@ namespace torrent {
 
 class DownloadManager;
 class FileManager;
+class PeerReadThreads;
 class ResourceManager;
 
 class Manager {
@@ -30,6 +31,10 @@ public:
   Throttle*           upload_throttle()    { return m_uploadThrottle; }
   Throttle*           download_throttle()  { return m_downloadThrottle; }
 
+  // Returns the read threads for new peer connections, or nullptr if
+  // they read from the main thread's poll.
+  std::shared_ptr<PeerReadThreads> peer_read_threads();
+
   void                cleanup();
 
   void                initialize_download(DownloadWrapper* d);
@@ -46,6 +51,8 @@ private:
 
   std::unique_ptr<ClientList>        m_client_list;
 
+  std::shared_ptr<PeerReadThreads>   m_peer_read_threads;
+
   Throttle*             m_uploadThrottle;
   Throttle*             m_downloadThrottle;
 
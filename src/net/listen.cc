@@ -3,6 +3,7 @@
 #include "listen.h"
 
 #include "manager.h"
+#include "net/listen_acceptors.h"
 #include "protocol/handshake.h"
 #include "torrent/exceptions.h"
 #include "torrent/net/fd.h"
@@ -20,8 +21,8 @@ namespace torrent {
 
 namespace {
 
-std::tuple<int, int>
-listen_fd_open(const sockaddr* bind_address, bool block_ipv4in6) {
+fd_flags
+listen_fd_flags(const sockaddr* bind_address, bool block_ipv4in6) {
   fd_flags open_flags = fd_flag_nonblock | fd_flag_reuse_address;
 
   if (bind_address->sa_family == AF_INET)
@@ -30,6 +31,16 @@ listen_fd_open(const sockaddr* bind_address, bool block_ipv4in6) {
   if (bind_address->sa_family == AF_INET6 && block_ipv4in6)
     open_flags |= fd_flag_v6only;
 
+  return open_flags;
+}
+
+std::tuple<int, int>
+listen_fd_open(const sockaddr* bind_address, const Listen::open_options& options) {
+  fd_flags open_flags = listen_fd_flags(bind_address, options.block_ipv4in6);
+
+  // The stream socket is bound without SO_REUSEPORT so that probing
+  // fails on ports already held by any other socket, including
+  // SO_REUSEPORT sockets of another process owned by the same user.
   int stream_fd = fd_open(fd_flag_stream | open_flags);
 
   if (stream_fd == -1)
@@ -49,7 +60,7 @@ std::tuple<int, uint16_t>
 listen_open_range(Listen::open_options options, const sockaddr* bind_address) {
   sa_unique_ptr try_address = sa_copy(bind_address);
 
-  auto [stream_fd, datagram_fd] = listen_fd_open(bind_address, options.block_ipv4in6);
+  auto [stream_fd, datagram_fd] = listen_fd_open(bind_address, options);
 
   uint16_t port = options.first_port;
 
@@ -66,11 +77,23 @@ listen_open_range(Listen::open_options options, const sockaddr* bind_address) {
       fd_close(stream_fd);
       fd_close(datagram_fd);
 
-      std::tie(stream_fd, datagram_fd) = listen_fd_open(bind_address, options.block_ipv4in6);
+      std::tie(stream_fd, datagram_fd) = listen_fd_open(bind_address, options);
       continue;
     }
 
     fd_close(datagram_fd);
+
+    // The port is now exclusively ours, enable SO_REUSEPORT before
+    // listening so the acceptor sockets can join it. Another same-user
+    // SO_REUSEPORT socket could still bind the port after this point,
+    // which the kernel does not let us prevent.
+    if (options.threads > 0 && !fd_set_reuse_port(stream_fd, true)) {
+      LT_LOG("failed to set SO_REUSEPORT on port %" PRIu16 " : %s", port, system::errno_enum(errno));
+
+      fd_close(stream_fd);
+      return std::make_tuple(-1, 0);
+    }
+
     return std::make_tuple(stream_fd, port);
 
   } while (port++ < options.last_port);
@@ -81,14 +104,53 @@ listen_open_range(Listen::open_options options, const sockaddr* bind_address) {
   return std::make_tuple(-1, 0);
 }
 
+// Opens an additional listen socket sharing the port of an existing
+// SO_REUSEPORT socket.
+int
+listen_open_reuse_port(const sockaddr* bind_address, uint16_t port, const Listen::open_options& options) {
+  sa_unique_ptr address = sa_copy(bind_address);
+  sa_set_port(address.get(), port);
+
+  int fd = fd_open(fd_flag_stream | fd_flag_reuse_port | listen_fd_flags(bind_address, options.block_ipv4in6));
+
+  if (fd == -1)
+    return -1;
+
+  if (!fd_bind(fd, address.get()) || !fd_listen(fd, options.backlog)) {
+    int saved_errno = errno;
+    fd_close(fd);
+    errno = saved_errno;
+    return -1;
+  }
+
+  return fd;
+}
+
+void
+listen_validate_options(const Listen::open_options& options) {
+  if (options.first_port == 0 || options.first_port > options.last_port)
+    throw input_error("Tried to open listening port with an invalid range");
+
+  if (options.threads < 0)
+    throw input_error("Tried to open listening port with a negative number of threads");
+
+  if (options.threads > 0 && options.accept_batch < 1)
+    throw input_error("Tried to open listening port with an accept batch less than 1");
+}
+
+}
+
+Listen::Listen() = default;
+
+Listen::~Listen() {
+  close();
 }
 
 bool
 Listen::open_single(Listen* listen, const sockaddr* bind_address, open_options options) {
   listen->close();
 
-  if (options.first_port == 0 || options.first_port > options.last_port)
-    throw input_error("Tried to open listening port with an invalid range");
+  listen_validate_options(options);
 
   if (bind_address->sa_family != AF_INET && bind_address->sa_family != AF_INET6)
     throw input_error("Listening socket must be inet or inet6 address type");
@@ -113,7 +175,7 @@ Listen::open_single(Listen* listen, const sockaddr* bind_address, open_options o
   if (!fd_listen(listen_fd, options.backlog))
     error_fn("Could not listen on socket");
 
-  listen->open_done(listen_fd, listen_port, options.backlog);
+  listen->open_done(listen_fd, listen_port, bind_address, options);
   return true;
 }
 
@@ -122,8 +184,7 @@ Listen::open_both(Listen* listen_inet, Listen* listen_inet6, const sockaddr* bin
   listen_inet->close();
   listen_inet6->close();
 
-  if (options.first_port == 0 || options.first_port > options.last_port)
-    throw input_error("Tried to open listening port with an invalid range");
+  listen_validate_options(options);
 
   if (bind_inet_address->sa_family != AF_INET)
     throw input_error("Listening ipv4 socket must be inet address type");
@@ -187,31 +248,75 @@ Listen::open_both(Listen* listen_inet, Listen* listen_inet6, const sockaddr* bin
   }
 
   if (inet_fd != -1)
-    listen_inet->open_done(inet_fd, inet_port, options.backlog);
+    listen_inet->open_done(inet_fd, inet_port, bind_inet_address, options);
 
-  listen_inet6->open_done(inet6_fd, inet_port, options.backlog);
+  listen_inet6->open_done(inet6_fd, inet_port, bind_inet6_address, options);
   return true;
 }
 
 void
-Listen::open_done(int fd, uint16_t port, int backlog) {
+Listen::open_done(int fd, uint16_t port, const sockaddr* bind_address, const open_options& options) {
   set_file_descriptor(fd);
   m_port = port;
 
-  runtime::socket_manager()->register_event_or_throw(this, runtime::category_internal, [this]() {
+  // With acceptor threads the listen socket is registered but not
+  // polled, as the acceptor threads block on it instead.
+  runtime::socket_manager()->register_event_or_throw(this, runtime::category_internal, [this, &options]() {
+      if (options.threads > 0)
+        return;
+
       this_thread::poll()->open(this);
       this_thread::poll()->insert_read(this);
     });
 
-  LT_LOG("listen opened: fd:%i port:%" PRIu16 " backlog:%i", file_descriptor(), m_port, backlog);
+  LT_LOG("listen opened: fd:%i port:%" PRIu16 " backlog:%i threads:%i", file_descriptor(), m_port, options.backlog, options.threads);
+
+  if (options.threads > 0)
+    open_acceptors(fd, bind_address, options);
+}
+
+void
+Listen::open_acceptors(int fd, const sockaddr* bind_address, const open_options& options) {
+  try {
+    std::vector<int> listen_fds{fd};
+
+    for (int i = 1; i < options.threads; i++) {
+      int reuse_fd = listen_open_reuse_port(bind_address, m_port, options);
+
+      if (reuse_fd == -1)
+        throw resource_error("Could not open SO_REUSEPORT listen socket: " + system::errno_enum_str(errno));
+
+      m_reuse_port_fds.push_back(reuse_fd);
+      listen_fds.push_back(reuse_fd);
+    }
+
+    m_acceptors = std::make_unique<ListenAcceptors>(listen_fds, options.accept_batch, [this](int accepted_fd, const sockaddr* sa) {
+        accept_connection(accepted_fd, sa_copy(sa));
+      });
+
+  } catch (...) {
+    close();
+    throw;
+  }
 }
 
 void Listen::close() {
   if (!is_open())
     return;
 
-  runtime::socket_manager()->unregister_event_or_throw(this, [this]() {
-      this_thread::poll()->remove_and_close(this);
+  // Stop the acceptor threads before closing the sockets they poll.
+  bool has_acceptors = m_acceptors != nullptr;
+
+  m_acceptors.reset();
+
+  for (int fd : m_reuse_port_fds)
+    fd_close(fd);
+
+  m_reuse_port_fds.clear();
+
+  runtime::socket_manager()->unregister_event_or_throw(this, [this, has_acceptors]() {
+      if (!has_acceptors)
+        this_thread::poll()->remove_and_close(this);
 
       fd_close(file_descriptor());
       reset_file_descriptor();
@@ -223,15 +328,7 @@ void Listen::close() {
 void
 Listen::event_read() {
   while (true) {
-    auto handshake = std::make_unique<Handshake>();
-
-    // TODO: Optimize this by adding handshake immediately to poll and put the slot_accepted() call
-    // outside of open_func().
-
-    int           fd;
-    sa_unique_ptr sa;
-
-    std::tie(fd, sa) = fd_sap_accept(file_descriptor());
+    auto [fd, sa] = fd_sap_accept(file_descriptor());
 
     if (fd == -1) {
       if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
@@ -244,37 +341,45 @@ Listen::event_read() {
       throw resource_error("Listener port accept() failed: " + system::errno_enum_str(errno));
     }
 
-    auto open_func = [&]() {
-        // TODO: Figure out a clean way of doing this.
-        int tmp_fd = fd;
-        fd = -1;
+    // If the handshake connection or socket manager failed, don't continue accepting connections.
+    //
+    // This allows the event loop a chance to clear out any conflicts with reused file descriptors.
+
+    if (!accept_connection(fd, std::move(sa)))
+      return;
+  }
+}
 
-        m_slot_accepted(handshake, tmp_fd, sa.get());
-      };
+bool
+Listen::accept_connection(int fd, sa_unique_ptr sa) {
+  auto handshake = std::make_unique<Handshake>();
 
-    auto cleanup_func = [fd, &handshake](bool opened) {
-        LT_LOG("failed to accept incoming connection : socket manager triggered cleanup", 0);
+  // TODO: Optimize this by adding handshake immediately to poll and put the slot_accepted() call
+  // outside of open_func().
 
-        if (!opened) {
-          fd_close(fd);
-          return;
-        }
+  auto open_func = [&]() {
+      // TODO: Figure out a clean way of doing this.
+      int tmp_fd = fd;
+      fd = -1;
 
-        if (handshake && handshake->is_open())
-          handshake->destroy_connection(false);
-      };
+      m_slot_accepted(handshake, tmp_fd, sa.get());
+    };
 
-    // TODO: This needs to be handled differently as open_ isn't done, we're doing accept_event_or_cleanup? Add a close callback?
+  auto cleanup_func = [fd, &handshake](bool opened) {
+      LT_LOG("failed to accept incoming connection : socket manager triggered cleanup", 0);
 
-    bool result = runtime::socket_manager()->open_event_or_cleanup(handshake.get(), runtime::category_generic, open_func, cleanup_func);
+      if (!opened) {
+        fd_close(fd);
+        return;
+      }
 
-    // If the handshake connection or socket manager failed, don't continue accepting connections.
-    //
-    // This allows the event loop a chance to clear out any conflicts with reused file descriptors.
+      if (handshake && handshake->is_open())
+        handshake->destroy_connection(false);
+    };
 
-    if (!result)
-      return;
-  }
+  // TODO: This needs to be handled differently as open_ isn't done, we're doing accept_event_or_cleanup? Add a close callback?
+
+  return runtime::socket_manager()->open_event_or_cleanup(handshake.get(), runtime::category_generic, open_func, cleanup_func);
 }
 
 void
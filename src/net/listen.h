@@ -4,12 +4,14 @@
 #include <cinttypes>
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "torrent/system/event.h"
 
 namespace torrent {
 
 class Handshake;
+class ListenAcceptors;
 
 class Listen : public system::Event {
 public:
@@ -19,9 +21,16 @@ public:
     int             backlog{};
     bool            block_ipv4in6{};
     bool            check_dht{};
+
+    // When non-zero, open this many SO_REUSEPORT sockets on the port,
+    // each accepting up to 'accept_batch' connections per wakeup from
+    // its own thread.
+    int             threads{};
+    int             accept_batch{};
   };
 
-  ~Listen() override { close(); }
+  Listen();
+  ~Listen() override;
 
   const char*         type_name() const override { return "listen"; }
 
@@ -43,10 +52,16 @@ public:
 private:
   using slot_accept_type = std::function<void(std::unique_ptr<Handshake>& handshake, int, const sockaddr*)>;
 
-  void                open_done(int fd, uint16_t port, int backlog);
+  void                open_done(int fd, uint16_t port, const sockaddr* bind_address, const open_options& options);
+  void                open_acceptors(int fd, const sockaddr* bind_address, const open_options& options);
+
+  bool                accept_connection(int fd, sa_unique_ptr sa);
 
   uint16_t            m_port{0};
   slot_accept_type    m_slot_accepted;
+
+  std::vector<int>                 m_reuse_port_fds;
+  std::unique_ptr<ListenAcceptors> m_acceptors;
 };
 
 } // namespace torrent
@@ -0,0 +1,163 @@
+#include "config.h"
+
+#include "net/listen_acceptors.h"
+
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "torrent/exceptions.h"
+#include "torrent/net/fd.h"
+#include "torrent/system/callbacks.h"
+#include "torrent/system/types.h"
+#include "torrent/utils/log.h"
+
+#define LT_LOG(log_fmt, ...)                                    \
+  lt_log_print(torrent::LOG_CONNECTION_LISTEN, "listen: " log_fmt, __VA_ARGS__);
+
+namespace torrent {
+
+// Time to back off when accept() fails with e.g. EMFILE, as the listen
+// socket stays readable.
+static constexpr int accept_error_delay_ms = 100;
+
+ListenAcceptors::ListenAcceptors(const std::vector<int>& listen_fds, unsigned int accept_batch, slot_accepted_type slot_accepted) :
+    m_accept_batch(accept_batch),
+    m_slot_accepted(std::move(slot_accepted)) {
+
+  if (listen_fds.empty())
+    throw internal_error("ListenAcceptors::ListenAcceptors(): no listen sockets.");
+
+  if (m_accept_batch == 0)
+    throw internal_error("ListenAcceptors::ListenAcceptors(): accept batch is zero.");
+
+  fd_open_pipe(m_wakeup_read, m_wakeup_write);
+
+  m_workers.reserve(listen_fds.size());
+
+  for (int fd : listen_fds)
+    m_workers.emplace_back(&ListenAcceptors::worker_loop, this, fd);
+
+  LT_LOG("started %zu acceptor threads : accept_batch:%u", m_workers.size(), m_accept_batch);
+}
+
+ListenAcceptors::~ListenAcceptors() {
+  char wakeup = 0;
+
+  // The pipe is never read from, so it cannot be full.
+  while (::write(m_wakeup_write, &wakeup, 1) == -1 && errno == EINTR)
+    ;
+
+  for (auto& worker : m_workers)
+    worker.join();
+
+  main_thread::cancel_callback(m_callback_id);
+
+  accepted_type accepted;
+
+  while (m_accepted.try_pop(accepted))
+    fd_close(accepted.fd);
+
+  fd_close(m_wakeup_read);
+  fd_close(m_wakeup_write);
+
+  LT_LOG("stopped acceptor threads", 0);
+}
+
+void
+ListenAcceptors::process_accepted() {
+  // Clear before draining so connections pushed while draining schedule
+  // a new callback.
+  m_scheduled.store(false);
+
+  if (auto dropped = m_dropped.exchange(0); dropped != 0)
+    LT_LOG("dropped %u incoming connections, accept queue is full", dropped);
+
+  if (auto error = m_accept_error.exchange(0); error != 0)
+    LT_LOG("accept failed : %s", system::errno_enum(error));
+
+  accepted_type accepted;
+
+  while (m_accepted.try_pop(accepted))
+    m_slot_accepted(accepted.fd, &accepted.address.sa);
+}
+
+// The acceptor threads are not torrent threads, so they must not log or
+// call the fd helpers. Anything worth logging is reported through
+// process_accepted().
+void
+ListenAcceptors::worker_loop(int listen_fd) {
+#if defined(HAS_PTHREAD_SETNAME_NP_DARWIN)
+  pthread_setname_np("rtorrent-listen");
+#elif defined(HAS_PTHREAD_SETNAME_NP_GENERIC)
+  pthread_setname_np(pthread_self(), "rtorrent-listen");
+#endif
+
+  pollfd poll_fds[2] = {
+    { listen_fd,     POLLIN, 0 },
+    { m_wakeup_read, POLLIN, 0 }
+  };
+
+  while (true) {
+    if (::poll(poll_fds, 2, -1) == -1) {
+      if (errno == EINTR)
+        continue;
+
+      throw internal_error("ListenAcceptors::worker_loop(): poll failed: " + system::errno_enum_str(errno));
+    }
+
+    if (poll_fds[1].revents != 0)
+      return;
+
+    if (!accept_batch(listen_fd) && ::poll(poll_fds + 1, 1, accept_error_delay_ms) > 0)
+      return;
+  }
+}
+
+// Returns false if accept() failed with an error that would leave the
+// listen socket readable.
+bool
+ListenAcceptors::accept_batch(int listen_fd) {
+  unsigned int pushed = 0;
+  bool         result = true;
+
+  for (unsigned int i = 0; i < m_accept_batch; i++) {
+    accepted_type accepted;
+    socklen_t     address_length = sizeof(accepted.address);
+
+#ifdef HAVE_ACCEPT4
+    accepted.fd = ::accept4(listen_fd, &accepted.address.sa, &address_length, SOCK_CLOEXEC);
+#else
+    accepted.fd = ::accept(listen_fd, &accepted.address.sa, &address_length);
+#endif
+
+    if (accepted.fd == -1) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        m_accept_error.store(errno);
+        result = false;
+      }
+
+      break;
+    }
+
+    if (!m_accepted.try_push(accepted)) {
+      ::close(accepted.fd);
+      m_dropped.fetch_add(1);
+      continue;
+    }
+
+    pushed++;
+  }
+
+  if ((pushed != 0 || m_dropped.load() != 0 || m_accept_error.load() != 0) && !m_scheduled.exchange(true))
+    main_thread::callback(m_callback_id, [this]() { process_accepted(); });
+
+  return result;
+}
+
+} // namespace torrent
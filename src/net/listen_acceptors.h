@@ -0,0 +1,67 @@
+#ifndef LIBTORRENT_NET_LISTEN_ACCEPTORS_H
+#define LIBTORRENT_NET_LISTEN_ACCEPTORS_H
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "torrent/net/types.h"
+#include "torrent/system/callbacks.h"
+#include "utils/mpsc_ring.h"
+
+namespace torrent {
+
+// Accepts incoming connections on a set of SO_REUSEPORT listen sockets
+// bound to the same address, with one thread blocking on each socket.
+//
+// Each wakeup accepts up to 'accept_batch' connections before handing
+// them to the main thread through a lock-free ring, where the accepted
+// slot is called. Connections that do not fit in the ring are closed.
+//
+// The listen sockets are owned by the caller, and must stay open until
+// the acceptors are destroyed.
+
+class ListenAcceptors {
+public:
+  using slot_accepted_type = std::function<void(int fd, const sockaddr* sa)>;
+
+  static constexpr size_t ring_size = 1024;
+
+  ListenAcceptors(const std::vector<int>& listen_fds, unsigned int accept_batch, slot_accepted_type slot_accepted);
+  ~ListenAcceptors();
+
+  size_t              size() const { return m_workers.size(); }
+
+  // Only call from the main thread.
+  void                process_accepted();
+
+private:
+  ListenAcceptors(const ListenAcceptors&) = delete;
+  ListenAcceptors& operator=(const ListenAcceptors&) = delete;
+
+  struct accepted_type {
+    int               fd{-1};
+    sa_inet_union     address{};
+  };
+
+  void                worker_loop(int listen_fd);
+  bool                accept_batch(int listen_fd);
+
+  unsigned int                m_accept_batch;
+  slot_accepted_type          m_slot_accepted;
+
+  int                         m_wakeup_read{-1};
+  int                         m_wakeup_write{-1};
+  std::vector<std::thread>    m_workers;
+
+  utils::MpscRing<accepted_type> m_accepted{ring_size};
+  std::atomic<bool>           m_scheduled{false};
+  std::atomic<unsigned int>   m_dropped{0};
+  std::atomic<int>            m_accept_error{0};
+  system::callback_id         m_callback_id{system::make_callback_id()};
+};
+
+} // namespace torrent
+
+#endif
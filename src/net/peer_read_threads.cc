@@ -0,0 +1,441 @@
+#include "config.h"
+
+#include "net/peer_read_threads.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <unistd.h>
+
+#ifdef USE_EPOLL
+#include <sys/epoll.h>
+#endif
+
+#include "torrent/exceptions.h"
+#include "torrent/net/fd.h"
+#include "torrent/system/callbacks.h"
+#include "torrent/system/types.h"
+#include "torrent/utils/log.h"
+
+#define LT_LOG(log_fmt, ...)                                    \
+  lt_log_print(torrent::LOG_CONNECTION_FD, "peer_read: " log_fmt, __VA_ARGS__);
+
+namespace torrent {
+
+// Events handled per epoll_wait() call.
+static constexpr int worker_max_events = 64;
+
+int
+PeerReadBuffer::read(void* buf, uint32_t length) {
+  std::lock_guard guard(m_lock);
+
+  if (m_size == 0) {
+    if (!m_finished) {
+      errno = EAGAIN;
+      return -1;
+    }
+
+    if (m_error == 0)
+      return 0;
+
+    errno = m_error;
+    return -1;
+  }
+
+  uint32_t count = std::min(length, m_size);
+  uint32_t first = std::min(count, capacity - m_begin);
+
+  std::memcpy(buf, m_data + m_begin, first);
+  std::memcpy(static_cast<char*>(buf) + first, m_data, count - first);
+
+  m_begin = (m_begin + count) % capacity;
+  m_size -= count;
+
+  if (m_paused && m_size <= capacity / 2) {
+    m_paused = false;
+    epoll_add();
+  }
+
+  return count;
+}
+
+bool
+PeerReadBuffer::has_data() {
+  std::lock_guard guard(m_lock);
+
+  return m_size != 0 || m_finished;
+}
+
+// Call with the lock held, so a read thread and the main thread never
+// change the epoll registration of a buffer at the same time.
+void
+PeerReadBuffer::epoll_add() {
+#ifdef USE_EPOLL
+  epoll_event event{};
+  event.events   = EPOLLIN;
+  event.data.ptr = this;
+
+  if (::epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_fd, &event) == -1) {
+    m_finished = true;
+    m_error    = errno;
+  }
+#endif
+}
+
+void
+PeerReadBuffer::epoll_del() {
+#ifdef USE_EPOLL
+  epoll_event event{};
+
+  ::epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, m_fd, &event);
+#endif
+}
+
+PeerReadThreads::PeerReadThreads(unsigned int threads) {
+  if (!is_supported())
+    throw internal_error("PeerReadThreads::PeerReadThreads(): not supported.");
+
+  if (threads == 0)
+    throw internal_error("PeerReadThreads::PeerReadThreads(): no threads.");
+
+  m_task_pending.slot() = [this] { process_pending(); };
+
+  for (unsigned int i = 0; i < threads; i++) {
+    auto worker = std::make_unique<worker_type>();
+
+    fd_open_pipe(worker->wakeup_read, worker->wakeup_write);
+
+    if (!fd_set_nonblock(worker->wakeup_read) || !fd_set_nonblock(worker->wakeup_write))
+      throw internal_error("PeerReadThreads::PeerReadThreads(): could not set wakeup pipe non-blocking.");
+
+#ifdef USE_EPOLL
+    worker->epoll_fd = fd_open_epoll(worker_max_events);
+
+    if (worker->epoll_fd == -1)
+      throw internal_error("PeerReadThreads::PeerReadThreads(): could not open epoll: " + system::errno_enum_str(errno));
+
+    epoll_event event{};
+    event.events   = EPOLLIN;
+    event.data.ptr = nullptr;
+
+    if (::epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, worker->wakeup_read, &event) == -1)
+      throw internal_error("PeerReadThreads::PeerReadThreads(): could not poll wakeup pipe: " + system::errno_enum_str(errno));
+#endif
+
+    m_workers.push_back(std::move(worker));
+  }
+
+  for (auto& worker : m_workers)
+    worker->thread = std::thread(&PeerReadThreads::worker_loop, this, worker.get());
+
+  LT_LOG("started %zu read threads", m_workers.size());
+}
+
+PeerReadThreads::~PeerReadThreads() {
+  if (!m_buffers.empty())
+    LT_LOG("stopping read threads with %zu open buffers", m_buffers.size());
+
+  m_shutdown.store(true);
+
+  for (auto& worker : m_workers) {
+    wakeup(worker.get());
+
+    if (worker->thread.joinable())
+      worker->thread.join();
+  }
+
+  main_thread::cancel_callback(m_callback_id);
+  this_thread::scheduler()->erase(&m_task_pending);
+
+  for (auto& worker : m_workers) {
+    if (worker->epoll_fd != -1)
+      fd_close(worker->epoll_fd);
+
+    fd_close(worker->wakeup_read);
+    fd_close(worker->wakeup_write);
+  }
+
+  LT_LOG("stopped read threads", 0);
+}
+
+bool
+PeerReadThreads::is_supported() {
+#ifdef USE_EPOLL
+  return true;
+#else
+  return false;
+#endif
+}
+
+PeerReadBuffer*
+PeerReadThreads::open(int fd, slot_readable_type slot_readable) {
+  if (fd < 0)
+    throw internal_error("PeerReadThreads::open(): invalid file descriptor.");
+
+  auto& worker = m_workers[fd % m_workers.size()];
+  auto  buffer = std::make_unique<PeerReadBuffer>();
+
+  buffer->m_fd            = fd;
+  buffer->m_epoll_fd      = worker->epoll_fd;
+  buffer->m_id            = ++m_next_id;
+  buffer->m_slot_readable = std::move(slot_readable);
+
+  {
+    std::lock_guard guard(buffer->m_lock);
+    buffer->epoll_add();
+
+    if (buffer->m_finished)
+      throw internal_error("PeerReadThreads::open(): could not poll socket: " + system::errno_enum_str(buffer->m_error));
+  }
+
+  auto result = buffer.get();
+
+  m_buffers.emplace(buffer->m_id, std::move(buffer));
+  return result;
+}
+
+// The buffer is handed to its read thread to be destroyed, as the
+// thread may still be handling an event for it from its last
+// epoll_wait() call.
+void
+PeerReadThreads::close(PeerReadBuffer* buffer) {
+  auto itr = m_buffers.find(buffer->m_id);
+
+  if (itr == m_buffers.end())
+    throw internal_error("PeerReadThreads::close(): buffer not found.");
+
+  {
+    std::lock_guard guard(buffer->m_lock);
+
+    if (!buffer->m_paused && !buffer->m_finished)
+      buffer->epoll_del();
+
+    buffer->m_closed = true;
+  }
+
+  auto& worker = m_workers[buffer->m_fd % m_workers.size()];
+
+  {
+    std::lock_guard guard(worker->lock);
+    worker->retired.push_back(std::move(itr->second));
+  }
+
+  m_buffers.erase(itr);
+  wakeup(worker.get());
+}
+
+void
+PeerReadThreads::insert_read(PeerReadBuffer* buffer) {
+  if (buffer->m_wanted)
+    return;
+
+  buffer->m_wanted = true;
+
+  if (buffer->has_data())
+    schedule_pending(buffer->m_id);
+}
+
+void
+PeerReadThreads::remove_read(PeerReadBuffer* buffer) {
+  buffer->m_wanted = false;
+}
+
+void
+PeerReadThreads::process_readable() {
+  // Clear before draining so buffers notified while draining schedule
+  // a new callback.
+  m_scheduled.store(false);
+
+  std::vector<uint64_t> ids;
+
+  if (m_overflow.exchange(false)) {
+    LT_LOG("readable queue overflowed, checking all %zu buffers", m_buffers.size());
+
+    for (auto& [id, buffer] : m_buffers)
+      ids.push_back(id);
+  }
+
+  uint64_t id;
+
+  while (m_readable.try_pop(id))
+    ids.push_back(id);
+
+  for (auto buffer_id : ids)
+    dispatch_readable(buffer_id);
+}
+
+void
+PeerReadThreads::process_pending() {
+  std::vector<uint64_t> ids;
+  ids.swap(m_pending);
+
+  for (auto buffer_id : ids)
+    dispatch_readable(buffer_id);
+}
+
+// The read threads are not torrent threads, so they must not log or
+// call the fd helpers.
+void
+PeerReadThreads::worker_loop([[maybe_unused]] worker_type* worker) {
+#if defined(HAS_PTHREAD_SETNAME_NP_DARWIN)
+  pthread_setname_np("rtorrent-read");
+#elif defined(HAS_PTHREAD_SETNAME_NP_GENERIC)
+  pthread_setname_np(pthread_self(), "rtorrent-read");
+#endif
+
+#ifdef USE_EPOLL
+  epoll_event events[worker_max_events];
+
+  while (true) {
+    int count = ::epoll_wait(worker->epoll_fd, events, worker_max_events, -1);
+
+    if (count == -1) {
+      if (errno == EINTR)
+        continue;
+
+      throw internal_error("PeerReadThreads::worker_loop(): epoll_wait failed: " + system::errno_enum_str(errno));
+    }
+
+    bool woken = false;
+
+    for (int i = 0; i < count; i++) {
+      auto buffer = static_cast<PeerReadBuffer*>(events[i].data.ptr);
+
+      if (buffer == nullptr) {
+        woken = true;
+        continue;
+      }
+
+      if (receive(buffer))
+        notify_readable(buffer->m_id);
+    }
+
+    if (woken) {
+      char drain[64];
+
+      while (::read(worker->wakeup_read, drain, sizeof(drain)) > 0)
+        ; // Do nothing.
+
+      if (m_shutdown.load())
+        return;
+    }
+
+    // Buffers closed before this point are no longer polled, and any
+    // events for them from the last epoll_wait() have been handled.
+    std::vector<std::unique_ptr<PeerReadBuffer>> retired;
+
+    {
+      std::lock_guard guard(worker->lock);
+      retired.swap(worker->retired);
+    }
+  }
+#endif
+}
+
+// Reads until the socket would block or the buffer is full. Returns
+// true if the main thread should be told about new data, or that the
+// connection is finished.
+bool
+PeerReadThreads::receive(PeerReadBuffer* buffer) {
+  std::lock_guard guard(buffer->m_lock);
+
+  if (buffer->m_closed || buffer->m_paused || buffer->m_finished)
+    return false;
+
+  bool received = false;
+
+  while (buffer->m_size < PeerReadBuffer::capacity) {
+    uint32_t end   = (buffer->m_begin + buffer->m_size) % PeerReadBuffer::capacity;
+    uint32_t space = std::min(PeerReadBuffer::capacity - buffer->m_size, PeerReadBuffer::capacity - end);
+
+    ssize_t result = ::recv(buffer->m_fd, buffer->m_data + end, space, 0);
+
+    if (result > 0) {
+      buffer->m_size += result;
+      received = true;
+      continue;
+    }
+
+    if (result == -1 && errno == EINTR)
+      continue;
+
+    if (result == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      break;
+
+    buffer->m_finished = true;
+    buffer->m_error    = result == 0 ? 0 : errno;
+    break;
+  }
+
+  if (buffer->m_finished) {
+    buffer->epoll_del();
+
+  } else if (buffer->m_size == PeerReadBuffer::capacity) {
+    buffer->m_paused = true;
+    buffer->epoll_del();
+  }
+
+  if ((!received && !buffer->m_finished) || buffer->m_notified)
+    return false;
+
+  buffer->m_notified = true;
+  return true;
+}
+
+void
+PeerReadThreads::notify_readable(uint64_t id) {
+  if (!m_readable.try_push(id))
+    m_overflow.store(true);
+
+  if (!m_scheduled.exchange(true))
+    main_thread::callback(m_callback_id, [this]() { process_readable(); });
+}
+
+// Defers the buffer to the next pass of the main thread's event loop,
+// so a connection that leaves data unread does not starve the others.
+void
+PeerReadThreads::schedule_pending(uint64_t id) {
+  m_pending.push_back(id);
+
+  if (!m_task_pending.is_scheduled())
+    this_thread::scheduler()->wait_for(&m_task_pending, 1us);
+}
+
+void
+PeerReadThreads::dispatch_readable(uint64_t id) {
+  auto itr = m_buffers.find(id);
+
+  if (itr == m_buffers.end())
+    return;
+
+  auto buffer = itr->second.get();
+
+  {
+    std::lock_guard guard(buffer->m_lock);
+    buffer->m_notified = false;
+  }
+
+  if (!buffer->m_wanted || !buffer->has_data())
+    return;
+
+  buffer->m_slot_readable();
+
+  // The slot may have closed the connection.
+  if (m_buffers.find(id) == m_buffers.end())
+    return;
+
+  if (buffer->m_wanted && buffer->has_data())
+    schedule_pending(id);
+}
+
+void
+PeerReadThreads::wakeup(worker_type* worker) {
+  char wakeup = 0;
+
+  // A full pipe already wakes the thread.
+  while (::write(worker->wakeup_write, &wakeup, 1) == -1 && errno == EINTR)
+    ; // Do nothing.
+}
+
+} // namespace torrent
@@ -0,0 +1,146 @@
+#ifndef LIBTORRENT_NET_PEER_READ_THREADS_H
+#define LIBTORRENT_NET_PEER_READ_THREADS_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "torrent/system/callbacks.h"
+#include "torrent/utils/scheduler.h"
+#include "utils/mpsc_ring.h"
+
+namespace torrent {
+
+class PeerReadThreads;
+
+// Data received from a peer socket by a read thread, waiting to be
+// read by the main thread.
+class PeerReadBuffer {
+public:
+  static constexpr uint32_t capacity = 16 << 10;
+
+  // Only call from the main thread. Behaves like recv(), returning
+  // zero once the peer closed the connection and -1 with errno set on
+  // errors or when no data is buffered.
+  int                 read(void* buf, uint32_t length);
+
+private:
+  friend class PeerReadThreads;
+
+  using slot_readable_type = std::function<void()>;
+
+  bool                has_data();
+
+  void                epoll_add();
+  void                epoll_del();
+
+  int                 m_fd{-1};
+  int                 m_epoll_fd{-1};
+  uint64_t            m_id{};
+
+  // Only used by the main thread.
+  bool                m_wanted{};
+  slot_readable_type  m_slot_readable;
+
+  std::mutex          m_lock;
+
+  uint32_t            m_begin{};
+  uint32_t            m_size{};
+  int                 m_error{};
+
+  bool                m_closed{};
+  bool                m_finished{};
+  bool                m_notified{};
+  bool                m_paused{};
+
+  char                m_data[capacity];
+};
+
+// Receives on established peer sockets from a set of threads, each
+// with its own epoll instance, so the main thread no longer pays for
+// the recv() calls. The sockets are assigned to a thread by their
+// file descriptor.
+//
+// A read thread buffers up to PeerReadBuffer::capacity bytes per
+// connection and then stops polling the socket until the main thread
+// has read half of it, so the peer still sees TCP backpressure and the
+// download throttle works as before.
+//
+// The main thread is told which connections got data through a
+// lock-free ring, and calls their readable slot while they want to
+// read. The slot is called again on the next wakeup while data
+// remains, as with level-triggered polling.
+//
+// Everything else about the connection, including writing, stays on
+// the main thread.
+
+class PeerReadThreads {
+public:
+  using slot_readable_type = PeerReadBuffer::slot_readable_type;
+
+  static constexpr size_t ring_size = 4096;
+
+  PeerReadThreads(unsigned int threads);
+  ~PeerReadThreads();
+
+  static bool         is_supported();
+
+  size_t              size() const { return m_workers.size(); }
+
+  // Only call the following from the main thread.
+  //
+  // The socket must stay open until close() is called. The readable
+  // slot is not called until insert_read().
+  PeerReadBuffer*     open(int fd, slot_readable_type slot_readable);
+  void                close(PeerReadBuffer* buffer);
+
+  void                insert_read(PeerReadBuffer* buffer);
+  void                remove_read(PeerReadBuffer* buffer);
+
+  void                process_readable();
+  void                process_pending();
+
+private:
+  PeerReadThreads(const PeerReadThreads&) = delete;
+  PeerReadThreads& operator=(const PeerReadThreads&) = delete;
+
+  struct worker_type {
+    int                  epoll_fd{-1};
+    int                  wakeup_read{-1};
+    int                  wakeup_write{-1};
+    std::thread          thread;
+
+    std::mutex                                   lock;
+    std::vector<std::unique_ptr<PeerReadBuffer>> retired;
+  };
+
+  void                worker_loop(worker_type* worker);
+  bool                receive(PeerReadBuffer* buffer);
+
+  void                notify_readable(uint64_t id);
+  void                schedule_pending(uint64_t id);
+  void                dispatch_readable(uint64_t id);
+
+  static void         wakeup(worker_type* worker);
+
+  std::vector<std::unique_ptr<worker_type>> m_workers;
+  std::atomic<bool>           m_shutdown{false};
+
+  uint64_t                    m_next_id{0};
+  std::unordered_map<uint64_t, std::unique_ptr<PeerReadBuffer>> m_buffers;
+  std::vector<uint64_t>       m_pending;
+  utils::SchedulerEntry       m_task_pending;
+
+  utils::MpscRing<uint64_t>   m_readable{ring_size};
+  std::atomic<bool>           m_scheduled{false};
+  std::atomic<bool>           m_overflow{false};
+  system::callback_id         m_callback_id{system::make_callback_id()};
+};
+
+} // namespace torrent
+
+#endif
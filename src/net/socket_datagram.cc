@@ -3,6 +3,7 @@
 #include "socket_datagram.h"
 
 #include <sys/socket.h>
+#include <sys/uio.h>
 
 #include "torrent/exceptions.h"
 #include "torrent/net/socket_address.h"
@@ -53,4 +54,99 @@ SocketDatagram::write_datagram_sa(const void* buffer, unsigned int length, const
   return r;
 }
 
+int
+SocketDatagram::read_datagrams_sa(read_entry* entries, unsigned int count) {
+  if (count == 0 || count > max_batch)
+    throw internal_error("Tried to receive invalid number of datagrams");
+
+  for (unsigned int i = 0; i < count; i++) {
+    if (entries[i].length == 0)
+      throw internal_error("Tried to receive buffer length 0");
+
+    if (entries[i].address == nullptr)
+      throw internal_error("Tried to receive datagram with NULL sockaddr pointer");
+  }
+
+#ifdef USE_MMSG
+  mmsghdr messages[max_batch]{};
+  iovec   vectors[max_batch];
+
+  for (unsigned int i = 0; i < count; i++) {
+    vectors[i] = iovec{entries[i].buffer, entries[i].length};
+
+    messages[i].msg_hdr.msg_name    = entries[i].address;
+    messages[i].msg_hdr.msg_namelen = entries[i].address_length;
+    messages[i].msg_hdr.msg_iov     = &vectors[i];
+    messages[i].msg_hdr.msg_iovlen  = 1;
+  }
+
+  int r = ::recvmmsg(file_descriptor(), messages, count, 0, nullptr);
+
+  for (int i = 0; i < r; i++) {
+    entries[i].length         = messages[i].msg_len;
+    entries[i].address_length = messages[i].msg_hdr.msg_namelen;
+  }
+
+  return r;
+
+#else
+  for (unsigned int i = 0; i < count; i++) {
+    int r = ::recvfrom(file_descriptor(), entries[i].buffer, entries[i].length, 0, entries[i].address, &entries[i].address_length);
+
+    if (r == -1)
+      return i == 0 ? -1 : static_cast<int>(i);
+
+    entries[i].length = r;
+  }
+
+  return count;
+#endif
+}
+
+int
+SocketDatagram::write_datagrams_sa(write_entry* entries, unsigned int count) {
+  if (count == 0 || count > max_batch)
+    throw internal_error("Tried to send invalid number of datagrams");
+
+  for (unsigned int i = 0; i < count; i++)
+    if (entries[i].length == 0)
+      throw internal_error("Tried to send buffer length 0");
+
+#ifdef USE_MMSG
+  mmsghdr messages[max_batch]{};
+  iovec   vectors[max_batch];
+
+  for (unsigned int i = 0; i < count; i++) {
+    vectors[i] = iovec{const_cast<void*>(entries[i].buffer), entries[i].length};
+
+    if (entries[i].address != nullptr) {
+      messages[i].msg_hdr.msg_name    = const_cast<sockaddr*>(entries[i].address);
+      messages[i].msg_hdr.msg_namelen = sa_length(entries[i].address);
+    }
+
+    messages[i].msg_hdr.msg_iov    = &vectors[i];
+    messages[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  int r = ::sendmmsg(file_descriptor(), messages, count, 0);
+
+  for (int i = 0; i < r; i++)
+    entries[i].length = messages[i].msg_len;
+
+  return r;
+
+#else
+  for (unsigned int i = 0; i < count; i++) {
+    int r = write_datagram_sa(entries[i].buffer, entries[i].length, entries[i].address);
+
+    if (r == -1)
+      return i == 0 ? -1 : static_cast<int>(i);
+
+    entries[i].length = r;
+  }
+
+  return count;
+#endif
+}
+
 } // namespace torrent
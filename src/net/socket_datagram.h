@@ -16,6 +16,30 @@ public:
 
   int                 read_datagram_sa(void* buffer, unsigned int length, sockaddr* from_sa, socklen_t from_length);
   int                 write_datagram_sa(const void* buffer, unsigned int length, const sockaddr* sa);
+
+  // Batched reads and writes use recvmmsg and sendmmsg when available,
+  // otherwise one syscall per datagram. They return the number of
+  // datagrams transferred, or -1 with errno set if the first failed.
+  //
+  // On success 'length' is set to the number of bytes transferred and,
+  // for reads, 'address_length' to the size of the source address.
+  static constexpr unsigned int max_batch = 16;
+
+  struct read_entry {
+    void*               buffer;
+    unsigned int        length;
+    sockaddr*           address;
+    socklen_t           address_length;
+  };
+
+  struct write_entry {
+    const void*         buffer;
+    unsigned int        length;
+    const sockaddr*     address;
+  };
+
+  int                 read_datagrams_sa(read_entry* entries, unsigned int count);
+  int                 write_datagrams_sa(write_entry* entries, unsigned int count);
 };
 
 } // namespace torrent
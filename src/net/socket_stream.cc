@@ -2,12 +2,31 @@
 
 #include "socket_stream.h"
 
+#include <cerrno>
+#include <cstring>
+
+#ifdef USE_SENDFILE
+#include <sys/sendfile.h>
+#endif
+
+#ifdef USE_MSG_ZEROCOPY
+#include <netinet/in.h>
+#include <linux/errqueue.h>
+#endif
+
+#include "net/peer_read_threads.h"
+
 namespace torrent {
 
 char* SocketStream::m_nullBuffer = new char[SocketStream::null_buffer_size];
 
 SocketStream::~SocketStream() = default;
 
+int
+SocketStream::read_buffered(void* buf, uint32_t length) {
+  return m_read_buffer->read(buf, length);
+}
+
 uint32_t
 SocketStream::read_stream_throws(void* buf, uint32_t length) {
   int r = read_stream(buf, length);
@@ -50,4 +69,172 @@ SocketStream::write_stream_throws(const void* buf, uint32_t length) {
   return r;
 }
 
+uint32_t
+SocketStream::write_vector_throws(const iovec* vec, int count) {
+  if (count == 0)
+    throw internal_error("Tried to write vector count 0.");
+
+  ssize_t r = ::writev(file_descriptor(), vec, count);
+
+  if (r == 0)
+    throw close_connection();
+
+  if (r < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+      return 0;
+    else if (errno == ECONNRESET || errno == ECONNABORTED)
+      throw close_connection();
+    else if (errno == EDEADLK)
+      throw blocked_connection();
+    else
+      throw connection_error(errno);
+  }
+
+  return r;
+}
+
+bool
+SocketStream::is_sendfile_supported() {
+#ifdef USE_SENDFILE
+  return true;
+#else
+  return false;
+#endif
+}
+
+uint32_t
+SocketStream::sendfile_stream_throws([[maybe_unused]] int fd, [[maybe_unused]] uint64_t offset, uint32_t length) {
+  if (length == 0)
+    throw internal_error("Tried to sendfile length 0.");
+
+#ifdef USE_SENDFILE
+  off_t   file_offset = offset;
+  ssize_t r = ::sendfile(file_descriptor(), fd, &file_offset, length);
+
+  if (r == 0)
+    throw storage_error("File chunk read error: unexpected end of file");
+
+  if (r < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+      return 0;
+    else if (errno == ECONNRESET || errno == ECONNABORTED)
+      throw close_connection();
+    else if (errno == EDEADLK)
+      throw blocked_connection();
+    else if (errno == EIO || errno == ENOMEM)
+      throw storage_error("File chunk read error: " + std::string(std::strerror(errno)));
+    else
+      throw connection_error(errno);
+  }
+
+  return r;
+#else
+  throw internal_error("SocketStream::sendfile_stream_throws() called but sendfile is not supported.");
+#endif
+}
+
+bool
+SocketStream::is_zerocopy_supported() {
+#ifdef USE_MSG_ZEROCOPY
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool
+SocketStream::try_enable_zerocopy() {
+  if (m_zerocopy != zerocopy_unknown)
+    return m_zerocopy == zerocopy_enabled;
+
+  m_zerocopy = zerocopy_disabled;
+
+#ifdef USE_MSG_ZEROCOPY
+  int opt = 1;
+
+  if (setsockopt(file_descriptor(), SOL_SOCKET, SO_ZEROCOPY, &opt, sizeof(opt)) == 0)
+    m_zerocopy = zerocopy_enabled;
+#endif
+
+  return m_zerocopy == zerocopy_enabled;
+}
+
+uint32_t
+SocketStream::write_zerocopy_throws([[maybe_unused]] const void* buf, uint32_t length) {
+  if (length == 0)
+    throw internal_error("Tried to write zerocopy length 0.");
+
+  if (!is_zerocopy_enabled())
+    throw internal_error("SocketStream::write_zerocopy_throws() called but zerocopy is not enabled.");
+
+#ifdef USE_MSG_ZEROCOPY
+  int r = ::send(file_descriptor(), buf, length, MSG_ZEROCOPY);
+
+  if (r == 0)
+    throw close_connection();
+
+  if (r < 0) {
+    // The socket's option memory limit for pinned pages was reached.
+    if (errno == ENOBUFS)
+      return write_stream_throws(buf, length);
+
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+      return 0;
+    else if (errno == ECONNRESET || errno == ECONNABORTED)
+      throw close_connection();
+    else if (errno == EDEADLK)
+      throw blocked_connection();
+    else
+      throw connection_error(errno);
+  }
+
+  // Every successful send is assigned the next sequence number, even
+  // if the kernel ended up copying the data.
+  m_zerocopy_sent++;
+
+  return r;
+#else
+  throw internal_error("SocketStream::write_zerocopy_throws() called but zerocopy is not supported.");
+#endif
+}
+
+bool
+SocketStream::read_zerocopy_completions() {
+#ifdef USE_MSG_ZEROCOPY
+  while (true) {
+    char    control[128];
+    msghdr  msg{};
+
+    msg.msg_control    = control;
+    msg.msg_controllen = sizeof(control);
+
+    if (::recvmsg(file_descriptor(), &msg, MSG_ERRQUEUE) == -1) {
+      if (errno == EINTR)
+        continue;
+
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      if (!(cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) &&
+          !(cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR))
+        continue;
+
+      sock_extended_err err;
+      std::memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+
+      if (err.ee_origin != SO_EE_ORIGIN_ZEROCOPY || err.ee_errno != 0)
+        return false;
+
+      // Notifications cover the inclusive range [ee_info, ee_data],
+      // and TCP completes sends in order.
+      if (static_cast<int32_t>(err.ee_data + 1 - m_zerocopy_completed) > 0)
+        m_zerocopy_completed = err.ee_data + 1;
+    }
+  }
+#else
+  return false;
+#endif
+}
+
 } // namespace torrent
@@ -3,12 +3,15 @@
 
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 
 #include "torrent/exceptions.h"
 #include "torrent/system/event.h"
 
 namespace torrent {
 
+class PeerReadBuffer;
+
 class SocketStream : public system::Event {
 public:
   ~SocketStream() override;
@@ -21,6 +24,37 @@ public:
   // appropriate exception.
   uint32_t            read_stream_throws(void* buf, uint32_t length);
   uint32_t            write_stream_throws(const void* buf, uint32_t length);
+  uint32_t            write_vector_throws(const iovec* vec, int count);
+
+  // Sends directly from a file descriptor, only call if
+  // is_sendfile_supported() is true. Read errors on the file throw
+  // storage_error.
+  static bool         is_sendfile_supported();
+  uint32_t            sendfile_stream_throws(int fd, uint64_t offset, uint32_t length);
+
+  // Sends with MSG_ZEROCOPY, the memory must not be modified or freed
+  // until is_zerocopy_completed() returns true for zerocopy_sent() as
+  // it was after the send. Completions are read from the socket's
+  // error queue by read_zerocopy_completions(), which returns false if
+  // the queue held anything else.
+  //
+  // Zero-copy is only worth the page pinning overhead for large sends.
+  static constexpr uint32_t zerocopy_min_length = 10 << 10;
+
+  static bool         is_zerocopy_supported();
+
+  bool                is_zerocopy_enabled() const                    { return m_zerocopy == zerocopy_enabled; }
+  bool                is_zerocopy_completed(uint32_t sequence) const { return static_cast<int32_t>(m_zerocopy_completed - sequence) >= 0; }
+
+  // Enables SO_ZEROCOPY on the first call, and returns false if
+  // that failed.
+  bool                try_enable_zerocopy();
+
+  uint32_t            write_zerocopy_throws(const void* buf, uint32_t length);
+  bool                read_zerocopy_completions();
+
+  uint32_t            zerocopy_sent() const                          { return m_zerocopy_sent; }
+  uint32_t            zerocopy_completed() const                     { return m_zerocopy_completed; }
 
   // Handles all the error catching etc. Returns true if the buffer is
   // finished reading/writing.
@@ -33,6 +67,19 @@ protected:
   static constexpr size_t null_buffer_size = 1 << 17;
 
   static char*        m_nullBuffer;
+
+  // When set, reads come from the buffer filled by a peer read thread
+  // instead of the socket.
+  PeerReadBuffer*     m_read_buffer{};
+
+private:
+  enum zerocopy_state { zerocopy_unknown, zerocopy_enabled, zerocopy_disabled };
+
+  int                 read_buffered(void* buf, uint32_t length);
+
+  zerocopy_state      m_zerocopy{zerocopy_unknown};
+  uint32_t            m_zerocopy_sent{0};
+  uint32_t            m_zerocopy_completed{0};
 };
 
 inline bool
@@ -54,6 +101,9 @@ SocketStream::read_stream(void* buf, uint32_t length) {
   if (length == 0)
     throw internal_error("Tried to read to buffer length 0.");
 
+  if (m_read_buffer != nullptr)
+    return read_buffered(buf, length);
+
   return ::recv(file_descriptor(), buf, length, 0);
 }
 
@@ -0,0 +1,136 @@
+#include "config.h"
+
+#include "protocol/encrypt_buffer.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "torrent/exceptions.h"
+
+namespace torrent {
+
+namespace {
+
+constexpr unsigned int
+size_class_count() {
+  unsigned int count = 1;
+
+  for (auto size = EncryptBuffer::min_size; size < EncryptBuffer::max_size; size <<= 1)
+    count++;
+
+  return count;
+}
+
+class encrypt_buffer_pool {
+public:
+  ~encrypt_buffer_pool() { clear(); }
+
+  uint8_t*            allocate(uint32_t size);
+  void                release(uint8_t* buffer, uint32_t size);
+  void                clear();
+
+  size_t              cached() const { return m_cached; }
+
+private:
+  static unsigned int size_class(uint32_t size);
+
+  std::vector<uint8_t*> m_free[size_class_count()];
+  size_t                m_cached{0};
+};
+
+thread_local encrypt_buffer_pool pool;
+
+unsigned int
+encrypt_buffer_pool::size_class(uint32_t size) {
+  if (size < EncryptBuffer::min_size || size > EncryptBuffer::max_size || (size & (size - 1)) != 0)
+    throw internal_error("EncryptBuffer: invalid buffer size.");
+
+  return __builtin_ctz(size) - __builtin_ctz(EncryptBuffer::min_size);
+}
+
+uint8_t*
+encrypt_buffer_pool::allocate(uint32_t size) {
+  auto& free_list = m_free[size_class(size)];
+
+  if (free_list.empty())
+    return new uint8_t[size];
+
+  uint8_t* buffer = free_list.back();
+
+  free_list.pop_back();
+  m_cached -= size;
+
+  return buffer;
+}
+
+void
+encrypt_buffer_pool::release(uint8_t* buffer, uint32_t size) {
+  if (m_cached + size > EncryptBuffer::pool_max_cached) {
+    delete[] buffer;
+    return;
+  }
+
+  m_free[size_class(size)].push_back(buffer);
+  m_cached += size;
+}
+
+void
+encrypt_buffer_pool::clear() {
+  for (auto& free_list : m_free) {
+    for (auto buffer : free_list)
+      delete[] buffer;
+
+    free_list.clear();
+  }
+
+  m_cached = 0;
+}
+
+} // namespace
+
+EncryptBuffer::EncryptBuffer(size_type size) :
+    m_buffer(pool.allocate(size)),
+    m_position(m_buffer),
+    m_end(m_buffer),
+    m_size(size) {
+}
+
+EncryptBuffer::~EncryptBuffer() {
+  pool.release(m_buffer, m_size);
+}
+
+EncryptBuffer::size_type
+EncryptBuffer::size_for(uint32_t rate, uint32_t length) {
+  size_type size   = min_size;
+  size_type target = std::min(rate / 4, length);
+
+  while (size < target && size < max_size)
+    size <<= 1;
+
+  return size;
+}
+
+size_t
+EncryptBuffer::pool_cached() {
+  return pool.cached();
+}
+
+void
+EncryptBuffer::pool_clear() {
+  pool.clear();
+}
+
+void
+EncryptBuffer::reset_size(size_type size) {
+  if (size != m_size) {
+    uint8_t* buffer = pool.allocate(size);
+
+    pool.release(m_buffer, m_size);
+    m_buffer = buffer;
+    m_size   = size;
+  }
+
+  reset();
+}
+
+} // namespace torrent
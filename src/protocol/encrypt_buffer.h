@@ -0,0 +1,80 @@
+#ifndef LIBTORRENT_PROTOCOL_ENCRYPT_BUFFER_H
+#define LIBTORRENT_PROTOCOL_ENCRYPT_BUFFER_H
+
+#include <cinttypes>
+#include <cstddef>
+
+namespace torrent {
+
+// Buffer holding encrypted piece data waiting to be written to an
+// encrypted peer connection.
+//
+// The size is picked from the peer's upload rate so fast peers need
+// fewer syscalls. As the buffer never holds more than a single piece,
+// the largest size matches the largest request we accept.
+//
+// The memory is drawn from a per-thread pool of power of two sized
+// slabs. Connections release the buffer while they have nothing
+// queued to upload, and the pool keeps a limited number of free slabs
+// so the large sizes don't go through mmap and munmap for every piece.
+
+class EncryptBuffer {
+public:
+  using value_type = uint8_t;
+  using iterator   = value_type*;
+  using size_type  = uint32_t;
+
+#if USE_EXTRA_DEBUG == 666
+  // For testing, use a really small buffer.
+  static constexpr size_type min_size = 256;
+  static constexpr size_type max_size = 256;
+#else
+  static constexpr size_type min_size = 4 << 10;
+  static constexpr size_type max_size = 128 << 10;
+#endif
+
+  // Bytes of free slabs each thread's pool may hold on to.
+  static constexpr size_t    pool_max_cached = 4 << 20;
+
+  EncryptBuffer(size_type size);
+  ~EncryptBuffer();
+
+  // Power of two between min_size and max_size that holds about a
+  // quarter of a second of data at 'rate' bytes per second, but not
+  // more than needed for the 'length' bytes left of the piece.
+  static size_type    size_for(uint32_t rate, uint32_t length);
+
+  static size_t       pool_cached();
+  static void         pool_clear();
+
+  void                reset()                       { m_position = m_end = m_buffer; }
+
+  // Resets the buffer and replaces the slab if 'size' differs from
+  // the current size.
+  void                reset_size(size_type size);
+
+  bool                consume(size_type v)          { m_position += v; return remaining() == 0; }
+  size_type           move_end(size_type v)         { m_end += v; return v; }
+
+  iterator            begin()                       { return m_buffer; }
+  iterator            position()                    { return m_position; }
+  iterator            end()                         { return m_end; }
+
+  size_type           size_end() const              { return m_end - m_buffer; }
+  size_type           remaining() const             { return m_end - m_position; }
+  size_type           reserved() const              { return m_size; }
+  size_type           reserved_left() const         { return reserved() - size_end(); }
+
+private:
+  EncryptBuffer(const EncryptBuffer&) = delete;
+  EncryptBuffer& operator=(const EncryptBuffer&) = delete;
+
+  iterator            m_buffer;
+  iterator            m_position;
+  iterator            m_end;
+  size_type           m_size;
+};
+
+} // namespace torrent
+
+#endif
@@ -121,7 +121,7 @@ private:
   // HANDSHAKE.
   uint8_t             m_idMap[extension_count];
 
-  uint32_t            m_maxQueueLength;
+  uint32_t            m_maxQueueLength{0};
 
   // Set HANDSHAKE as enabled and supported. Those bits should not be
   // touched.
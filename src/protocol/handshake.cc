@@ -1061,7 +1061,7 @@ Handshake::event_write() {
 
 void
 Handshake::prepare_key_plus_pad() {
-  if (!m_encryption.initialize())
+  if (!m_encryption.initialize(m_manager->take_key()))
     throw handshake_error(handshake_failed, e_handshake_invalid_value);
 
   m_encryption.key()->store_pub_key(m_writeBuffer.end(), 96);
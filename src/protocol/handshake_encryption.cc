@@ -21,8 +21,8 @@ const unsigned char HandshakeEncryption::dh_generator[] = { 2 };
 const unsigned char HandshakeEncryption::vc_data[] = { 0, 0, 0, 0, 0, 0, 0, 0 };
 
 bool
-HandshakeEncryption::initialize() {
-  m_key = std::make_unique<DiffieHellman>(dh_prime, dh_prime_length, dh_generator, dh_generator_length);
+HandshakeEncryption::initialize(std::unique_ptr<DiffieHellman> key) {
+  m_key = std::move(key);
 
   return m_key->is_valid();
 }
@@ -51,7 +51,7 @@ public:
   unsigned int        length_ia() const                            { return m_lengthIA; }
   void                set_length_ia(unsigned int len)              { m_lengthIA = len; }
 
-  bool                initialize();
+  bool                initialize(std::unique_ptr<DiffieHellman> key);
   void                cleanup();
 
   void                initialize_decrypt(const char* origHash, bool incoming);
@@ -3,6 +3,7 @@
 #include "handshake_manager.h"
 
 #include "handshake.h"
+#include "handshake_encryption.h"
 #include "manager.h"
 #include "peer_connection_base.h"
 #include "download/download_main.h"
@@ -15,11 +16,14 @@
 #include "torrent/runtime/network_config.h"
 #include "torrent/runtime/socket_manager.h"
 #include "torrent/runtime/proxy_manager.h"
+#include "torrent/system/callbacks.h"
 #include "torrent/peer/peer_info.h"
 #include "torrent/peer/client_list.h"
 #include "torrent/peer/connection_list.h"
 #include "torrent/utils/log.h"
 #include "torrent/utils/string_manip.h"
+#include "utils/diffie_hellman.h"
+#include "utils/diffie_hellman_pool.h"
 
 #define LT_LOG_SA(sa, log_fmt, ...)                                     \
   lt_log_print(LOG_CONNECTION_HANDSHAKE, "handshake_manager->%s: " log_fmt, sa_addr_str(sa).c_str(), __VA_ARGS__);
@@ -38,9 +42,20 @@ bool filter_sockaddr(const sockaddr* sa);
 
 ProtocolExtension HandshakeManager::DefaultExtensions = ProtocolExtension::make_default();
 
-HandshakeManager::HandshakeManager() = default;
+HandshakeManager::HandshakeManager() :
+    m_key_pool(std::make_unique<DiffieHellmanPool>(HandshakeEncryption::dh_prime, HandshakeEncryption::dh_prime_length,
+                                                   HandshakeEncryption::dh_generator, HandshakeEncryption::dh_generator_length)) {
+  update_key_reserve();
+
+  runtime::network_config()->subscribe_to_changes(this, [this]() {
+      main_thread::callback(m_key_reserve_callback_id, [this]() { update_key_reserve(); });
+    });
+}
 
 HandshakeManager::~HandshakeManager() {
+  runtime::network_config()->unsubscribe_from_changes(this);
+  main_thread::cancel_callback(m_key_reserve_callback_id);
+
   clear();
 }
 
@@ -203,6 +218,16 @@ HandshakeManager::create_outgoing(const sockaddr* sa, DownloadMain* download, co
   base_type::push_back(std::move(handshake));
 }
 
+std::unique_ptr<DiffieHellman>
+HandshakeManager::take_key() {
+  return m_key_pool->take();
+}
+
+void
+HandshakeManager::update_key_reserve() {
+  m_key_pool->set_reserve(runtime::network_config()->encryption_key_reserve());
+}
+
 void
 HandshakeManager::receive_succeeded(Handshake* ptr) {
   if (!ptr->is_active())
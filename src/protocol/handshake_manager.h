@@ -2,13 +2,17 @@
 #define LIBTORRENT_NET_HANDSHAKE_MANAGER_H
 
 #include <functional>
+#include <memory>
 #include <string>
 
 #include "torrent/common.h"
+#include "torrent/system/callbacks.h"
 #include "torrent/utils/unordered_vector.h"
 
 namespace torrent {
 
+class DiffieHellman;
+class DiffieHellmanPool;
 class EncryptionPolicy;
 
 class HandshakeManager : private utils::unordered_vector<std::unique_ptr<Handshake>> {
@@ -44,6 +48,10 @@ public:
   DownloadMain*       download_info(const char* hash)                   { return m_slot_download_id(hash); }
   DownloadMain*       download_info_obfuscated(const char* hash)        { return m_slot_download_obfuscated(hash); }
 
+  // Takes a pre-generated key from the pool when available. The pool
+  // reserve follows NetworkConfig, and is updated when it changes.
+  std::unique_ptr<DiffieHellman> take_key();
+
   void                receive_succeeded(Handshake* h);
   void                receive_failed(Handshake* h, int message, int error);
   void                receive_timeout(Handshake* h);
@@ -58,10 +66,15 @@ private:
 
   value_type          find_and_erase(Handshake* handshake);
 
+  void                update_key_reserve();
+
   static ProtocolExtension DefaultExtensions;
 
   slot_download       m_slot_download_id;
   slot_download       m_slot_download_obfuscated;
+
+  std::unique_ptr<DiffieHellmanPool> m_key_pool;
+  system::callback_id                m_key_reserve_callback_id{system::make_callback_id()};
 };
 
 } // namespace torrent
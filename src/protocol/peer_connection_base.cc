@@ -2,6 +2,7 @@
 
 #include "peer_connection_base.h"
 
+#include <algorithm>
 #include <cstdio>
 
 #include "manager.h"
@@ -10,9 +11,11 @@
 #include "download/chunk_selector.h"
 #include "download/chunk_statistics.h"
 #include "download/download_main.h"
+#include "net/peer_read_threads.h"
 // #include "torrent/chunk_manager.h"
 #include "torrent/exceptions.h"
 #include "torrent/throttle.h"
+#include "torrent/data/file.h"
 #include "torrent/data/block.h"
 #include "torrent/download/choke_group.h"
 #include "torrent/download/choke_queue.h"
@@ -30,6 +33,24 @@
 
 namespace torrent {
 
+namespace {
+
+instrumentation_enum
+pipe_depth_bucket(uint32_t size) {
+  if (size <= 8)
+    return INSTRUMENTATION_TRANSFER_PIPE_DEPTH_8;
+  else if (size <= 32)
+    return INSTRUMENTATION_TRANSFER_PIPE_DEPTH_32;
+  else if (size <= 128)
+    return INSTRUMENTATION_TRANSFER_PIPE_DEPTH_128;
+  else if (size <= 512)
+    return INSTRUMENTATION_TRANSFER_PIPE_DEPTH_512;
+  else
+    return INSTRUMENTATION_TRANSFER_PIPE_DEPTH_LARGE;
+}
+
+} // namespace
+
 static void
 log_mincore_stats_func(bool is_incore, bool new_index, bool& continous) {
   if (!new_index && is_incore) {
@@ -102,7 +123,7 @@ PeerConnectionBase::initialize(DownloadMain* download, PeerInfo* peerInfo, int f
   m_peerChunks.upload_throttle()->slot_activate() = [this] { this_thread::poll()->insert_write(this); };
 
   m_peerChunks.download_throttle()->set_list_iterator(m_down->throttle()->end());
-  m_peerChunks.download_throttle()->slot_activate() = [this] { this_thread::poll()->insert_read(this); };
+  m_peerChunks.download_throttle()->slot_activate() = [this] { poll_insert_read(); };
 
   request_list()->set_delegator(m_download->delegator());
   request_list()->set_peer_chunks(&m_peerChunks);
@@ -121,7 +142,13 @@ PeerConnectionBase::initialize(DownloadMain* download, PeerInfo* peerInfo, int f
   }
 
   this_thread::poll()->open(this);
-  this_thread::poll()->insert_read(this);
+
+  m_read_threads = manager->peer_read_threads();
+
+  if (m_read_threads != nullptr)
+    m_read_buffer = m_read_threads->open(file_descriptor(), [this] { event_read(); });
+
+  poll_insert_read();
   this_thread::poll()->insert_write(this);
 
   m_time_last_read = this_thread::cached_time();
@@ -151,6 +178,7 @@ PeerConnectionBase::cleanup() {
   m_request_list.clear();
 
   up_chunk_release();
+  up_zerocopy_release(true);
   down_chunk_release();
 
   m_download->info()->set_upload_unchoked(m_download->info()->upload_unchoked() - m_upChoke.unchoked());
@@ -164,12 +192,19 @@ PeerConnectionBase::cleanup() {
     m_extensions->cleanup();
 
   runtime::socket_manager()->close_event_or_throw(this, [this]() {
+      if (m_read_buffer != nullptr) {
+        m_read_threads->close(m_read_buffer);
+        m_read_buffer = nullptr;
+      }
+
       this_thread::poll()->remove_and_close(this);
 
       fd_close(file_descriptor());
       reset_file_descriptor();
     });
 
+  m_read_threads.reset();
+
   m_up->throttle()->erase(m_peerChunks.upload_throttle());
   m_down->throttle()->erase(m_peerChunks.download_throttle());
 
@@ -179,6 +214,22 @@ PeerConnectionBase::cleanup() {
   m_download = NULL;
 }
 
+void
+PeerConnectionBase::poll_insert_read() {
+  if (m_read_buffer != nullptr)
+    m_read_threads->insert_read(m_read_buffer);
+  else
+    this_thread::poll()->insert_read(this);
+}
+
+void
+PeerConnectionBase::poll_remove_read() {
+  if (m_read_buffer != nullptr)
+    m_read_threads->remove_read(m_read_buffer);
+  else
+    this_thread::poll()->remove_read(this);
+}
+
 void
 PeerConnectionBase::set_upload_snubbed(bool v) {
   if (v)
@@ -318,10 +369,8 @@ PeerConnectionBase::load_up_chunk() {
   if (!m_upChunk.is_valid())
     throw storage_error("File chunk read error: " + std::string(std::strerror(m_upChunk.error_number())));
 
-  if (is_encrypted() && m_encryptBuffer == nullptr) {
-    m_encryptBuffer = std::make_unique<EncryptBuffer>();
-    m_encryptBuffer->reset();
-  }
+  if (is_encrypted() && m_encryptBuffer == nullptr)
+    m_encryptBuffer = std::make_unique<EncryptBuffer>(EncryptBuffer::size_for(m_peerChunks.upload_throttle()->rate()->rate(), m_upPiece.length()));
 
   m_incoreContinous = false;
 
@@ -373,6 +422,7 @@ PeerConnectionBase::cancel_transfer(BlockTransfer* transfer) {
   write_insert_poll_safe();
 
   m_peerChunks.cancel_queue()->push_back(transfer->piece());
+  instrumentation_update(INSTRUMENTATION_TRANSFER_REQUESTS_CANCELLED, 1);
 }
 
 void
@@ -380,6 +430,20 @@ PeerConnectionBase::event_error() {
   m_download->connection_list()->erase(this, 0);
 }
 
+bool
+PeerConnectionBase::event_error_queue() {
+  if (!is_zerocopy_enabled() || !read_zerocopy_completions())
+    return false;
+
+  int error = 0;
+
+  if (!fd_get_socket_error(file_descriptor(), &error) || error != 0)
+    return false;
+
+  up_zerocopy_release(false);
+  return true;
+}
+
 bool
 PeerConnectionBase::should_connection_unchoke(choke_queue* cq) const {
   if (cq == m_download->choke_group()->up_queue())
@@ -438,6 +502,11 @@ PeerConnectionBase::down_chunk_finished() {
     if (!m_downChunk.is_valid())
       throw internal_error("PeerConnectionBase::down_chunk_finished() Transfer is the leader, but no chunk allocated.");
 
+    // Hash the leading finished blocks while the data is still in
+    // cache, before finished() possibly queues the completed chunk.
+    m_download->hash_incremental()->update(transfer->index(), m_downChunk.chunk(),
+                                           HashIncremental::finished_length(transfer->block()->parent()));
+
     request_list()->finished();
     m_downChunk.object()->set_time_modified(this_thread::cached_time());
 
@@ -477,7 +546,7 @@ PeerConnectionBase::down_chunk() {
   uint32_t quota = m_down->throttle()->node_quota(m_peerChunks.download_throttle());
 
   if (quota == 0) {
-    this_thread::poll()->remove_read(this);
+    poll_remove_read();
     m_down->throttle()->node_deactivate(m_peerChunks.download_throttle());
     return false;
   }
@@ -532,7 +601,7 @@ PeerConnectionBase::down_chunk_skip() {
   uint32_t quota = throttle->node_quota(m_peerChunks.download_throttle());
 
   if (quota == 0) {
-    this_thread::poll()->remove_read(this);
+    poll_remove_read();
     throttle->node_deactivate(m_peerChunks.download_throttle());
     return false;
   }
@@ -597,6 +666,7 @@ PeerConnectionBase::down_chunk_skip_process(const void* buffer, uint32_t length)
   m_download->info()->mutable_skip_rate()->insert(length);
 
   if (!transfer->is_valid()) {
+    instrumentation_update(INSTRUMENTATION_TRANSFER_WASTED_BYTES, length);
     transfer->adjust_position(length);
     return length;
   }
@@ -618,12 +688,15 @@ PeerConnectionBase::down_chunk_skip_process(const void* buffer, uint32_t length)
     LT_LOG_PIECE_EVENTS("(down) download_data_mismatch %" PRIu32 " %" PRIu32 " %" PRIu32,
                         transfer->piece().index(), transfer->piece().offset(), transfer->piece().length());
 
+    instrumentation_update(INSTRUMENTATION_TRANSFER_WASTED_BYTES, length);
+
     m_request_list.transfer_dissimilar();
     m_request_list.transfer()->adjust_position(length);
 
     return length;
   }
 
+  instrumentation_update(INSTRUMENTATION_TRANSFER_WASTED_BYTES, compareLength);
   transfer->adjust_position(compareLength);
 
   if (compareLength == length)
@@ -663,13 +736,34 @@ PeerConnectionBase::down_extension() {
   // If extension can't be processed yet (due to a pending write),
   // disable reads until the pending message is completely sent.
   if (m_extensions->is_complete() && !m_extensions->is_invalid() && !m_extensions->read_done()) {
-    this_thread::poll()->remove_read(this);
+    poll_remove_read();
     return false;
   }
 
   return m_extensions->is_complete();
 }
 
+// Returns the descriptor to sendfile the part from, or -1 if it must
+// be written from memory. Modified buffered parts might not have been
+// written back yet, while mapped parts share the page cache.
+static int
+upload_file_descriptor(ChunkPart* part) {
+  switch (part->mapped()) {
+  case ChunkPart::MAPPED_MMAP:
+    if (part->file() == nullptr || part->file()->is_padding() || !part->file()->is_open() ||
+        !part->file()->has_permissions(MemoryChunk::prot_read))
+      return -1;
+
+    return part->file()->file_descriptor();
+
+  case ChunkPart::MAPPED_BUFFER:
+    return part->chunk().is_writable() ? -1 : part->file_descriptor();
+
+  default:
+    return -1;
+  }
+}
+
 inline uint32_t
 PeerConnectionBase::up_chunk_encrypt(uint32_t quota) {
   if (m_encryptBuffer == nullptr)
@@ -683,8 +777,9 @@ PeerConnectionBase::up_chunk_encrypt(uint32_t quota) {
   // outweigh the extra context switches, etc.
 
   if (m_encryptBuffer->remaining() == 0) {
-    // This handles reset also for new chunk transfers.
-    m_encryptBuffer->reset();
+    // This handles reset also for new chunk transfers, and follows
+    // changes in the upload rate while the buffer is empty.
+    m_encryptBuffer->reset_size(EncryptBuffer::size_for(m_peerChunks.upload_throttle()->rate()->rate(), m_upPiece.length()));
 
     quota = std::min<uint32_t>(quota, m_encryptBuffer->reserved());
 
@@ -692,9 +787,17 @@ PeerConnectionBase::up_chunk_encrypt(uint32_t quota) {
     quota = std::min<uint32_t>(quota - m_encryptBuffer->remaining(), m_encryptBuffer->reserved_left());
   }
 
-  m_upChunk.chunk()->to_buffer(m_encryptBuffer->end(), m_upPiece.offset() + m_encryptBuffer->remaining(), quota);
-  m_encryption.encrypt(m_encryptBuffer->end(), quota);
-  m_encryptBuffer->move_end(quota);
+  // Encrypt directly from the chunk parts into the buffer, rather than
+  // copying the plaintext first and encrypting it in place.
+  uint32_t position = m_upPiece.offset() + m_encryptBuffer->remaining();
+  ChunkIterator itr(m_upChunk.chunk(), position, position + quota);
+
+  do {
+    Chunk::data_type data = itr.data();
+
+    m_encryption.encrypt(data.first, m_encryptBuffer->end(), data.second);
+    m_encryptBuffer->move_end(data.second);
+  } while (itr.next());
 
   return m_encryptBuffer->remaining();
 }
@@ -730,9 +833,23 @@ PeerConnectionBase::up_chunk() {
     Chunk::data_type data;
     ChunkIterator itr(m_upChunk.chunk(), m_upPiece.offset(), m_upPiece.offset() + std::min(quota, m_upPiece.length()));
 
+    bool use_sendfile = runtime::memory_manager()->upload_sendfile();
+    bool use_zerocopy = runtime::memory_manager()->upload_zerocopy() && try_enable_zerocopy();
+
+    if (use_zerocopy && !m_upZerocopyChunks.empty() && read_zerocopy_completions())
+      up_zerocopy_release(false);
+
     do {
       data = itr.data();
-      data.second = write_stream_throws(data.first, data.second);
+
+      int fd = use_sendfile ? upload_file_descriptor(itr.chunk_part()) : -1;
+
+      if (fd != -1)
+        data.second = sendfile_stream_throws(fd, itr.chunk_part()->file_offset() + itr.memory_chunk_first(), data.second);
+      else if (use_zerocopy && data.second >= zerocopy_min_length && itr.chunk_part()->mapped() == ChunkPart::MAPPED_MMAP)
+        data.second = write_zerocopy_throws(data.first, data.second);
+      else
+        data.second = write_stream_throws(data.first, data.second);
 
       bytesTransfered += data.second;
 
@@ -750,6 +867,64 @@ PeerConnectionBase::up_chunk() {
   return m_upPiece.length() == 0;
 }
 
+// Piece data can be written together with the message buffer when
+// it doesn't need to pass through the encrypt buffer, sendfile or
+// zero-copy sends.
+bool
+PeerConnectionBase::can_write_vectored() const {
+  return !is_encrypted() &&
+    !runtime::memory_manager()->upload_sendfile() &&
+    !runtime::memory_manager()->upload_zerocopy() &&
+    m_up->throttle()->is_throttled(m_peerChunks.upload_throttle());
+}
+
+// Writes the remaining message buffer, which ends with the PIECE
+// header, and as much of the piece as the quota allows with a single
+// writev. Returns true if the message buffer was completely written.
+bool
+PeerConnectionBase::up_chunk_vectored() {
+  static constexpr int max_vector = 8;
+
+  if (!m_upChunk.chunk()->is_readable())
+    throw internal_error("PeerConnectionBase::up_chunk_vectored() chunk not readable, permission denided");
+
+  uint32_t header = m_up->buffer()->remaining();
+  uint32_t quota  = std::min(m_up->throttle()->node_quota(m_peerChunks.upload_throttle()), m_upPiece.length());
+
+  iovec vec[max_vector];
+  int   count = 0;
+
+  vec[count++] = { m_up->buffer()->position(), header };
+
+  if (quota != 0) {
+    ChunkIterator itr(m_upChunk.chunk(), m_upPiece.offset(), m_upPiece.offset() + quota);
+
+    do {
+      Chunk::data_type data = itr.data();
+      vec[count++] = { data.first, data.second };
+    } while (count != max_vector && itr.next());
+  }
+
+  uint32_t written        = write_vector_throws(vec, count);
+  uint32_t header_written = std::min(written, header);
+  uint32_t piece_written  = written - header_written;
+
+  m_up->buffer()->consume(m_up->throttle()->node_used_unthrottled(header_written));
+
+  if (piece_written != 0) {
+    m_up->throttle()->node_used(m_peerChunks.upload_throttle(), piece_written);
+    m_download->info()->mutable_up_rate()->insert(piece_written);
+
+    m_upPiece.set_offset(m_upPiece.offset() + piece_written);
+    m_upPiece.set_length(m_upPiece.length() - piece_written);
+  }
+
+  instrumentation_update(INSTRUMENTATION_TRANSFER_UPLOAD_VECTORED_WRITES, 1);
+  instrumentation_update(INSTRUMENTATION_TRANSFER_UPLOAD_VECTORED_PARTS, count);
+
+  return header_written == header;
+}
+
 bool
 PeerConnectionBase::up_extension() {
   if (m_extensionOffset == extension_must_encrypt) {
@@ -784,7 +959,7 @@ PeerConnectionBase::up_extension() {
     if (!m_extensions->read_done())
       throw internal_error("PeerConnectionBase::up_extension could not process complete extension message.");
 
-    this_thread::poll()->insert_read(this);
+    poll_insert_read();
   }
 
   return true;
@@ -798,8 +973,41 @@ PeerConnectionBase::down_chunk_release() {
 
 void
 PeerConnectionBase::up_chunk_release() {
-  if (m_upChunk.is_valid())
-    m_download->chunk_list()->release(&m_upChunk, ChunkList::release_default);
+  if (!m_upChunk.is_valid())
+    return;
+
+  // The kernel might still be reading from the chunk's pages.
+  if (is_zerocopy_enabled() && !is_zerocopy_completed(zerocopy_sent())) {
+    m_upZerocopyChunks.emplace_back(zerocopy_sent(), m_upChunk);
+    m_upChunk.clear();
+    return;
+  }
+
+  m_download->chunk_list()->release(&m_upChunk, ChunkList::release_default);
+}
+
+// When forced, e.g. on disconnect, the chunks are released regardless
+// as only mapped parts are sent with zero-copy and the kernel keeps
+// its own references to the pages.
+void
+PeerConnectionBase::up_zerocopy_release(bool force) {
+  while (!m_upZerocopyChunks.empty() && (force || is_zerocopy_completed(m_upZerocopyChunks.front().first))) {
+    m_download->chunk_list()->release(&m_upZerocopyChunks.front().second, ChunkList::release_default);
+    m_upZerocopyChunks.pop_front();
+  }
+}
+
+// Returns the encrypt buffer to the pool, it is allocated again by
+// load_up_chunk() once there's a piece to upload.
+void
+PeerConnectionBase::up_encrypt_release() {
+  if (m_encryptBuffer == nullptr)
+    return;
+
+  if (m_encryptBuffer->remaining())
+    throw internal_error("Deleting encryptBuffer with encrypted data remaining.");
+
+  m_encryptBuffer = nullptr;
 }
 
 void
@@ -902,6 +1110,19 @@ PeerConnectionBase::try_request_pieces() {
 
   uint32_t pipeSize = request_list()->calculate_pipe_size(m_peerChunks.download_throttle()->rate()->rate());
 
+  // Requests beyond the queue length the peer advertised may get
+  // dropped, which the adaptive pipe size can easily reach.
+  if (m_download->delegator()->is_adaptive_pipelining() && m_extensions->max_queue_length() != 0)
+    pipeSize = std::min(pipeSize, m_extensions->max_queue_length());
+
+  if (pipeSize != m_downPipeSize) {
+    LT_LOG_PIECE_EVENTS("(down) pipe_size %" PRIu32 " rtt_usec %" PRIi64 " delivery_rate %" PRIu64,
+                        pipeSize, static_cast<int64_t>(request_list()->rtt().count()), request_list()->delivery_rate());
+    m_downPipeSize = pipeSize;
+  }
+
+  instrumentation_update(pipe_depth_bucket(pipeSize), 1);
+
   // Don't start requesting if we can't do it in large enough chunks.
   if (request_list()->pipe_size() >= (pipeSize + 10) / 2)
     return false;
@@ -916,6 +1137,17 @@ PeerConnectionBase::try_request_pieces() {
     int maxPieces = std::max(std::min(maxRequests, maxQueued), 1);
 
     std::vector<const Piece*> pieces = request_list()->delegate(maxPieces);
+
+    // Running out of blocks to request is when end-game is likely to
+    // be needed, so check it here rather than wait for the next chunk
+    // to complete. This walks all connections, so it is rate limited.
+    if (pieces.empty() && !m_download->delegator()->get_aggressive()) {
+      m_download->try_update_endgame();
+
+      if (m_download->delegator()->get_aggressive())
+        pieces = request_list()->delegate(maxPieces);
+    }
+
     if (pieces.empty()) {
       return false;
     }
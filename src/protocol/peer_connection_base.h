@@ -1,9 +1,12 @@
 #ifndef LIBTORRENT_PROTOCOL_PEER_CONNECTION_BASE_H
 #define LIBTORRENT_PROTOCOL_PEER_CONNECTION_BASE_H
 
+#include <deque>
+
 #include "thread_main.h"
 #include "data/chunk_handle.h"
 #include "net/socket_stream.h"
+#include "protocol/encrypt_buffer.h"
 #include "protocol/encryption_info.h"
 #include "protocol/extensions.h"
 #include "protocol/peer_chunks.h"
@@ -24,19 +27,13 @@ namespace torrent {
 
 class choke_queue;
 class DownloadMain;
+class PeerReadThreads;
 
 class PeerConnectionBase : public Peer, public SocketStream {
 public:
   using ProtocolRead  = ProtocolBase;
   using ProtocolWrite = ProtocolBase;
 
-#if USE_EXTRA_DEBUG == 666
-  // For testing, use a really small buffer.
-  typedef ProtocolBuffer<256>  EncryptBuffer;
-#else
-  using EncryptBuffer = ProtocolBuffer<16384>;
-#endif
-
   // Bitmasks for peer exchange messages to send.
   static constexpr int PEX_DO      = (1 << 0);
   static constexpr int PEX_ENABLE  = (1 << 1);
@@ -94,6 +91,7 @@ public:
   bool                receive_download_choke(bool choke);
 
   void                event_error() override;
+  bool                event_error_queue() override;
 
   void                push_unread(const void* data, uint32_t size);
 
@@ -103,6 +101,11 @@ public:
   void                read_insert_poll_safe();
   void                write_insert_poll_safe();
 
+  // Use these instead of the poll's read functions, as the reads may
+  // be done by PeerReadThreads.
+  void                poll_insert_read();
+  void                poll_remove_read();
+
   // Communication with the protocol extensions
   virtual void        receive_metadata_piece(uint32_t piece, const char* data, uint32_t length);
 
@@ -136,12 +139,17 @@ protected:
   bool                down_extension();
 
   bool                up_chunk();
+  bool                up_chunk_vectored();
   inline uint32_t     up_chunk_encrypt(uint32_t quota);
 
+  bool                can_write_vectored() const;
+
   bool                up_extension();
 
   void                down_chunk_release();
   void                up_chunk_release();
+  void                up_zerocopy_release(bool force);
+  void                up_encrypt_release();
 
   bool                should_request();
   bool                try_request_pieces();
@@ -159,10 +167,15 @@ protected:
   RequestList         m_request_list;
   ChunkHandle         m_downChunk;
   uint32_t            m_downStall{0};
+  uint32_t            m_downPipeSize{0};
 
   Piece               m_upPiece;
   ChunkHandle         m_upChunk;
 
+  // Released chunks with zero-copy sends still referencing them, and
+  // the send sequence that must complete before releasing.
+  std::deque<std::pair<uint32_t, ChunkHandle>> m_upZerocopyChunks;
+
   // The interested state no longer follows the spec's wording as it
   // has been swapped.
   //
@@ -187,6 +200,8 @@ protected:
 
   std::chrono::microseconds m_time_last_read{};
 
+  std::shared_ptr<PeerReadThreads> m_read_threads;
+
   DataBuffer          m_extensionMessage;
   uint32_t            m_extensionOffset;
 
@@ -222,7 +237,7 @@ PeerConnectionBase::read_insert_poll_safe() {
   if (m_down->get_state() != ProtocolRead::IDLE)
     return;
 
-  this_thread::poll()->insert_read(this);
+  poll_insert_read();
 }
 
 inline void
@@ -500,13 +500,7 @@ PeerConnection<type>::fill_write_buffer() {
       m_up->throttle()->erase(m_peerChunks.upload_throttle());
       up_chunk_release();
       m_peerChunks.upload_queue()->clear();
-
-      if (m_encryptBuffer != nullptr) {
-        if (m_encryptBuffer->remaining())
-          throw internal_error("Deleting encryptBuffer with encrypted data remaining.");
-
-        m_encryptBuffer = nullptr;
-      }
+      up_encrypt_release();
 
     } else {
       m_up->throttle()->insert(m_peerChunks.upload_throttle());
@@ -522,6 +516,14 @@ PeerConnection<type>::fill_write_buffer() {
     m_sendInterested = false;
   }
 
+  // Cancels go out before any new requests, so peers holding
+  // requests for blocks completed elsewhere stop sending them as soon
+  // as possible.
+  while (type == Download::CONNECTION_LEECH && !m_peerChunks.cancel_queue()->empty() && m_up->can_write_cancel()) {
+    m_up->write_cancel(m_peerChunks.cancel_queue()->front());
+    m_peerChunks.cancel_queue()->pop_front();
+  }
+
   if (type == Download::CONNECTION_LEECH && m_tryRequest) {
     if (!(m_tryRequest = !should_request()) &&
         !(m_tryRequest = try_request_pieces()) &&
@@ -555,11 +557,6 @@ PeerConnection<type>::fill_write_buffer() {
   if (type == Download::CONNECTION_INITIAL_SEED && m_up->can_write_have())
     offer_chunk();
 
-  while (type == Download::CONNECTION_LEECH && !m_peerChunks.cancel_queue()->empty() && m_up->can_write_cancel()) {
-    m_up->write_cancel(m_peerChunks.cancel_queue()->front());
-    m_peerChunks.cancel_queue()->pop_front();
-  }
-
   if (m_sendPEXMask && m_up->can_write_extension() &&
       send_pex_message()) {
     // Don't do anything else if send_pex_message() succeeded.
@@ -592,6 +589,10 @@ PeerConnection<type>::event_write() {
         fill_write_buffer();
 
         if (m_up->buffer()->remaining() == 0) {
+          // Idle encrypted peers shouldn't hold on to a buffer.
+          if (m_peerChunks.upload_queue()->empty())
+            up_encrypt_release();
+
           this_thread::poll()->remove_write(this);
           return;
         }
@@ -600,6 +601,19 @@ PeerConnection<type>::event_write() {
 
 	[[fallthrough]];
       case ProtocolWrite::MSG:
+        // Write the PIECE header together with the start of the piece
+        // to avoid an extra syscall and a small segment per block.
+        if (m_up->last_command() == ProtocolBase::PIECE && can_write_vectored()) {
+          load_up_chunk();
+
+          if (!up_chunk_vectored())
+            return;
+
+          m_up->buffer()->reset();
+          m_up->set_state(m_upPiece.length() == 0 ? ProtocolWrite::IDLE : ProtocolWrite::WRITE_PIECE);
+          break;
+        }
+
         if (!m_up->buffer()->consume(m_up->throttle()->node_used_unthrottled(write_stream_throws(m_up->buffer()->position(), m_up->buffer()->remaining()))))
           return;
 
@@ -86,11 +86,21 @@ RequestList::delegate(uint32_t maxPieces) {
 
   instrumentation_update(INSTRUMENTATION_TRANSFER_REQUESTS_DELEGATED, transfers.size());
 
+  // Only the first request sent with nothing ahead of it measures the
+  // round-trip time, the rest also wait for the pieces before them.
+  bool idle = m_transfer == nullptr && queued_empty() && unordered_empty();
+
   for (auto transfer : transfers) {
     m_queues.push_back(bucket_queued, transfer);
     pieces.push_back(&transfer->piece());
+
+    m_request_times.push_back(request_time{transfer->piece(), this_thread::cached_time(), idle});
+    idle = false;
   }
 
+  while (m_request_times.size() > pipe_max_size)
+    m_request_times.pop_front();
+
   // Use the last index returned for the next affinity
   m_affinity = transfers.back()->index();
 
@@ -125,6 +135,10 @@ RequestList::choked() {
 
   m_last_choke = torrent::this_thread::cached_time();
 
+  // Requests sent before a choke may be answered much later, if at
+  // all.
+  m_request_times.clear();
+
   if (m_queues.queue_empty(bucket_queued) && m_queues.queue_empty(bucket_unordered))
     return;
 
@@ -195,6 +209,8 @@ RequestList::clear() {
   m_queues.clear(bucket_unordered);
   m_queues.clear(bucket_stalled);
   m_queues.clear(bucket_choked);
+
+  m_request_times.clear();
 }
 
 bool
@@ -204,6 +220,8 @@ RequestList::downloading(const Piece& piece) {
 
   instrumentation_update(INSTRUMENTATION_TRANSFER_REQUESTS_DOWNLOADING, 1);
 
+  update_rtt(piece);
+
   std::pair<int, queues_type::iterator> itr =
     queue_bucket_find_if_in_any(m_queues, request_list_same_piece(piece));
 
@@ -287,6 +305,7 @@ RequestList::finished() {
   BlockTransfer* transfer = m_transfer;
   m_transfer = nullptr;
 
+  m_delivery_rate.insert(transfer->piece().length());
   m_delegator->transfer_list()->finished(transfer);
 
   instrumentation_update(INSTRUMENTATION_TRANSFER_REQUESTS_FINISHED, 1);
@@ -297,6 +316,8 @@ RequestList::skipped() {
   if (!is_downloading())
     throw internal_error("RequestList::skip() called but no transfer is in progress.");
 
+  m_delivery_rate.insert(m_transfer->position());
+
   Block::release(m_transfer);
   m_transfer = nullptr;
 
@@ -329,20 +350,49 @@ RequestList::is_interested_in_active() const {
 uint32_t
 RequestList::calculate_pipe_size(uint32_t rate) {
   // Change into KB.
-  rate /= 1024;
-
-  if (!m_delegator->get_aggressive()) {
-    if (rate < 20)
-      return rate + 2;
-    else
-      return rate / 5 + 18;
+  uint32_t rate_kb = rate / 1024;
 
-  } else {
-    if (rate < 10)
-      return rate / 5 + 1;
+  if (m_delegator->get_aggressive()) {
+    if (rate_kb < 10)
+      return rate_kb / 5 + 1;
     else
-      return rate / 10 + 2;
+      return rate_kb / 10 + 2;
   }
+
+  uint32_t size = rate_kb < 20 ? rate_kb + 2 : rate_kb / 5 + 18;
+
+  if (!m_delegator->is_adaptive_pipelining() || m_rtt == std::chrono::microseconds{})
+    return size;
+
+  // The rate based size is kept as the lower bound, which for most
+  // peers already covers a few seconds of data.
+  uint64_t bdp      = std::max<uint64_t>(rate, m_delivery_rate.rate()) * m_rtt.count() / 1000000;
+  uint64_t bdp_size = pipe_bdp_gain * bdp / Delegator::block_size + 2;
+
+  return std::max<uint64_t>(size, std::min<uint64_t>(bdp_size, pipe_max_size));
+}
+
+// Pieces are usually received in the order requested, so any older
+// requests are either cancelled or were dropped by the peer.
+void
+RequestList::update_rtt(const Piece& piece) {
+  auto itr = std::find_if(m_request_times.begin(), m_request_times.end(), [&piece](auto& r) {
+      return r.piece.index() == piece.index() && r.piece.offset() == piece.offset();
+    });
+
+  if (itr == m_request_times.end())
+    return;
+
+  auto sample = this_thread::cached_time() - itr->time;
+
+  // Samples of requests queued behind others include the time spent
+  // receiving those, so can only tell if the estimate is too high.
+  if (itr->idle)
+    m_rtt = m_rtt == std::chrono::microseconds{} ? sample : (m_rtt * 7 + sample) / 8;
+  else if (sample < m_rtt)
+    m_rtt = sample;
+
+  m_request_times.erase(m_request_times.begin(), itr + 1);
 }
 
 } // namespace torrent
@@ -5,6 +5,7 @@
 #include <optional>
 #include <vector>
 
+#include "torrent/rate.h"
 #include "torrent/data/block_transfer.h"
 #include "torrent/utils/scheduler.h"
 #include "utils/instrumentation.h"
@@ -40,6 +41,12 @@ public:
   static constexpr std::chrono::microseconds timeout_choked_received{60s};
   static constexpr std::chrono::microseconds timeout_process_unordered{60s};
 
+  // With adaptive pipelining the queue covers 'pipe_bdp_gain' times
+  // the bandwidth-delay product, so the rate can keep growing.
+  static constexpr uint32_t                  pipe_max_size{2048};
+  static constexpr uint32_t                  pipe_bdp_gain{2};
+  static constexpr Rate::timer_type          delivery_rate_span{3};
+
   RequestList();
   ~RequestList();
 
@@ -80,6 +87,14 @@ public:
   uint32_t             pipe_size() const;
   uint32_t             calculate_pipe_size(uint32_t rate);
 
+  // Smoothed time from a request to the first byte of its piece, or
+  // zero until a request is sent with nothing queued ahead of it.
+  std::chrono::microseconds rtt() const                   { return m_rtt; }
+
+  // Download rate over the last few seconds, which unlike the
+  // throttle rate keeps up while a connection is ramping up.
+  uint64_t             delivery_rate() const              { return m_delivery_rate.rate(); }
+
   Delegator*           delegator()                       { return m_delegator; }
   void                 set_delegator(Delegator* d)       { m_delegator = d; }
 
@@ -97,6 +112,14 @@ private:
   void                 prepare_process_unordered(queues_type::iterator itr);
   void                 delay_process_unordered();
 
+  void                 update_rtt(const Piece& piece);
+
+  struct request_time {
+    Piece                     piece;
+    std::chrono::microseconds time;
+    bool                      idle;
+  };
+
   Delegator*           m_delegator{};
   PeerChunks*          m_peerChunks{};
 
@@ -110,6 +133,10 @@ private:
   std::chrono::microseconds m_last_unchoke{};
   size_t                    m_last_unordered_position{0};
 
+  std::deque<request_time>  m_request_times;
+  std::chrono::microseconds m_rtt{};
+  Rate                      m_delivery_rate{delivery_rate_span};
+
   torrent::utils::SchedulerEntry m_delay_remove_choked;
   torrent::utils::SchedulerEntry m_delay_process_unordered;
 };
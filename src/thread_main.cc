@@ -3,6 +3,7 @@
 #include "thread_main.h"
 
 #include "manager.h"
+#include "data/hash_cache.h"
 #include "data/hash_queue.h"
 #include "torrent/data/file_manager.h"
 #include "torrent/net/resolver.h"
@@ -49,6 +50,7 @@ ThreadMain::create_thread() {
 
   m_thread_main->m_events_callback_id = system::make_callback_id();
   m_thread_main->m_hash_queue         = std::make_unique<HashQueue>();
+  m_thread_main->m_hash_cache         = std::make_unique<HashCache>();
 }
 
 void
@@ -88,6 +90,7 @@ ThreadMain::cleanup_thread() {
   cancel_callback(m_events_callback_id);
 
   m_hash_queue.reset();
+  m_hash_cache.reset();
 
   m_thread_main = nullptr;
   m_thread_base = nullptr;
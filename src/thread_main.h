@@ -10,6 +10,7 @@ class TestMainThread;
 
 namespace torrent {
 
+class HashCache;
 class HashQueue;
 
 class LIBTORRENT_EXPORT ThreadMain : public system::Thread {
@@ -29,6 +30,7 @@ public:
   void                   set_client_callback(std::function<void()> fn);
 
   HashQueue*             hash_queue()          { return m_hash_queue.get(); }
+  HashCache*             hash_cache()          { return m_hash_cache.get(); }
 
 protected:
   friend class ::TestMainThread;
@@ -49,6 +51,7 @@ private:
   system::callback_id       m_events_callback_id;
 
   std::unique_ptr<HashQueue> m_hash_queue;
+  std::unique_ptr<HashCache> m_hash_cache;
   std::function<void()>      m_slot_client_callback;
 };
 
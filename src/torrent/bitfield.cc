@@ -3,9 +3,9 @@
 #include "bitfield.h"
 
 #include <algorithm>
-#include <bit>
 
 #include "exceptions.h"
+#include "utils/bitfield_ops.h"
 #include "utils/instrumentation.h"
 
 namespace torrent {
@@ -51,32 +51,7 @@ Bitfield::update() {
   // Clears the unused bits.
   clear_tail();
 
-  m_set = 0;
-
-  iterator itr  = m_data.get();
-  iterator last = end();
-
-  // TODO: Eliminate the extra branches below by making the bitfield m_data 8-byte aligned and padded.
-
-  while (itr + sizeof(uint64_t) <= last) {
-    // Compilers optimize this completely into a single 64-bit load instruction (MOV/LDR)
-    uint64_t chunk;
-    std::memcpy(&chunk, itr, sizeof(uint64_t));
-
-    m_set += std::popcount(chunk);
-    itr   += sizeof(uint64_t);
-  }
-
-  if (itr + sizeof(uint32_t) <= last) {
-    uint32_t chunk;
-    std::memcpy(&chunk, itr, sizeof(uint32_t));
-
-    m_set += std::popcount(chunk);
-    itr   += sizeof(uint32_t);
-  }
-
-  while (itr != last)
-    m_set += std::popcount(*itr++);
+  m_set = bitfield_count(m_data.get(), m_size);
 }
 
 void
@@ -133,14 +108,7 @@ Bitfield::unset_range(size_type first, size_type last) {
 
 Bitfield::size_type
 Bitfield::find_first_set(size_type first, size_type last) const {
-  while (first < last) {
-    if (get(first))
-      return first;
-
-    ++first;
-  }
-
-  return last;
+  return bitfield_find_next(m_data.get(), nullptr, first, last);
 }
 
 } // namespace torrent
@@ -4,11 +4,14 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <limits>
 #include <memory>
 #include <set>
+#include <fcntl.h>
 #include <sys/statvfs.h>
+#include <unistd.h>
 
 #include "manager.h"
 #include "piece.h"
@@ -144,6 +147,17 @@ FileList::set_max_file_size(uint64_t size) {
   m_max_file_size = size;
 }
 
+void
+FileList::set_storage(storage_type storage) {
+  if (is_open())
+    throw input_error("Tried to change the storage type for an open download.");
+
+  if (storage != storage_mmap && storage != storage_buffered)
+    throw input_error("Tried to set an invalid storage type.");
+
+  m_storage = storage;
+}
+
 // This function should really ensure that we arn't dealing files
 // spread over multiple mount-points.
 uint64_t
@@ -619,6 +633,40 @@ FileList::create_chunk_part(FileList::iterator itr, uint64_t offset, uint32_t le
   return mc;
 }
 
+// The descriptor is duplicated so the part can be written back after
+// the file manager closes the file.
+MemoryChunk
+FileList::create_buffered_part(FileList::iterator itr, uint64_t offset, uint32_t length, bool hashing, int prot, int* fd) const {
+  offset -= (*itr)->offset();
+  length = std::min<uint64_t>(length, (*itr)->size_bytes() - offset);
+
+  if (static_cast<int64_t>(offset) < 0)
+    throw internal_error("FileList::create_buffered_part(...) caught a negative offset", data()->hash());
+
+  if (!(*itr)->prepare(hashing, prot, 0))
+    return MemoryChunk();
+
+  auto mc = SocketFile((*itr)->file_descriptor()).read_chunk(offset, length, prot);
+
+  if (!mc.is_valid())
+    return MemoryChunk();
+
+  if (mc.size() == 0 || mc.size() > length)
+    throw internal_error("FileList::create_buffered_part(...) read chunk has an invalid size.", data()->hash());
+
+  *fd = ::dup((*itr)->file_descriptor());
+
+  if (*fd == -1) {
+    int err = errno;
+    std::free(mc.ptr());
+    errno = err;
+
+    return MemoryChunk();
+  }
+
+  return mc;
+}
+
 Chunk*
 FileList::create_chunk(uint64_t offset, uint32_t length, bool hashing, int prot) {
   if (offset + length > m_torrent_size)
@@ -637,6 +685,22 @@ FileList::create_chunk(uint64_t offset, uint32_t length, bool hashing, int prot)
     if ((*itr)->size_bytes() == 0)
       continue;
 
+    if (m_storage == storage_buffered && !(*itr)->is_padding()) {
+      int fd = -1;
+      MemoryChunk mc = create_buffered_part(itr, offset, length, hashing, prot, &fd);
+
+      if (!mc.is_valid())
+        return nullptr;
+
+      chunk->push_back(ChunkPart::MAPPED_BUFFER, mc);
+      chunk->back().set_file(itr->get(), offset - (*itr)->offset());
+      chunk->back().set_file_descriptor(fd);
+
+      offset += mc.size();
+      length -= mc.size();
+      continue;
+    }
+
     MemoryChunk mc = create_chunk_part(itr, offset, length, hashing, prot);
 
     if (!mc.is_valid())
@@ -665,6 +729,42 @@ FileList::create_hashing_chunk_index(uint32_t index, int prot) {
   return create_chunk(static_cast<uint64_t>(index) * chunk_size(), chunk_index_size(index), true, prot);
 }
 
+uint32_t
+FileList::advise_willneed_index(uint32_t index) {
+  if (index >= size_chunks())
+    throw internal_error("FileList::advise_willneed_index(...) received an invalid index.", data()->hash());
+
+  uint32_t advised = 0;
+
+#ifdef USE_POSIX_FADVISE
+  uint64_t offset = chunk_index_position(index);
+  uint32_t length = chunk_index_size(index);
+
+  auto itr = std::find_if(begin(), end(), [offset](const value_type& file) {
+      return file->is_valid_position(offset);
+    });
+
+  for (; length != 0 && itr != end(); ++itr) {
+    File* file = itr->get();
+
+    if (file->size_bytes() == 0)
+      continue;
+
+    uint64_t file_offset = offset - file->offset();
+    uint32_t file_length = std::min<uint64_t>(length, file->size_bytes() - file_offset);
+
+    if (file->is_open() && !file->is_padding() &&
+        posix_fadvise(file->file_descriptor(), file_offset, file_length, POSIX_FADV_WILLNEED) == 0)
+      advised += file_length;
+
+    offset += file_length;
+    length -= file_length;
+  }
+#endif
+
+  return advised;
+}
+
 void
 FileList::mark_completed(uint32_t index) {
   if (index >= size_chunks() || completed_chunks() >= size_chunks())
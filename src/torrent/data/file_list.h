@@ -34,6 +34,14 @@ public:
 
   using cache_list = std::vector<std::pair<std::string, uint64_t>>;
 
+  // Chunks are either mmap'ed, or read into memory with pread and
+  // written back with pwrite when synced. The latter avoids per-chunk
+  // mappings, and keeps dirty data within the chunk memory limit.
+  enum storage_type {
+    storage_mmap,
+    storage_buffered
+  };
+
   // The below are using-directives that make visible functions and
   // typedefs in the parent std::vector, only those listed below are
   // accessible. If you don't understand how this works, use google,
@@ -96,6 +104,9 @@ public:
   uint64_t            max_file_size() const                           { return m_max_file_size; }
   void                set_max_file_size(uint64_t size);
 
+  storage_type        storage() const                                 { return m_storage; }
+  void                set_storage(storage_type storage);
+
   // If the files span multiple disks, the one with the least amount
   // of free diskspace will be returned.
   uint64_t            free_diskspace(cache_list& cache) const;
@@ -137,6 +148,11 @@ protected:
   Chunk*              create_chunk_index(uint32_t index, int prot) LIBTORRENT_NO_EXPORT;
   Chunk*              create_hashing_chunk_index(uint32_t index, int prot) LIBTORRENT_NO_EXPORT;
 
+  // Asks the kernel to start reading the chunk into the page cache,
+  // skipping files that are not currently open. Returns the number of
+  // bytes advised.
+  uint32_t            advise_willneed_index(uint32_t index) LIBTORRENT_NO_EXPORT;
+
   void                mark_completed(uint32_t index) LIBTORRENT_NO_EXPORT;
   iterator            inc_completed(iterator firstItr, uint32_t index) LIBTORRENT_NO_EXPORT;
   void                update_completed() LIBTORRENT_NO_EXPORT;
@@ -151,6 +167,7 @@ private:
 
   Chunk*              create_chunk(uint64_t offset, uint32_t length, bool hashing, int prot) LIBTORRENT_NO_EXPORT;
   MemoryChunk         create_chunk_part(FileList::iterator itr, uint64_t offset, uint32_t length, bool hashing, int prot) const LIBTORRENT_NO_EXPORT;
+  MemoryChunk         create_buffered_part(FileList::iterator itr, uint64_t offset, uint32_t length, bool hashing, int prot, int* fd) const LIBTORRENT_NO_EXPORT;
 
   download_data       m_data;
 
@@ -160,6 +177,7 @@ private:
   uint64_t            m_torrent_size{0};
   uint32_t            m_chunk_size{0};
   uint64_t            m_max_file_size{~uint64_t()};
+  storage_type        m_storage{storage_mmap};
 
   std::string         m_root_dir;
   string_utf8         m_frozen_root_dir;
@@ -550,6 +550,55 @@ Download::set_download_choke_heuristic(heuristics_enum t) {
   m_ptr->main()->choke_group()->down_queue()->set_heuristics(t);
 }
 
+picker_enum
+Download::chunk_picker() const {
+  return m_ptr->main()->chunk_selector()->picker();
+}
+
+void
+Download::set_chunk_picker(picker_enum t) {
+  if (t >= PICKER_MAX_SIZE)
+    throw input_error("Invalid chunk picker value.");
+
+  if (m_ptr->info()->is_active())
+    throw input_error("Can't change the chunk picker: download is active.");
+
+  m_ptr->main()->chunk_statistics()->set_availability_index(t == PICKER_RAREST_FIRST);
+  m_ptr->main()->chunk_selector()->set_picker(t);
+  m_ptr->main()->delegator()->set_deadline_mode(t == PICKER_DEADLINE);
+}
+
+std::chrono::microseconds
+Download::chunk_deadline(uint32_t index) const {
+  return m_ptr->main()->chunk_selector()->deadline(index);
+}
+
+void
+Download::set_chunk_deadline(uint32_t index, std::chrono::microseconds t) {
+  if (m_ptr->main()->chunk_selector()->empty())
+    throw input_error("Can't set chunk deadline: download has not been hash checked.");
+
+  if (index >= m_ptr->main()->chunk_selector()->size())
+    throw input_error("Chunk deadline index out of range.");
+
+  m_ptr->main()->chunk_selector()->set_deadline(index, t);
+}
+
+void
+Download::clear_chunk_deadlines() {
+  m_ptr->main()->chunk_selector()->clear_deadlines();
+}
+
+bool
+Download::is_adaptive_pipelining() const {
+  return m_ptr->main()->delegator()->is_adaptive_pipelining();
+}
+
+void
+Download::set_adaptive_pipelining(bool state) {
+  m_ptr->main()->delegator()->set_adaptive_pipelining(state);
+}
+
 void
 Download::update_priorities() {
   m_ptr->receive_update_priorities();
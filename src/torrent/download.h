@@ -1,6 +1,7 @@
 #ifndef LIBTORRENT_DOWNLOAD_H
 #define LIBTORRENT_DOWNLOAD_H
 
+#include <chrono>
 #include <list>
 #include <vector>
 #include <string>
@@ -155,6 +156,24 @@ public:
   heuristics_enum     download_choke_heuristic() const;
   void                set_download_choke_heuristic(heuristics_enum t);
 
+  // The chunk picker can only be changed while the download is
+  // inactive.
+  picker_enum         chunk_picker() const;
+  void                set_chunk_picker(picker_enum t);
+
+  // Deadlines are used with PICKER_DEADLINE, and are absolute times
+  // in the clock of torrent::this_thread::cached_time(). Setting a
+  // zero deadline removes it. Requires the initial hash check to be
+  // done.
+  std::chrono::microseconds chunk_deadline(uint32_t index) const;
+  void                      set_chunk_deadline(uint32_t index, std::chrono::microseconds t);
+  void                      clear_chunk_deadlines();
+
+  // Size the request pipeline of each peer to cover its measured
+  // bandwidth-delay product, for peers on high latency links.
+  bool                is_adaptive_pipelining() const;
+  void                set_adaptive_pipelining(bool state);
+
   // Call this when you want the modifications of the download priorities
   // in the entries to take effect. It is slightly expensive as it rechecks
   // all the peer bitfields to see if we are still interested.
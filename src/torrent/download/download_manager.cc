@@ -1,5 +1,7 @@
 #include "config.h"
 
+#include <cstring>
+
 #include "torrent/download_info.h"
 #include "torrent/exceptions.h"
 
@@ -8,11 +10,25 @@
 
 namespace torrent {
 
+// Info hashes are uniformly distributed, so any word of the hash
+// works as the bucket hash.
+size_t
+DownloadManager::hash_string_hash::operator () (const HashString& hash) const {
+  size_t result;
+  std::memcpy(&result, hash.data(), sizeof(result));
+  return result;
+}
+
 DownloadManager::iterator
 DownloadManager::insert(DownloadWrapper* d) {
-  if (find(d->info()->hash()) != end())
+  if (!m_hash_map.emplace(d->info()->hash(), d).second)
     throw internal_error("Could not add torrent as it already exists.");
 
+  if (!m_hash_obfuscated_map.emplace(d->info()->hash_obfuscated(), d).second) {
+    m_hash_map.erase(d->info()->hash());
+    throw internal_error("Could not add torrent as its obfuscated hash already exists.");
+  }
+
   return base_type::insert(end(), d);
 }
 
@@ -23,12 +39,18 @@ DownloadManager::erase(DownloadWrapper* d) {
   if (itr == end())
     throw internal_error("Tried to remove a torrent that doesn't exist");
 
+  m_hash_map.erase(d->info()->hash());
+  m_hash_obfuscated_map.erase(d->info()->hash_obfuscated());
+
   delete *itr;
   return base_type::erase(itr);
 }
 
 void
 DownloadManager::clear() {
+  m_hash_map.clear();
+  m_hash_obfuscated_map.clear();
+
   while (!empty()) {
     delete base_type::back();
     base_type::pop_back();
@@ -42,7 +64,12 @@ DownloadManager::find(const std::string& hash) {
 
 DownloadManager::iterator
 DownloadManager::find(const HashString& hash) {
-  return std::find_if(begin(), end(), [hash](const auto& wrapper){ return hash == wrapper->info()->hash(); });
+  auto itr = m_hash_map.find(hash);
+
+  if (itr == m_hash_map.end())
+    return end();
+
+  return std::find(begin(), end(), itr->second);
 }
 
 DownloadManager::iterator
@@ -57,24 +84,22 @@ DownloadManager::find_chunk_list(ChunkList* cl) {
 
 DownloadMain*
 DownloadManager::find_main(const char* hash) {
-  auto hash_str = *HashString::cast_from(hash);
-  auto itr = std::find_if(begin(), end(), [hash_str](const auto& wrapper){ return hash_str == wrapper->info()->hash(); });
+  auto itr = m_hash_map.find(*HashString::cast_from(hash));
 
-  if (itr == end())
+  if (itr == m_hash_map.end())
     return NULL;
   else
-    return (*itr)->main();
+    return itr->second->main();
 }
 
 DownloadMain*
 DownloadManager::find_main_obfuscated(const char* hash) {
-  auto hash_str = *HashString::cast_from(hash);
-  auto itr = std::find_if(begin(), end(), [hash_str](const auto& wrapper){ return hash_str == wrapper->info()->hash_obfuscated(); });
+  auto itr = m_hash_obfuscated_map.find(*HashString::cast_from(hash));
 
-  if (itr == end())
+  if (itr == m_hash_obfuscated_map.end())
     return NULL;
   else
-    return (*itr)->main();
+    return itr->second->main();
 }
 
 } // namespace torrent
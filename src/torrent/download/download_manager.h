@@ -2,9 +2,11 @@
 #define LIBTORRENT_DOWNLOAD_MANAGER_H
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <torrent/common.h>
+#include <torrent/hash_string.h>
 
 namespace torrent {
 
@@ -48,6 +50,7 @@ public:
 
   iterator            find_chunk_list(ChunkList* cl);
 
+  // Constant time lookups used by incoming handshakes.
   DownloadMain*       find_main(const char* hash);
   DownloadMain*       find_main_obfuscated(const char* hash);
 
@@ -59,6 +62,16 @@ public:
   iterator            erase(DownloadWrapper* d) LIBTORRENT_NO_EXPORT;
 
   void                clear() LIBTORRENT_NO_EXPORT;
+
+private:
+  struct hash_string_hash {
+    size_t operator () (const HashString& hash) const;
+  };
+
+  using hash_map_type = std::unordered_map<HashString, DownloadWrapper*, hash_string_hash>;
+
+  hash_map_type       m_hash_map;
+  hash_map_type       m_hash_obfuscated_map;
 };
 
 } // namespace torrent
@@ -11,6 +11,13 @@ enum heuristics_enum {
   HEURISTICS_MAX_SIZE
 };
 
+enum picker_enum {
+  PICKER_DEFAULT,
+  PICKER_RAREST_FIRST,
+  PICKER_DEADLINE,
+  PICKER_MAX_SIZE
+};
+
 }
 
 #endif
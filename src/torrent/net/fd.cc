@@ -148,6 +148,12 @@ fd_open(fd_flags flags) {
     return -1;
   }
 
+  if ((flags & fd_flag_reuse_port) && !fd_set_reuse_port(fd, true)) {
+    LT_LOG_FD_FLAG_ERROR("fd_open failed to set reuse_port");
+    fd__close(fd);
+    return -1;
+  }
+
   LT_LOG_FD_FLAG("fd_open succeeded");
   return fd;
 }
@@ -566,6 +572,23 @@ fd_set_reuse_address(int fd, bool state) {
   return true;
 }
 
+bool
+fd_set_reuse_port(int fd, bool state) {
+#ifdef SO_REUSEPORT
+  if (fd__setsockopt_int(fd, SOL_SOCKET, SO_REUSEPORT, state) == -1) {
+    LT_LOG_FD_VALUE_ERROR("fd_set_reuse_port() failed", state);
+    return false;
+  }
+
+  LT_LOG_FD_VALUE("fd_set_reuse_port() succeeded", state);
+  return true;
+#else
+  errno = ENOPROTOOPT;
+  LT_LOG_FD_VALUE_ERROR("fd_set_reuse_port() not supported", state);
+  return false;
+#endif
+}
+
 bool
 fd_set_priority(int fd, int family, int priority) {
   int level;
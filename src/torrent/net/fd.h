@@ -16,7 +16,8 @@ enum fd_flags : int {
   fd_flag_v4            = 0x80, // renamed
   fd_flag_v4only        = 0x80,
   fd_flag_v6only        = 0x100,
-  fd_flag_all           = 0x1ff,
+  fd_flag_reuse_port    = 0x200,
+  fd_flag_all           = 0x3ff,
 };
 
 constexpr bool  fd_valid_flags(fd_flags flags);
@@ -51,6 +52,7 @@ c_sa_unique_ptr fd_get_socket_name(int fd) LIBTORRENT_EXPORT;
 bool            fd_set_dont_route(int fd, bool state) LIBTORRENT_EXPORT;
 bool            fd_set_nonblock(int fd) LIBTORRENT_EXPORT;
 bool            fd_set_reuse_address(int fd, bool state) LIBTORRENT_EXPORT;
+bool            fd_set_reuse_port(int fd, bool state) LIBTORRENT_EXPORT;
 bool            fd_set_priority(int fd, int family, int priority) LIBTORRENT_EXPORT;
 bool            fd_set_tcp_nodelay(int fd) LIBTORRENT_EXPORT;
 bool            fd_set_v6only(int fd, bool state) LIBTORRENT_EXPORT;
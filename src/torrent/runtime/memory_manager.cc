@@ -5,8 +5,15 @@
 #include <cassert>
 #include <sys/resource.h>
 
+#include "thread_main.h"
+#include "data/hash_cache.h"
+#include "data/hash_check_queue.h"
+#include "data/thread_disk.h"
+#include "net/socket_stream.h"
 #include "torrent/exceptions.h"
+#include "torrent/system/callbacks.h"
 #include "torrent/utils/log.h"
+#include "utils/io_uring.h"
 
 #define LT_LOG(log_fmt, ...)                                        \
   lt_log_print(LOG_SYSTEM_POLL, "memory-manager: " log_fmt, __VA_ARGS__);
@@ -114,6 +121,95 @@ MemoryManager::set_preload_required_rate(uint32_t bytes) {
   m_preload_required_rate = bytes;
 }
 
+void
+MemoryManager::set_upload_sendfile(bool state) {
+  if (state && !SocketStream::is_sendfile_supported())
+    throw input_error("set_upload_sendfile: sendfile is not supported");
+
+  m_upload_sendfile = state;
+
+  LT_LOG("set_upload_sendfile: new state: %i", static_cast<int>(state));
+}
+
+void
+MemoryManager::set_upload_zerocopy(bool state) {
+  if (state && !SocketStream::is_zerocopy_supported())
+    throw input_error("set_upload_zerocopy: MSG_ZEROCOPY is not supported");
+
+  m_upload_zerocopy = state;
+
+  LT_LOG("set_upload_zerocopy: new state: %i", static_cast<int>(state));
+}
+
+void
+MemoryManager::set_hash_thread_count(uint32_t count) {
+  if (count > 64)
+    throw input_error("set_hash_thread_count: invalid count, must be between 0 and 64 : " + std::to_string(count));
+
+  m_hash_thread_count = count;
+
+  // The disk thread applies the current count when initialized.
+  if (ThreadDisk::thread_disk() != nullptr && ThreadDisk::thread_disk()->hash_check_queue() != nullptr)
+    ThreadDisk::thread_disk()->hash_check_queue()->set_thread_count(count);
+
+  LT_LOG("set_hash_thread_count: new count: %" PRIu32, count);
+}
+
+void
+MemoryManager::set_hash_read_depth(uint32_t depth) {
+  if (depth > 256)
+    throw input_error("set_hash_read_depth: invalid depth, must be between 0 and 256 : " + std::to_string(depth));
+
+  if (depth != 0 && !utils::IoUring::is_supported())
+    throw input_error("set_hash_read_depth: io_uring is not supported");
+
+  m_hash_read_depth = depth;
+
+  if (ThreadDisk::thread_disk() != nullptr && ThreadDisk::thread_disk()->hash_check_queue() != nullptr)
+    ThreadDisk::thread_disk()->hash_check_queue()->set_read_depth(depth);
+
+  LT_LOG("set_hash_read_depth: new depth: %" PRIu32, depth);
+}
+
+void
+MemoryManager::set_hash_read_ahead(uint64_t bytes) {
+  if (bytes > (uint64_t(1) << 30))
+    throw input_error("set_hash_read_ahead: invalid size, must be between 0 and 1 GiB : " + std::to_string(bytes));
+
+  // Applied by HashTorrent when the next hash check starts.
+  m_hash_read_ahead = bytes;
+
+  LT_LOG("set_hash_read_ahead: new size: %" PRIu64, bytes);
+}
+
+std::string
+MemoryManager::hash_cache_path() const {
+  assert(std::this_thread::get_id() == main_thread::thread_id());
+
+  return ThreadMain::thread_main()->hash_cache()->path();
+}
+
+void
+MemoryManager::set_hash_cache_path(const std::string& path) {
+  assert(std::this_thread::get_id() == main_thread::thread_id());
+
+  auto hash_cache = ThreadMain::thread_main()->hash_cache();
+
+  if (path.empty()) {
+    hash_cache->close();
+    LT_LOG("set_hash_cache_path: closed", 0);
+    return;
+  }
+
+  try {
+    hash_cache->open(path);
+  } catch (const storage_error& e) {
+    throw input_error(std::string("set_hash_cache_path: ") + e.what());
+  }
+
+  LT_LOG("set_hash_cache_path: new path: %s", path.c_str());
+}
+
 void
 MemoryManager::account_sync_queue(uint64_t bytes) {
   m_sync_queue_block_count++;
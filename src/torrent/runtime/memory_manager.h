@@ -1,6 +1,7 @@
 #ifndef LIBTORRENT_TORRENT_RUNTIME_MEMORY_MANAGER_H
 #define LIBTORRENT_TORRENT_RUNTIME_MEMORY_MANAGER_H
 
+#include <string>
 #include <torrent/common.h>
 
 namespace torrent::runtime {
@@ -60,6 +61,41 @@ public:
   uint32_t            stats_preloaded() const;
   uint32_t            stats_not_preloaded() const;
 
+  // Send piece data of unencrypted connections with sendfile from the file descriptor instead of
+  // writing from the mapped chunk. Throws if sendfile is not supported.
+  bool                upload_sendfile() const;
+  void                set_upload_sendfile(bool state);
+
+  // Send large parts of piece data with MSG_ZEROCOPY when sendfile is not used. The chunks stay
+  // referenced until the kernel reports the sends complete. Throws if not supported.
+  bool                upload_zerocopy() const;
+  void                set_upload_zerocopy(bool state);
+
+  //
+  // Hash Checking:
+  //
+
+  // Number of dedicated threads used for hash checking chunks, when set to zero hashing is done on
+  // the disk thread. Must be called from the main thread.
+  uint32_t            hash_thread_count() const;
+  void                set_hash_thread_count(uint32_t count);
+
+  // Number of chunks read in parallel with io_uring when hashing on the disk thread, zero disables
+  // io_uring and hashes the mapped chunks. Throws if io_uring is not supported.
+  uint32_t            hash_read_depth() const;
+  void                set_hash_read_depth(uint32_t depth);
+
+  // Maximum bytes of chunks advised with POSIX_FADV_WILLNEED ahead of the hash checker, the actual
+  // window is sized from the measured hashing rate. Zero disables read-ahead.
+  uint64_t            hash_read_ahead() const;
+  void                set_hash_read_ahead(uint64_t bytes);
+
+  // Path of the persistent hash cache, which lets hash checks skip chunks verified earlier when
+  // none of their files have changed. An empty path closes the cache. Must be called from the main
+  // thread.
+  std::string         hash_cache_path() const;
+  void                set_hash_cache_path(const std::string& path);
+
 protected:
   friend class torrent::ChunkList;
   friend class torrent::PeerConnectionBase;
@@ -91,6 +127,13 @@ private:
 
   std::atomic<uint32_t> m_stats_preloaded{};
   std::atomic<uint32_t> m_stats_not_preloaded{};
+
+  std::atomic<bool>     m_upload_sendfile{false};
+  std::atomic<bool>     m_upload_zerocopy{false};
+
+  std::atomic<uint32_t> m_hash_thread_count{0};
+  std::atomic<uint32_t> m_hash_read_depth{0};
+  std::atomic<uint64_t> m_hash_read_ahead{32 << 20};
 };
 
 inline uint64_t MemoryManager::memory_usage() const            { return m_memory_usage.load(std::memory_order_acquire); }
@@ -109,6 +152,13 @@ inline uint32_t MemoryManager::preload_required_rate() const   { return m_preloa
 inline uint32_t MemoryManager::stats_preloaded() const         { return m_stats_preloaded.load(std::memory_order_acquire); }
 inline uint32_t MemoryManager::stats_not_preloaded() const     { return m_stats_not_preloaded.load(std::memory_order_acquire); }
 
+inline uint32_t MemoryManager::hash_thread_count() const       { return m_hash_thread_count.load(std::memory_order_acquire); }
+inline uint32_t MemoryManager::hash_read_depth() const         { return m_hash_read_depth.load(std::memory_order_acquire); }
+inline bool     MemoryManager::upload_sendfile() const         { return m_upload_sendfile.load(std::memory_order_acquire); }
+inline bool     MemoryManager::upload_zerocopy() const         { return m_upload_zerocopy.load(std::memory_order_acquire); }
+
+inline uint64_t MemoryManager::hash_read_ahead() const         { return m_hash_read_ahead.load(std::memory_order_acquire); }
+
 inline void     MemoryManager::increment_stats_preloaded()     { m_stats_preloaded.fetch_add(1, std::memory_order_acq_rel); }
 inline void     MemoryManager::increment_stats_not_preloaded() { m_stats_not_preloaded.fetch_add(1, std::memory_order_acq_rel); }
 
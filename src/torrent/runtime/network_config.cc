@@ -356,6 +356,23 @@ NetworkConfig::set_encryption_modes(encryption_mode handshake, encryption_mode s
   m_stream_encryption_mode = stream;
 }
 
+uint32_t
+NetworkConfig::encryption_key_reserve() const {
+  auto guard = lock_guard();
+  return m_encryption_key_reserve;
+}
+
+void
+NetworkConfig::set_encryption_key_reserve(uint32_t reserve) {
+  if (reserve > 1024)
+    throw input_error("Tried to set an encryption key reserve greater than 1024.");
+
+  auto guard = lock_guard();
+
+  m_encryption_key_reserve = reserve;
+  notify_changes_unsafe();
+}
+
 int
 NetworkConfig::listen_backlog() const {
   auto guard = lock_guard();
@@ -376,6 +393,69 @@ NetworkConfig::set_listen_backlog(int backlog) {
   notify_changes_unsafe();
 }
 
+int
+NetworkConfig::listen_threads() const {
+  auto guard = lock_guard();
+  return m_listen_threads;
+}
+
+void
+NetworkConfig::set_listen_threads(int threads) {
+  if (threads < 0)
+    throw input_error("Tried to set a negative number of listen threads.");
+
+  if (threads > 64)
+    throw input_error("Tried to set more than 64 listen threads.");
+
+  auto guard = lock_guard();
+
+  m_listen_threads = threads;
+  notify_changes_unsafe();
+}
+
+int
+NetworkConfig::listen_accept_batch() const {
+  auto guard = lock_guard();
+  return m_listen_accept_batch;
+}
+
+void
+NetworkConfig::set_listen_accept_batch(int batch) {
+  if (batch < 1)
+    throw input_error("Tried to set a listen accept batch less than 1.");
+
+  if (batch > 256)
+    throw input_error("Tried to set a listen accept batch greater than 256.");
+
+  auto guard = lock_guard();
+
+  m_listen_accept_batch = batch;
+  notify_changes_unsafe();
+}
+
+int
+NetworkConfig::peer_read_threads() const {
+  auto guard = lock_guard();
+  return m_peer_read_threads;
+}
+
+void
+NetworkConfig::set_peer_read_threads(int threads) {
+  if (threads < 0)
+    throw input_error("Tried to set a negative number of peer read threads.");
+
+  if (threads > 64)
+    throw input_error("Tried to set more than 64 peer read threads.");
+
+#ifndef USE_EPOLL
+  if (threads > 0)
+    throw input_error("Peer read threads require epoll support.");
+#endif
+
+  auto guard = lock_guard();
+  m_peer_read_threads = threads;
+}
+
 uint16_t
 NetworkConfig::override_dht_port() const {
   auto guard = lock_guard();
@@ -500,6 +580,16 @@ NetworkConfig::listen_backlog_unsafe() const {
   return m_listen_backlog;
 }
 
+int
+NetworkConfig::listen_threads_unsafe() const {
+  return m_listen_threads;
+}
+
+int
+NetworkConfig::listen_accept_batch_unsafe() const {
+  return m_listen_accept_batch;
+}
+
 uint16_t
 NetworkConfig::override_dht_port_unsafe() const {
   return m_override_dht_port;
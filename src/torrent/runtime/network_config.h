@@ -96,6 +96,21 @@ public:
   int                 listen_backlog() const;
   void                set_listen_backlog(int backlog);
 
+  // Number of SO_REUSEPORT listen sockets per address, each accepting
+  // from its own thread. Zero accepts from the main thread's poll.
+  int                 listen_threads() const;
+  void                set_listen_threads(int threads);
+
+  // Maximum connections accepted by a listen thread per wakeup.
+  int                 listen_accept_batch() const;
+  void                set_listen_accept_batch(int batch);
+
+  // Number of threads receiving on established peer connections. Zero
+  // reads from the main thread's poll. Only applies to connections
+  // opened after the change.
+  int                 peer_read_threads() const;
+  void                set_peer_read_threads(int threads);
+
   uint16_t            override_dht_port() const;
   void                set_override_dht_port(uint16_t port);
 
@@ -108,6 +123,11 @@ public:
   auto                encryption_modes() const;
   void                set_encryption_modes(encryption_mode handshake, encryption_mode stream);
 
+  // Number of Diffie-Hellman keys for encrypted handshakes to generate
+  // ahead of time on a worker thread. Zero generates them on demand.
+  uint32_t            encryption_key_reserve() const;
+  void                set_encryption_key_reserve(uint32_t reserve);
+
   // The lock is held while the callback is called, so use Thread::callback().
   void                subscribe_to_changes(void* target, const std::function<void()>& callback);
   void                unsubscribe_from_changes(void* target);
@@ -131,6 +151,8 @@ protected:
 
   listen_addresses    listen_addresses_unsafe() const;
   int                 listen_backlog_unsafe() const;
+  int                 listen_threads_unsafe() const;
+  int                 listen_accept_batch_unsafe() const;
   uint16_t            override_dht_port_unsafe() const;
 
 private:
@@ -169,12 +191,16 @@ private:
   c_sa_shared_ptr     m_local_inet6_address;
 
   int                 m_listen_backlog{SOMAXCONN};
+  int                 m_listen_threads{0};
+  int                 m_listen_accept_batch{16};
+  int                 m_peer_read_threads{0};
   uint16_t            m_override_dht_port{0};
   uint32_t            m_send_buffer_size{0};
   uint32_t            m_receive_buffer_size{0};
 
   encryption_mode     m_handshake_encryption_mode{ENCRYPTION_MODE_ALLOW};
   encryption_mode     m_stream_encryption_mode{ENCRYPTION_MODE_ALLOW};
+  uint32_t            m_encryption_key_reserve{0};
 
   subscriber_list       m_change_subscribers;
   utils::SchedulerEntry m_delay_changed;
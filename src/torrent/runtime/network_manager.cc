@@ -198,7 +198,9 @@ NetworkManager::listen_open_unsafe(uint16_t first, uint16_t last) {
     auto nw_config    = runtime::network_config();
     auto config_guard = nw_config->lock_guard();
 
-    options.backlog  = nw_config->listen_backlog_unsafe();
+    options.backlog      = nw_config->listen_backlog_unsafe();
+    options.threads      = nw_config->listen_threads_unsafe();
+    options.accept_batch = nw_config->listen_accept_batch_unsafe();
     listen_addresses = nw_config->listen_addresses_unsafe();
 
     if (first != last && nw_config->override_dht_port_unsafe() == 0)
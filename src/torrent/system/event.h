@@ -36,6 +36,11 @@ public:
   virtual void        event_write() = 0;
   virtual void        event_error() = 0;
 
+  // Called before event_error() when the poll reports an error, return
+  // true if only queued notifications were pending and have been
+  // consumed, e.g. MSG_ZEROCOPY completions.
+  virtual bool        event_error_queue()             { return false; }
+
   // TODO: Add bool event_fd_reused().
 
 protected:
@@ -270,7 +270,7 @@ Poll::process() {
 
     auto* poll_event = static_cast<PollEvent*>(itr->data.ptr);
 
-    if (itr->events & EPOLLERR) {
+    if ((itr->events & EPOLLERR) && (poll_event->event == nullptr || !poll_event->event->event_error_queue())) {
       count++;
 
       if (poll_event->event == nullptr)
@@ -57,6 +57,8 @@ enum {
   LOG_INSTRUMENTATION_CHOKE,
   LOG_INSTRUMENTATION_POLLING,
   LOG_INSTRUMENTATION_TRANSFERS,
+  LOG_INSTRUMENTATION_HASHING,
+  LOG_INSTRUMENTATION_WRITEBACK,
 
   LOG_MOCK_CALLS,
 
@@ -156,6 +156,8 @@ constexpr const char* option_list_log_group[] = {
   "instrumentation_choke",
   "instrumentation_polling",
   "instrumentation_transfers",
+  "instrumentation_hashing",
+  "instrumentation_writeback",
 
   "mock_calls",
 
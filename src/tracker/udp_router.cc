@@ -534,14 +534,19 @@ UdpRouter::receive_timeout() {
 
 void
 UdpRouter::event_read() {
-  while (true) {
-    sa_inet_union from_sa;
+  buffer_type   buffers[max_batch];
+  sa_inet_union addresses[max_batch];
+  read_entry    entries[max_batch];
 
-    m_buffer.reset();
+  while (true) {
+    for (unsigned int i = 0; i < max_batch; i++) {
+      buffers[i].reset();
+      entries[i] = read_entry{buffers[i].begin(), buffers[i].reserved(), &addresses[i].sa, sizeof(addresses[i])};
+    }
 
-    auto bytes_read = read_datagram_sa(m_buffer.begin(), m_buffer.reserved(), &from_sa.sa, sizeof(from_sa));
+    auto count = read_datagrams_sa(entries, max_batch);
 
-    if (bytes_read == -1) {
+    if (count == -1) {
       if (errno == EAGAIN || errno == EWOULDBLOCK)
         break;
 
@@ -552,37 +557,48 @@ UdpRouter::event_read() {
       throw internal_error("UdpRouter::event_read() failed to read datagram: " + system::errno_enum_str(errno));
     }
 
-    if (bytes_read == 0)
-      throw internal_error("UdpRouter::event_read() read datagram of length 0");
-
-    m_buffer.set_end(bytes_read);
+    for (int i = 0; i < count; i++) {
+      if (entries[i].length == 0)
+        throw internal_error("UdpRouter::event_read() read datagram of length 0");
 
-    uint32_t transaction_id = peek_transaction_id(m_buffer);
-
-    if (transaction_id == 0) {
-      // LT_LOG("received datagram with invalid transaction ID : address:%s", sa_pretty_str(&from_sa.sa).c_str());
-      continue;
+      buffers[i].set_end(entries[i].length);
+      process_read(buffers[i], &addresses[i].sa);
     }
 
-    // It's quicker to do transaction-id lookup and then verify the address.
-    auto itr = m_connections.find(transaction_id);
+    // The socket is level triggered, so a short batch means there's no
+    // need for another read that would fail with EAGAIN.
+    if (static_cast<unsigned int>(count) < max_batch)
+      break;
+  }
+}
 
-    if (itr == m_connections.end()) {
-      // LT_LOG("received datagram with unknown transaction ID : address:%s transaction_id:%" PRIx32, sa_pretty_str(&from_sa.sa).c_str(), transaction_id);
-      continue;
-    }
+void
+UdpRouter::process_read(buffer_type& buffer, const sockaddr* from_sa) {
+  uint32_t transaction_id = peek_transaction_id(buffer);
 
-    // While the id is random, the tracker can still send brute-force it so check that we're did not
-    // disconnect before hostname resolved.
-    if (itr->second.address == nullptr)
-      continue;
+  if (transaction_id == 0) {
+    // LT_LOG("received datagram with invalid transaction ID : address:%s", sa_pretty_str(from_sa).c_str());
+    return;
+  }
 
-    if (!sa_equal(&from_sa.sa, itr->second.address.get()))
-      continue;
+  // It's quicker to do transaction-id lookup and then verify the address.
+  auto itr = m_connections.find(transaction_id);
 
-    if (!itr->second.process(transaction_id, m_buffer))
-      disconnect_unsafe(itr);
+  if (itr == m_connections.end()) {
+    // LT_LOG("received datagram with unknown transaction ID : address:%s transaction_id:%" PRIx32, sa_pretty_str(from_sa).c_str(), transaction_id);
+    return;
   }
+
+  // While the id is random, the tracker can still send brute-force it so check that we're did not
+  // disconnect before hostname resolved.
+  if (itr->second.address == nullptr)
+    return;
+
+  if (!sa_equal(from_sa, itr->second.address.get()))
+    return;
+
+  if (!itr->second.process(transaction_id, buffer))
+    disconnect_unsafe(itr);
 }
 
 void
@@ -595,6 +611,12 @@ UdpRouter::event_write() {
       continue;
     }
 
+    // Send as many queued datagrams as possible with a single syscall,
+    // the first datagram that could not be sent is retried below for
+    // error handling.
+    if (try_write_batch() != 0)
+      continue;
+
     assert(info->timeout_ptr == nullptr);
 
     int err = try_write(id, info);
@@ -620,6 +642,68 @@ UdpRouter::event_write() {
     this_thread::poll()->remove_write(this);
 }
 
+// Returns the number of datagrams written from the front of the write
+// queue, which must not start with a cleared entry. Returns zero
+// without writing if fewer than two datagrams can be batched.
+unsigned int
+UdpRouter::try_write_batch() {
+  buffer_type  buffers[max_batch];
+  write_entry  entries[max_batch];
+  unsigned int count = 0;
+
+  for (auto [id, info] : m_write_queue) {
+    if (info == nullptr || count == max_batch)
+      break;
+
+    assert(info->address != nullptr);
+
+    buffers[count].reset();
+    info->prepare(id, buffers[count]);
+
+    if (buffers[count].size_end() == 0)
+      throw internal_error("UdpRouter::try_write_batch() prepare function did not write any data.");
+
+    entries[count] = write_entry{buffers[count].begin(), buffers[count].size_end(), info->address.get()};
+    count++;
+  }
+
+  if (count < 2)
+    return 0;
+
+  auto written = write_datagrams_sa(entries, count);
+
+  if (written <= 0)
+    return 0;
+
+  for (int i = 0; i < written; i++) {
+    // Connections disconnected by an earlier packet_sent callback have
+    // their entry cleared.
+    auto [id, info] = m_write_queue.front();
+
+    if (info != nullptr) {
+      assert(info->timeout_ptr == nullptr);
+
+      if (entries[i].length != buffers[i].size_end()) {
+        LT_LOG("failed to write datagram : address:%s : only %u of %u bytes written",
+               sa_pretty_str(info->address.get()).c_str(), entries[i].length, static_cast<unsigned int>(buffers[i].size_end()));
+        throw internal_error("UdpRouter::try_write_batch() did not write entire datagram.");
+      }
+
+      if (info->packet_sent)
+        info->packet_sent(id);
+    }
+
+    m_write_queue.pop_front();
+
+    if (info != nullptr) {
+      info->queue_ptr = nullptr;
+      queue_timeout(id, info);
+    }
+  }
+
+  return written;
+}
+
 void
 UdpRouter::event_error() {
   LT_LOG("socket error event triggered", 0);
@@ -102,12 +102,14 @@ private:
   bool                try_write_with_queues(uint32_t id, connection_info* info);
   [[nodiscard]] int   try_write(uint32_t id, connection_info* info);
   [[nodiscard]] int   do_write(uint32_t id, connection_info* info);
+  unsigned int        try_write_batch();
 
   void                clear_timeout(connection_info* info);
   void                queue_timeout(uint32_t id, connection_info* info);
   void                queue_write(uint32_t id, connection_info* info);
 
   uint32_t            peek_transaction_id(buffer_type& buffer) const;
+  void                process_read(buffer_type& buffer, const sockaddr* from_sa);
 
   void                receive_timeout();
 
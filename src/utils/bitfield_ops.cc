@@ -0,0 +1,177 @@
+#include "config.h"
+
+#include "utils/bitfield_ops.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace torrent {
+
+namespace {
+
+// Loads the 64 bits starting at 'word * 64' with the first bit in the
+// most significant position, zero padded past 'size_bytes'.
+[[gnu::always_inline]] inline uint64_t
+bitfield_load_word(const uint8_t* data, uint32_t word, uint32_t size_bytes) {
+  uint64_t value = 0;
+  uint32_t offset = word * 8;
+
+  std::memcpy(&value, data + offset, std::min<uint32_t>(size_bytes - offset, 8));
+
+  if constexpr (std::endian::native == std::endian::little)
+    value = __builtin_bswap64(value);
+
+  return value;
+}
+
+[[gnu::always_inline]] inline uint64_t
+bitfield_load_word(const uint8_t* a, const uint8_t* b, uint32_t word, uint32_t size_bytes) {
+  uint64_t value = bitfield_load_word(a, word, size_bytes);
+
+  if (b != nullptr)
+    value &= bitfield_load_word(b, word, size_bytes);
+
+  return value;
+}
+
+// Mask of the bits before 'size_bits' in the last word.
+[[gnu::always_inline]] inline uint64_t
+bitfield_tail_mask(uint32_t size_bits) {
+  return size_bits % 64 == 0 ? ~uint64_t{} : ~(~uint64_t{} >> (size_bits % 64));
+}
+
+// Each bitfield byte expanded to eight counter increments, stored in
+// the order the bytes appear in memory.
+struct bitfield_expand_table {
+  uint64_t values[256];
+};
+
+constexpr bitfield_expand_table
+make_bitfield_expand_table() {
+  bitfield_expand_table table{};
+
+  for (unsigned int i = 0; i < 256; i++) {
+    for (unsigned int j = 0; j < 8; j++) {
+      uint64_t bit = (i >> (7 - j)) & 1;
+
+      if constexpr (std::endian::native == std::endian::little)
+        table.values[i] |= bit << (8 * j);
+      else
+        table.values[i] |= bit << (8 * (7 - j));
+    }
+  }
+
+  return table;
+}
+
+constexpr bitfield_expand_table bitfield_expand = make_bitfield_expand_table();
+
+// Sixteen byte vectors map to SSE2 and NEON. Wider vectors were not
+// faster, as the table lookups dominate.
+using counter_v16 = uint8_t __attribute__((vector_size(16)));
+using expand_v16  = uint64_t __attribute__((vector_size(16)));
+
+// Updates 16 counters per step, skipping steps with no set bits.
+// Returns the number of bits handled.
+//
+// The increments are built in registers, as storing the table entries
+// and reloading them as a vector stalls on store forwarding.
+template <bool Decrement>
+uint32_t
+bitfield_counters_v16(uint8_t* counters, const uint8_t* bits, uint32_t size_bits) {
+  uint32_t steps = size_bits / 16;
+
+  for (uint32_t i = 0; i < steps; i++, bits += 2, counters += 16) {
+    if ((bits[0] | bits[1]) == 0)
+      continue;
+
+    auto delta = reinterpret_cast<counter_v16>(expand_v16{ bitfield_expand.values[bits[0]], bitfield_expand.values[bits[1]] });
+
+    counter_v16 value;
+    std::memcpy(&value, counters, sizeof(value));
+
+    if (Decrement)
+      value -= delta;
+    else
+      value += delta;
+
+    std::memcpy(counters, &value, sizeof(value));
+  }
+
+  return steps * 16;
+}
+
+template <bool Decrement>
+void
+bitfield_counters(uint8_t* counters, const uint8_t* bits, uint32_t size_bits) {
+  uint32_t done = bitfield_counters_v16<Decrement>(counters, bits, size_bits);
+
+  for (uint32_t i = done; i < size_bits; i++) {
+    uint8_t bit = (bits[i / 8] >> (7 - i % 8)) & 1;
+
+    if (Decrement)
+      counters[i] -= bit;
+    else
+      counters[i] += bit;
+  }
+}
+
+} // namespace
+
+uint32_t
+bitfield_count(const uint8_t* data, uint32_t size_bits) {
+  return bitfield_count_and(data, nullptr, size_bits);
+}
+
+uint32_t
+bitfield_count_and(const uint8_t* a, const uint8_t* b, uint32_t size_bits) {
+  if (size_bits == 0)
+    return 0;
+
+  uint32_t size_bytes = (size_bits + 7) / 8;
+  uint32_t last_word  = (size_bits - 1) / 64;
+  uint32_t result     = 0;
+
+  for (uint32_t word = 0; word < last_word; word++)
+    result += std::popcount(bitfield_load_word(a, b, word, size_bytes));
+
+  return result + std::popcount(bitfield_load_word(a, b, last_word, size_bytes) & bitfield_tail_mask(size_bits));
+}
+
+uint32_t
+bitfield_find_next(const uint8_t* a, const uint8_t* b, uint32_t first, uint32_t last) {
+  if (first >= last)
+    return last;
+
+  uint32_t size_bytes = (last + 7) / 8;
+  uint32_t word       = first / 64;
+  uint32_t last_word  = (last - 1) / 64;
+
+  uint64_t value = bitfield_load_word(a, b, word, size_bytes) & (~uint64_t{} >> (first % 64));
+
+  while (true) {
+    if (word == last_word)
+      value &= bitfield_tail_mask(last);
+
+    if (value != 0)
+      return word * 64 + std::countl_zero(value);
+
+    if (word == last_word)
+      return last;
+
+    value = bitfield_load_word(a, b, ++word, size_bytes);
+  }
+}
+
+void
+bitfield_increment_counters(uint8_t* counters, const uint8_t* bits, uint32_t size_bits) {
+  bitfield_counters<false>(counters, bits, size_bits);
+}
+
+void
+bitfield_decrement_counters(uint8_t* counters, const uint8_t* bits, uint32_t size_bits) {
+  bitfield_counters<true>(counters, bits, size_bits);
+}
+
+} // namespace torrent
@@ -0,0 +1,29 @@
+#ifndef LIBTORRENT_UTILS_BITFIELD_OPS_H
+#define LIBTORRENT_UTILS_BITFIELD_OPS_H
+
+#include <cinttypes>
+
+namespace torrent {
+
+// Word-wide kernels over raw bitfield data, using the same MSB-first
+// bit order as Bitfield. The buffers must hold at least the bytes
+// covering the given number of bits.
+
+// Number of set bits.
+uint32_t     bitfield_count(const uint8_t* data, uint32_t size_bits);
+
+// Number of bits set in 'a & b'.
+uint32_t     bitfield_count_and(const uint8_t* a, const uint8_t* b, uint32_t size_bits);
+
+// First bit in [first, last) set in 'a', or in 'a & b' if 'b' is not
+// null. Returns 'last' if there is none.
+uint32_t     bitfield_find_next(const uint8_t* a, const uint8_t* b, uint32_t first, uint32_t last);
+
+// Adds or subtracts one from 'counters[i]' for each set bit 'i'. The
+// caller must ensure the counters do not wrap.
+void         bitfield_increment_counters(uint8_t* counters, const uint8_t* bits, uint32_t size_bits);
+void         bitfield_decrement_counters(uint8_t* counters, const uint8_t* bits, uint32_t size_bits);
+
+} // namespace torrent
+
+#endif
@@ -0,0 +1,118 @@
+#include "config.h"
+
+#include "utils/diffie_hellman_pool.h"
+
+#include <pthread.h>
+
+#include "torrent/exceptions.h"
+#include "utils/diffie_hellman.h"
+
+namespace torrent {
+
+DiffieHellmanPool::DiffieHellmanPool(const unsigned char prime[], int prime_length,
+                                     const unsigned char generator[], int generator_length) :
+    m_prime(prime),
+    m_prime_length(prime_length),
+    m_generator(generator),
+    m_generator_length(generator_length) {
+}
+
+DiffieHellmanPool::~DiffieHellmanPool() {
+  {
+    auto guard = std::lock_guard(m_lock);
+    m_stopping = true;
+  }
+
+  m_worker_cond.notify_all();
+
+  if (m_worker.joinable())
+    m_worker.join();
+}
+
+unsigned int
+DiffieHellmanPool::reserve() const {
+  auto guard = std::lock_guard(m_lock);
+  return m_reserve;
+}
+
+size_t
+DiffieHellmanPool::size() const {
+  auto guard = std::lock_guard(m_lock);
+  return m_keys.size();
+}
+
+void
+DiffieHellmanPool::set_reserve(unsigned int reserve) {
+  if (reserve > max_reserve)
+    throw input_error("Tried to set a Diffie-Hellman key reserve greater than " + std::to_string(max_reserve) + ".");
+
+  {
+    auto guard = std::lock_guard(m_lock);
+
+    if (reserve == m_reserve)
+      return;
+
+    m_reserve = reserve;
+
+    if (m_keys.size() > m_reserve)
+      m_keys.resize(m_reserve);
+
+    if (m_reserve != 0 && !m_worker.joinable())
+      m_worker = std::thread(&DiffieHellmanPool::worker_loop, this);
+  }
+
+  m_worker_cond.notify_all();
+}
+
+DiffieHellmanPool::key_ptr
+DiffieHellmanPool::take() {
+  {
+    auto guard = std::lock_guard(m_lock);
+
+    if (!m_keys.empty()) {
+      auto key = std::move(m_keys.back());
+      m_keys.pop_back();
+
+      m_worker_cond.notify_all();
+      return key;
+    }
+  }
+
+  return generate();
+}
+
+DiffieHellmanPool::key_ptr
+DiffieHellmanPool::generate() const {
+  return std::make_unique<DiffieHellman>(m_prime, m_prime_length, m_generator, m_generator_length);
+}
+
+void
+DiffieHellmanPool::worker_loop() {
+#if defined(HAS_PTHREAD_SETNAME_NP_DARWIN)
+  pthread_setname_np("rtorrent-dh");
+#elif defined(HAS_PTHREAD_SETNAME_NP_GENERIC)
+  pthread_setname_np(pthread_self(), "rtorrent-dh");
+#endif
+
+  while (true) {
+    {
+      auto guard = std::unique_lock(m_lock);
+
+      m_worker_cond.wait(guard, [this] { return m_stopping || m_keys.size() < m_reserve; });
+
+      if (m_stopping)
+        return;
+    }
+
+    auto key = generate();
+
+    // Keys that fail to generate are left for take() to detect, as the
+    // caller generating its own key would fail the same way.
+    auto guard = std::lock_guard(m_lock);
+
+    if (m_keys.size() < m_reserve)
+      m_keys.push_back(std::move(key));
+  }
+}
+
+} // namespace torrent
@@ -0,0 +1,63 @@
+#ifndef LIBTORRENT_UTILS_DIFFIE_HELLMAN_POOL_H
+#define LIBTORRENT_UTILS_DIFFIE_HELLMAN_POOL_H
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace torrent {
+
+class DiffieHellman;
+
+// Keeps a reserve of Diffie-Hellman keys generated ahead of time by a
+// worker thread, so that encrypted handshakes do not have to generate
+// them on the main thread.
+//
+// Each key is handed out once. If the reserve is empty, or zero, the
+// key is generated by the caller.
+
+class DiffieHellmanPool {
+public:
+  using key_ptr = std::unique_ptr<DiffieHellman>;
+
+  static constexpr unsigned int max_reserve = 1024;
+
+  DiffieHellmanPool(const unsigned char prime[], int prime_length,
+                    const unsigned char generator[], int generator_length);
+  ~DiffieHellmanPool();
+
+  unsigned int        reserve() const;
+  size_t              size() const;
+
+  // The worker thread is started the first time the reserve is set to
+  // a non-zero value.
+  void                set_reserve(unsigned int reserve);
+
+  key_ptr             take();
+
+private:
+  DiffieHellmanPool(const DiffieHellmanPool&) = delete;
+  DiffieHellmanPool& operator=(const DiffieHellmanPool&) = delete;
+
+  key_ptr             generate() const;
+
+  void                worker_loop();
+
+  const unsigned char*    m_prime;
+  int                     m_prime_length;
+  const unsigned char*    m_generator;
+  int                     m_generator_length;
+
+  mutable std::mutex      m_lock;
+  std::condition_variable m_worker_cond;
+  std::vector<key_ptr>    m_keys;
+  unsigned int            m_reserve{0};
+  bool                    m_stopping{false};
+  std::thread             m_worker;
+};
+
+} // namespace torrent
+
+#endif
@@ -67,7 +67,10 @@ instrumentation_tick() {
                " %"  PRIi64 " %" PRIi64 " %" PRIi64 " %" PRIi64
                " %"  PRIi64 " %" PRIi64 " %" PRIi64 " %" PRIi64
                " %"  PRIi64 " %" PRIi64 " %" PRIi64 " %" PRIi64
-               " %" PRIi64,
+               " %" PRIi64
+               " %" PRIi64 " %" PRIi64
+               " %" PRIi64 " %" PRIi64 " %" PRIi64
+               " %" PRIi64 " %" PRIi64 " %" PRIi64 " %" PRIi64 " %" PRIi64,
 
                instrumentation_fetch_and_clear(INSTRUMENTATION_TRANSFER_REQUESTS_DELEGATED),
                instrumentation_fetch_and_clear(INSTRUMENTATION_TRANSFER_REQUESTS_DOWNLOADING),
@@ -96,7 +99,50 @@ instrumentation_tick() {
                instrumentation_fetch_and_clear(INSTRUMENTATION_TRANSFER_REQUESTS_CHOKED_REMOVED),
                instrumentation_values[INSTRUMENTATION_TRANSFER_REQUESTS_CHOKED_TOTAL].load(),
 
-               instrumentation_values[INSTRUMENTATION_TRANSFER_PEER_INFO_UNACCOUNTED].load());
+               instrumentation_values[INSTRUMENTATION_TRANSFER_PEER_INFO_UNACCOUNTED].load(),
+
+               instrumentation_fetch_and_clear(INSTRUMENTATION_TRANSFER_UPLOAD_VECTORED_WRITES),
+               instrumentation_fetch_and_clear(INSTRUMENTATION_TRANSFER_UPLOAD_VECTORED_PARTS),
+
+               instrumentation_fetch_and_clear(INSTRUMENTATION_TRANSFER_REQUESTS_DUPLICATED),
+               instrumentation_fetch_and_clear(INSTRUMENTATION_TRANSFER_REQUESTS_CANCELLED),
+               instrumentation_fetch_and_clear(INSTRUMENTATION_TRANSFER_WASTED_BYTES),
+
+               instrumentation_fetch_and_clear(INSTRUMENTATION_TRANSFER_PIPE_DEPTH_8),
+               instrumentation_fetch_and_clear(INSTRUMENTATION_TRANSFER_PIPE_DEPTH_32),
+               instrumentation_fetch_and_clear(INSTRUMENTATION_TRANSFER_PIPE_DEPTH_128),
+               instrumentation_fetch_and_clear(INSTRUMENTATION_TRANSFER_PIPE_DEPTH_512),
+               instrumentation_fetch_and_clear(INSTRUMENTATION_TRANSFER_PIPE_DEPTH_LARGE));
+
+  lt_log_print(LOG_INSTRUMENTATION_HASHING,
+               "%"  PRIi64 " %" PRIi64 " %" PRIi64
+               " %"  PRIi64 " %" PRIi64 " %" PRIi64
+               " %"  PRIi64 " %" PRIi64 " %" PRIi64,
+               instrumentation_values[INSTRUMENTATION_HASHING_QUEUED_DOWNLOAD].load(),
+               instrumentation_values[INSTRUMENTATION_HASHING_QUEUED_RESUME].load(),
+               instrumentation_values[INSTRUMENTATION_HASHING_QUEUED_RECHECK].load(),
+
+               instrumentation_fetch_and_clear(INSTRUMENTATION_HASHING_STARTED_DOWNLOAD),
+               instrumentation_fetch_and_clear(INSTRUMENTATION_HASHING_STARTED_RESUME),
+               instrumentation_fetch_and_clear(INSTRUMENTATION_HASHING_STARTED_RECHECK),
+
+               instrumentation_fetch_and_clear(INSTRUMENTATION_HASHING_WAIT_USEC_DOWNLOAD),
+               instrumentation_fetch_and_clear(INSTRUMENTATION_HASHING_WAIT_USEC_RESUME),
+               instrumentation_fetch_and_clear(INSTRUMENTATION_HASHING_WAIT_USEC_RECHECK));
+
+  lt_log_print(LOG_INSTRUMENTATION_WRITEBACK,
+               "%"  PRIi64 " %" PRIi64 " %" PRIi64 " %" PRIi64
+               " %"  PRIi64 " %" PRIi64 " %" PRIi64 " %" PRIi64 " %" PRIi64,
+               instrumentation_fetch_and_clear(INSTRUMENTATION_WRITEBACK_BATCHES),
+               instrumentation_fetch_and_clear(INSTRUMENTATION_WRITEBACK_CHUNKS),
+               instrumentation_fetch_and_clear(INSTRUMENTATION_WRITEBACK_RANGES),
+               instrumentation_fetch_and_clear(INSTRUMENTATION_WRITEBACK_FAILED),
+
+               instrumentation_fetch_and_clear(INSTRUMENTATION_WRITEBACK_LATENCY_1MS),
+               instrumentation_fetch_and_clear(INSTRUMENTATION_WRITEBACK_LATENCY_10MS),
+               instrumentation_fetch_and_clear(INSTRUMENTATION_WRITEBACK_LATENCY_100MS),
+               instrumentation_fetch_and_clear(INSTRUMENTATION_WRITEBACK_LATENCY_1S),
+               instrumentation_fetch_and_clear(INSTRUMENTATION_WRITEBACK_LATENCY_SLOW));
 }
 
 void
@@ -148,6 +194,36 @@ instrumentation_reset() {
   instrumentation_fetch_and_clear(INSTRUMENTATION_TRANSFER_REQUESTS_CHOKED_ADDED);
   instrumentation_fetch_and_clear(INSTRUMENTATION_TRANSFER_REQUESTS_CHOKED_MOVED);
   instrumentation_fetch_and_clear(INSTRUMENTATION_TRANSFER_REQUESTS_CHOKED_REMOVED);
+
+  instrumentation_fetch_and_clear(INSTRUMENTATION_TRANSFER_UPLOAD_VECTORED_WRITES);
+  instrumentation_fetch_and_clear(INSTRUMENTATION_TRANSFER_UPLOAD_VECTORED_PARTS);
+
+  instrumentation_fetch_and_clear(INSTRUMENTATION_TRANSFER_REQUESTS_DUPLICATED);
+  instrumentation_fetch_and_clear(INSTRUMENTATION_TRANSFER_REQUESTS_CANCELLED);
+  instrumentation_fetch_and_clear(INSTRUMENTATION_TRANSFER_WASTED_BYTES);
+
+  instrumentation_fetch_and_clear(INSTRUMENTATION_TRANSFER_PIPE_DEPTH_8);
+  instrumentation_fetch_and_clear(INSTRUMENTATION_TRANSFER_PIPE_DEPTH_32);
+  instrumentation_fetch_and_clear(INSTRUMENTATION_TRANSFER_PIPE_DEPTH_128);
+  instrumentation_fetch_and_clear(INSTRUMENTATION_TRANSFER_PIPE_DEPTH_512);
+  instrumentation_fetch_and_clear(INSTRUMENTATION_TRANSFER_PIPE_DEPTH_LARGE);
+
+  instrumentation_fetch_and_clear(INSTRUMENTATION_HASHING_STARTED_DOWNLOAD);
+  instrumentation_fetch_and_clear(INSTRUMENTATION_HASHING_STARTED_RESUME);
+  instrumentation_fetch_and_clear(INSTRUMENTATION_HASHING_STARTED_RECHECK);
+  instrumentation_fetch_and_clear(INSTRUMENTATION_HASHING_WAIT_USEC_DOWNLOAD);
+  instrumentation_fetch_and_clear(INSTRUMENTATION_HASHING_WAIT_USEC_RESUME);
+  instrumentation_fetch_and_clear(INSTRUMENTATION_HASHING_WAIT_USEC_RECHECK);
+
+  instrumentation_fetch_and_clear(INSTRUMENTATION_WRITEBACK_BATCHES);
+  instrumentation_fetch_and_clear(INSTRUMENTATION_WRITEBACK_CHUNKS);
+  instrumentation_fetch_and_clear(INSTRUMENTATION_WRITEBACK_RANGES);
+  instrumentation_fetch_and_clear(INSTRUMENTATION_WRITEBACK_FAILED);
+  instrumentation_fetch_and_clear(INSTRUMENTATION_WRITEBACK_LATENCY_1MS);
+  instrumentation_fetch_and_clear(INSTRUMENTATION_WRITEBACK_LATENCY_10MS);
+  instrumentation_fetch_and_clear(INSTRUMENTATION_WRITEBACK_LATENCY_100MS);
+  instrumentation_fetch_and_clear(INSTRUMENTATION_WRITEBACK_LATENCY_1S);
+  instrumentation_fetch_and_clear(INSTRUMENTATION_WRITEBACK_LATENCY_SLOW);
 }
 
 } // namespace torrent
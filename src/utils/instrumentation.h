@@ -72,6 +72,40 @@ enum instrumentation_enum {
 
   INSTRUMENTATION_TRANSFER_PEER_INFO_UNACCOUNTED,
 
+  INSTRUMENTATION_TRANSFER_UPLOAD_VECTORED_WRITES,
+  INSTRUMENTATION_TRANSFER_UPLOAD_VECTORED_PARTS,
+
+  INSTRUMENTATION_TRANSFER_REQUESTS_DUPLICATED,
+  INSTRUMENTATION_TRANSFER_REQUESTS_CANCELLED,
+  INSTRUMENTATION_TRANSFER_WASTED_BYTES,
+
+  INSTRUMENTATION_TRANSFER_PIPE_DEPTH_8,
+  INSTRUMENTATION_TRANSFER_PIPE_DEPTH_32,
+  INSTRUMENTATION_TRANSFER_PIPE_DEPTH_128,
+  INSTRUMENTATION_TRANSFER_PIPE_DEPTH_512,
+  INSTRUMENTATION_TRANSFER_PIPE_DEPTH_LARGE,
+
+  // Indexed by HashChunk::priority_enum.
+  INSTRUMENTATION_HASHING_QUEUED_DOWNLOAD,
+  INSTRUMENTATION_HASHING_QUEUED_RESUME,
+  INSTRUMENTATION_HASHING_QUEUED_RECHECK,
+  INSTRUMENTATION_HASHING_STARTED_DOWNLOAD,
+  INSTRUMENTATION_HASHING_STARTED_RESUME,
+  INSTRUMENTATION_HASHING_STARTED_RECHECK,
+  INSTRUMENTATION_HASHING_WAIT_USEC_DOWNLOAD,
+  INSTRUMENTATION_HASHING_WAIT_USEC_RESUME,
+  INSTRUMENTATION_HASHING_WAIT_USEC_RECHECK,
+
+  INSTRUMENTATION_WRITEBACK_BATCHES,
+  INSTRUMENTATION_WRITEBACK_CHUNKS,
+  INSTRUMENTATION_WRITEBACK_RANGES,
+  INSTRUMENTATION_WRITEBACK_FAILED,
+  INSTRUMENTATION_WRITEBACK_LATENCY_1MS,
+  INSTRUMENTATION_WRITEBACK_LATENCY_10MS,
+  INSTRUMENTATION_WRITEBACK_LATENCY_100MS,
+  INSTRUMENTATION_WRITEBACK_LATENCY_1S,
+  INSTRUMENTATION_WRITEBACK_LATENCY_SLOW,
+
   INSTRUMENTATION_MAX_SIZE
 };
 
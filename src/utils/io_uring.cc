@@ -0,0 +1,207 @@
+#include "config.h"
+
+#include "utils/io_uring.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+#ifdef USE_IO_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace torrent::utils {
+
+#ifdef USE_IO_URING
+
+namespace {
+
+int
+sys_io_uring_setup(unsigned int entries, io_uring_params* params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int
+sys_io_uring_enter(int fd, unsigned int to_submit, unsigned int min_complete, unsigned int flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+template <typename T>
+T*
+ring_offset(void* ring, uint32_t offset) {
+  return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+}
+
+} // namespace
+
+IoUring::IoUring(unsigned int entries) {
+  io_uring_params params{};
+
+  m_fd = sys_io_uring_setup(entries, &params);
+
+  if (m_fd == -1)
+    return;
+
+  m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+  m_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  m_sqes_size    = params.sq_entries * sizeof(io_uring_sqe);
+
+  if (params.features & IORING_FEAT_SINGLE_MMAP)
+    m_sq_ring_size = m_cq_ring_size = std::max(m_sq_ring_size, m_cq_ring_size);
+
+  m_sq_ring = mmap(nullptr, m_sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+
+  if (m_sq_ring == MAP_FAILED) {
+    m_sq_ring = nullptr;
+    ::close(m_fd);
+    m_fd = -1;
+    return;
+  }
+
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    m_cq_ring = m_sq_ring;
+  } else {
+    m_cq_ring = mmap(nullptr, m_cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+
+    if (m_cq_ring == MAP_FAILED) {
+      m_cq_ring = nullptr;
+      munmap(m_sq_ring, m_sq_ring_size);
+      m_sq_ring = nullptr;
+      ::close(m_fd);
+      m_fd = -1;
+      return;
+    }
+  }
+
+  void* sqes = mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+
+  if (sqes == MAP_FAILED) {
+    if (m_cq_ring != m_sq_ring)
+      munmap(m_cq_ring, m_cq_ring_size);
+
+    munmap(m_sq_ring, m_sq_ring_size);
+    m_sq_ring = m_cq_ring = nullptr;
+    ::close(m_fd);
+    m_fd = -1;
+    return;
+  }
+
+  m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+  m_sq_head    = ring_offset<unsigned int>(m_sq_ring, params.sq_off.head);
+  m_sq_tail    = ring_offset<unsigned int>(m_sq_ring, params.sq_off.tail);
+  m_sq_mask    = ring_offset<unsigned int>(m_sq_ring, params.sq_off.ring_mask);
+  m_sq_entries = ring_offset<unsigned int>(m_sq_ring, params.sq_off.ring_entries);
+  m_sq_array   = ring_offset<unsigned int>(m_sq_ring, params.sq_off.array);
+
+  m_cq_head    = ring_offset<unsigned int>(m_cq_ring, params.cq_off.head);
+  m_cq_tail    = ring_offset<unsigned int>(m_cq_ring, params.cq_off.tail);
+  m_cq_mask    = ring_offset<unsigned int>(m_cq_ring, params.cq_off.ring_mask);
+  m_cqes       = ring_offset<io_uring_cqe>(m_cq_ring, params.cq_off.cqes);
+}
+
+IoUring::~IoUring() {
+  if (m_fd == -1)
+    return;
+
+  munmap(m_sqes, m_sqes_size);
+
+  if (m_cq_ring != m_sq_ring)
+    munmap(m_cq_ring, m_cq_ring_size);
+
+  munmap(m_sq_ring, m_sq_ring_size);
+  ::close(m_fd);
+}
+
+bool
+IoUring::is_supported() {
+  static const bool supported = [] {
+      IoUring ring(1);
+      return ring.is_valid();
+    }();
+
+  return supported;
+}
+
+unsigned int
+IoUring::sq_space_left() const {
+  unsigned int head = __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE);
+  unsigned int tail = *m_sq_tail + m_sq_pending;
+
+  return *m_sq_entries - (tail - head);
+}
+
+bool
+IoUring::prepare_read(int fd, void* buffer, uint32_t length, uint64_t offset, uint64_t user_data) {
+  if (sq_space_left() == 0)
+    return false;
+
+  unsigned int index = (*m_sq_tail + m_sq_pending) & *m_sq_mask;
+  io_uring_sqe* sqe = &m_sqes[index];
+
+  std::memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode    = IORING_OP_READ;
+  sqe->fd        = fd;
+  sqe->addr      = reinterpret_cast<uint64_t>(buffer);
+  sqe->len       = length;
+  sqe->off       = offset;
+  sqe->user_data = user_data;
+
+  m_sq_array[index] = index;
+  m_sq_pending++;
+
+  return true;
+}
+
+bool
+IoUring::submit_and_wait(unsigned int wait_count) {
+  __atomic_store_n(m_sq_tail, *m_sq_tail + m_sq_pending, __ATOMIC_RELEASE);
+  m_sq_pending = 0;
+
+  while (true) {
+    // Submit every entry the kernel has not consumed yet, including
+    // any left over from an interrupted or partial submission.
+    unsigned int to_submit = *m_sq_tail - __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE);
+
+    int result = sys_io_uring_enter(m_fd, to_submit, wait_count, wait_count != 0 ? IORING_ENTER_GETEVENTS : 0);
+
+    if (result >= 0)
+      return true;
+
+    if (errno != EINTR)
+      return false;
+  }
+}
+
+bool
+IoUring::pop_completion(uint64_t* user_data, int32_t* result) {
+  unsigned int head = *m_cq_head;
+
+  if (head == __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE))
+    return false;
+
+  io_uring_cqe* cqe = &m_cqes[head & *m_cq_mask];
+
+  *user_data = cqe->user_data;
+  *result    = cqe->res;
+
+  __atomic_store_n(m_cq_head, head + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+#else // USE_IO_URING
+
+IoUring::IoUring(unsigned int) {}
+IoUring::~IoUring() = default;
+
+bool         IoUring::is_supported()                                    { return false; }
+unsigned int IoUring::sq_space_left() const                             { return 0; }
+bool         IoUring::prepare_read(int, void*, uint32_t, uint64_t, uint64_t) { return false; }
+bool         IoUring::submit_and_wait(unsigned int)                     { return false; }
+bool         IoUring::pop_completion(uint64_t*, int32_t*)               { return false; }
+
+#endif // USE_IO_URING
+
+} // namespace torrent::utils
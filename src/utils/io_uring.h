@@ -0,0 +1,72 @@
+#ifndef LIBTORRENT_UTILS_IO_URING_H
+#define LIBTORRENT_UTILS_IO_URING_H
+
+#include <cinttypes>
+#include <cstddef>
+
+#ifdef USE_IO_URING
+#include <linux/io_uring.h>
+#endif
+
+namespace torrent::utils {
+
+// Minimal io_uring wrapper using the raw syscalls, only supporting
+// what is needed for queuing reads from a single thread.
+//
+// Without USE_IO_URING, or if the kernel refuses to create the ring,
+// is_valid() returns false and no other functions may be called.
+
+class IoUring {
+public:
+  IoUring(unsigned int entries);
+  ~IoUring();
+
+  static bool         is_supported();
+
+  bool                is_valid() const      { return m_fd != -1; }
+
+  unsigned int        sq_space_left() const;
+
+  // Returns false if the submission queue is full.
+  bool                prepare_read(int fd, void* buffer, uint32_t length, uint64_t offset, uint64_t user_data);
+
+  // Submits prepared entries and waits for at least 'wait_count'
+  // completions. A signal arriving after the entries were submitted
+  // may end the wait early. Returns false on errors other than EINTR.
+  bool                submit_and_wait(unsigned int wait_count);
+
+  // Returns false when the completion queue is empty.
+  bool                pop_completion(uint64_t* user_data, int32_t* result);
+
+private:
+  IoUring(const IoUring&) = delete;
+  IoUring& operator=(const IoUring&) = delete;
+
+  int                 m_fd{-1};
+
+#ifdef USE_IO_URING
+  void*               m_sq_ring{};
+  size_t              m_sq_ring_size{};
+  void*               m_cq_ring{};
+  size_t              m_cq_ring_size{};
+  io_uring_sqe*       m_sqes{};
+  size_t              m_sqes_size{};
+
+  unsigned int*       m_sq_head{};
+  unsigned int*       m_sq_tail{};
+  unsigned int*       m_sq_mask{};
+  unsigned int*       m_sq_entries{};
+  unsigned int*       m_sq_array{};
+
+  unsigned int*       m_cq_head{};
+  unsigned int*       m_cq_tail{};
+  unsigned int*       m_cq_mask{};
+  io_uring_cqe*       m_cqes{};
+
+  unsigned int        m_sq_pending{};
+#endif
+};
+
+} // namespace torrent::utils
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef LIBTORRENT_UTILS_MPSC_RING_H
+#define LIBTORRENT_UTILS_MPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include "torrent/common.h"
+#include "torrent/exceptions.h"
+
+namespace torrent::utils {
+
+// Bounded lock-free queue for multiple producers and a single consumer,
+// using a sequence number per cell to hand off ownership of the cell.
+//
+// Capacity must be a power of two. Producers that find the ring full
+// get a false return value and must handle the overflow themselves.
+
+template <typename T>
+class MpscRing {
+public:
+  MpscRing(size_t capacity);
+
+  size_t              capacity() const { return m_mask + 1; }
+
+  // Safe to call from any thread.
+  bool                try_push(const T& value);
+
+  // Only call from the consumer thread.
+  bool                try_pop(T& value);
+
+private:
+  MpscRing(const MpscRing&) = delete;
+  MpscRing& operator=(const MpscRing&) = delete;
+
+  struct cell_type {
+    std::atomic<size_t> sequence;
+    T                   value;
+  };
+
+  const size_t                 m_mask;
+  std::unique_ptr<cell_type[]> m_cells;
+
+  align_cacheline std::atomic<size_t> m_tail{0};
+  align_cacheline size_t              m_head{0};
+};
+
+template <typename T>
+MpscRing<T>::MpscRing(size_t capacity) :
+    m_mask(capacity - 1),
+    m_cells(new cell_type[capacity]) {
+
+  if (capacity == 0 || (capacity & m_mask) != 0)
+    throw internal_error("MpscRing::MpscRing(...) capacity must be a power of two.");
+
+  for (size_t i = 0; i < capacity; i++)
+    m_cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+template <typename T>
+bool
+MpscRing<T>::try_push(const T& value) {
+  size_t position = m_tail.load(std::memory_order_relaxed);
+
+  while (true) {
+    cell_type& cell     = m_cells[position & m_mask];
+    size_t     sequence = cell.sequence.load(std::memory_order_acquire);
+
+    auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+    if (diff == 0) {
+      if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+        cell.value = value;
+        cell.sequence.store(position + 1, std::memory_order_release);
+        return true;
+      }
+
+    } else if (diff < 0) {
+      return false;
+
+    } else {
+      position = m_tail.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+template <typename T>
+bool
+MpscRing<T>::try_pop(T& value) {
+  cell_type& cell     = m_cells[m_head & m_mask];
+  size_t     sequence = cell.sequence.load(std::memory_order_acquire);
+
+  if (sequence != m_head + 1)
+    return false;
+
+  value = cell.value;
+  cell.sequence.store(m_head + m_mask + 1, std::memory_order_release);
+  m_head++;
+
+  return true;
+}
+
+} // namespace torrent::utils
+
+#endif
@@ -39,7 +39,13 @@
 
 #include "config.h"
 
+#include <openssl/opensslconf.h>
+
+#ifdef OPENSSL_NO_RC4
+#include "utils/rc4_portable.h"
+#else
 #include <openssl/rc4.h>
+#endif
 
 namespace torrent {
 
@@ -47,6 +53,16 @@ class RC4 {
 public:
   RC4()                                                               { }
 
+#ifdef OPENSSL_NO_RC4
+  RC4(const unsigned char key[], int len) : m_key(key, len)           { }
+
+  void crypt(const void* indata, void* outdata, unsigned int length)  { m_key.crypt(indata, outdata, length); }
+  void crypt(void* data, unsigned int length)                         { m_key.crypt(data, data, length); }
+
+private:
+  RC4Portable m_key;
+
+#else
 #pragma GCC diagnostic ignored "-Wdeprecated-declarations"
   RC4(const unsigned char key[], int len)                             { RC4_set_key(&m_key, len, key); }
 
@@ -55,6 +71,7 @@ public:
 
 private:
   RC4_KEY m_key;
+#endif
 
 };
 
@@ -0,0 +1,78 @@
+#include "config.h"
+
+#include "utils/rc4_portable.h"
+
+#include <cstring>
+
+namespace torrent {
+
+namespace {
+
+[[gnu::always_inline]] inline uint8_t
+rc4_next(uint32_t* state, uint32_t& x, uint32_t& y) {
+  x = (x + 1) & 0xff;
+  uint32_t tx = state[x];
+
+  y = (y + tx) & 0xff;
+  uint32_t ty = state[y];
+
+  state[x] = ty;
+  state[y] = tx;
+
+  return static_cast<uint8_t>(state[(tx + ty) & 0xff]);
+}
+
+} // namespace
+
+RC4Portable::RC4Portable(const unsigned char key[], int len) {
+  for (uint32_t i = 0; i < 256; i++)
+    m_state[i] = i;
+
+  if (len <= 0)
+    return;
+
+  uint32_t j = 0;
+
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t t = m_state[i];
+
+    j = (j + t + key[i % len]) & 0xff;
+
+    m_state[i] = m_state[j];
+    m_state[j] = t;
+  }
+}
+
+void
+RC4Portable::crypt(const void* indata, void* outdata, unsigned int length) {
+  auto in  = static_cast<const uint8_t*>(indata);
+  auto out = static_cast<uint8_t*>(outdata);
+
+  // Work on local copies so the compiler does not need to assume the
+  // data aliases the cipher state.
+  uint32_t x = m_x;
+  uint32_t y = m_y;
+
+  for (; length >= 8; length -= 8, in += 8, out += 8) {
+    uint8_t keystream[8];
+
+    for (unsigned int i = 0; i < 8; i++)
+      keystream[i] = rc4_next(m_state, x, y);
+
+    uint64_t value;
+    uint64_t mask;
+    std::memcpy(&value, in, sizeof(value));
+    std::memcpy(&mask, keystream, sizeof(mask));
+
+    value ^= mask;
+    std::memcpy(out, &value, sizeof(value));
+  }
+
+  for (unsigned int i = 0; i < length; i++)
+    out[i] = in[i] ^ rc4_next(m_state, x, y);
+
+  m_x = x;
+  m_y = y;
+}
+
+} // namespace torrent
@@ -0,0 +1,30 @@
+#ifndef LIBTORRENT_UTILS_RC4_PORTABLE_H
+#define LIBTORRENT_UTILS_RC4_PORTABLE_H
+
+#include <cinttypes>
+
+namespace torrent {
+
+// Portable RC4, used when OpenSSL is built without RC4 support.
+//
+// OpenSSL's assembly implementation is faster where available, so this
+// only aims to avoid the obvious overhead: the state is kept in 32 bit
+// words and the keystream is applied 8 bytes at a time. The buffers
+// may be unaligned and may be the same, but must not otherwise overlap.
+
+class RC4Portable {
+public:
+  RC4Portable() = default;
+  RC4Portable(const unsigned char key[], int len);
+
+  void                crypt(const void* indata, void* outdata, unsigned int length);
+
+private:
+  uint32_t            m_x{0};
+  uint32_t            m_y{0};
+  uint32_t            m_state[256]{};
+};
+
+} // namespace torrent
+
+#endif
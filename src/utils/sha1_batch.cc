@@ -0,0 +1,370 @@
+#include "config.h"
+
+#include "utils/sha1_batch.h"
+
+#include <cstring>
+
+#include "torrent/exceptions.h"
+#include "utils/sha1.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <cpuid.h>
+#define USE_SHA1_BATCH_X86 1
+
+#ifndef bit_SHA
+#define bit_SHA (1 << 29)
+#endif
+#endif
+
+namespace torrent {
+
+namespace {
+
+// Provides the 64 byte blocks of a single message, copying only when
+// a block spans segments and for the final padded blocks.
+class sha1_lane_reader {
+public:
+  void                reset(const sha1_segments* segments);
+
+  const char*         next_block();
+
+  // Returns the number of final blocks, which is the same for all
+  // messages of the same length.
+  unsigned int        prepare_final(uint64_t length);
+  const char*         final_block(unsigned int index) const { return m_buffer + index * 64; }
+
+private:
+  void                skip_empty();
+
+  const sha1_segments* m_segments;
+  size_t               m_index;
+  uint32_t             m_offset;
+
+  alignas(64) char     m_buffer[128];
+};
+
+void
+sha1_lane_reader::reset(const sha1_segments* segments) {
+  m_segments = segments;
+  m_index    = 0;
+  m_offset   = 0;
+
+  skip_empty();
+}
+
+void
+sha1_lane_reader::skip_empty() {
+  while (m_index < m_segments->size() && m_offset == (*m_segments)[m_index].second) {
+    m_index++;
+    m_offset = 0;
+  }
+}
+
+const char*
+sha1_lane_reader::next_block() {
+  if (m_index == m_segments->size())
+    throw internal_error("sha1_lane_reader::next_block() reached end of segments.");
+
+  const auto& segment = (*m_segments)[m_index];
+
+  if (segment.second - m_offset >= 64) {
+    const char* block = segment.first + m_offset;
+
+    m_offset += 64;
+    skip_empty();
+
+    return block;
+  }
+
+  uint32_t copied = 0;
+
+  while (copied != 64) {
+    if (m_index == m_segments->size())
+      throw internal_error("sha1_lane_reader::next_block() segments shorter than message length.");
+
+    const auto& current = (*m_segments)[m_index];
+    uint32_t length = std::min<uint32_t>(64 - copied, current.second - m_offset);
+
+    std::memcpy(m_buffer + copied, current.first + m_offset, length);
+
+    copied   += length;
+    m_offset += length;
+    skip_empty();
+  }
+
+  return m_buffer;
+}
+
+unsigned int
+sha1_lane_reader::prepare_final(uint64_t length) {
+  uint32_t remaining = length % 64;
+  uint32_t copied = 0;
+
+  while (copied != remaining) {
+    if (m_index == m_segments->size())
+      throw internal_error("sha1_lane_reader::prepare_final() segments shorter than message length.");
+
+    const auto& current = (*m_segments)[m_index];
+    uint32_t part_length = std::min<uint32_t>(remaining - copied, current.second - m_offset);
+
+    std::memcpy(m_buffer + copied, current.first + m_offset, part_length);
+
+    copied   += part_length;
+    m_offset += part_length;
+    skip_empty();
+  }
+
+  unsigned int blocks = remaining + 9 <= 64 ? 1 : 2;
+  uint64_t     bits   = length * 8;
+
+  std::memset(m_buffer + remaining, 0, blocks * 64 - remaining);
+  m_buffer[remaining] = static_cast<char>(0x80);
+
+  for (unsigned int i = 0; i < 8; i++)
+    m_buffer[blocks * 64 - 1 - i] = static_cast<char>(bits >> (i * 8));
+
+  return blocks;
+}
+
+#ifdef USE_SHA1_BATCH_X86
+
+using sha1_v4  = uint32_t __attribute__((vector_size(16)));
+using sha1_v8  = uint32_t __attribute__((vector_size(32)));
+using sha1_v16 = uint32_t __attribute__((vector_size(64)));
+
+[[gnu::always_inline]] inline uint32_t
+sha1_load_be32(const char* ptr) {
+  uint32_t value;
+  std::memcpy(&value, ptr, sizeof(value));
+
+  return __builtin_bswap32(value);
+}
+
+[[gnu::always_inline]] inline void
+sha1_store_be32(char* ptr, uint32_t value) {
+  value = __builtin_bswap32(value);
+  std::memcpy(ptr, &value, sizeof(value));
+}
+
+// Vectors are only passed by reference as the non-inlined signatures
+// would otherwise depend on the target ABI.
+template <int N, typename V>
+[[gnu::always_inline]] inline void
+sha1_rotl(V& result, const V& x) {
+  result = (x << N) | (x >> (32 - N));
+}
+
+template <typename V, unsigned int L>
+[[gnu::always_inline]] inline void
+sha1_compress(V* state, const char* const* blocks) {
+  // Transpose through memory, as inserting single elements into the
+  // vectors is considerably slower.
+  alignas(64) uint32_t words[16][L];
+
+  for (unsigned int l = 0; l < L; l++)
+    for (unsigned int t = 0; t < 16; t++)
+      words[t][l] = sha1_load_be32(blocks[l] + 4 * t);
+
+  V w[16];
+  std::memcpy(w, words, sizeof(w));
+
+  V a = state[0];
+  V b = state[1];
+  V c = state[2];
+  V d = state[3];
+  V e = state[4];
+
+  for (unsigned int t = 0; t < 80; t++) {
+    if (t >= 16)
+      sha1_rotl<1>(w[t & 15], w[(t - 3) & 15] ^ w[(t - 8) & 15] ^ w[(t - 14) & 15] ^ w[t & 15]);
+
+    V f;
+
+    if (t < 20)
+      f = (d ^ (b & (c ^ d))) + 0x5a827999u;
+    else if (t < 40)
+      f = (b ^ c ^ d) + 0x6ed9eba1u;
+    else if (t < 60)
+      f = ((b & c) | (d & (b | c))) + 0x8f1bbcdcu;
+    else
+      f = (b ^ c ^ d) + 0xca62c1d6u;
+
+    V temp;
+    sha1_rotl<5>(temp, a);
+    temp += f + e + w[t & 15];
+
+    e = d;
+    d = c;
+    sha1_rotl<30>(c, b);
+    b = a;
+    a = temp;
+  }
+
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+}
+
+// Unused lanes hash a copy of the first message and are discarded.
+template <typename V, unsigned int L>
+[[gnu::always_inline]] inline void
+sha1_batch_impl(const sha1_segments* messages, unsigned int count, uint64_t length, char* digests) {
+  sha1_lane_reader readers[L];
+  const char*      blocks[L];
+
+  for (unsigned int l = 0; l < L; l++)
+    readers[l].reset(&messages[l < count ? l : 0]);
+
+  V state[5] = { V{} + 0x67452301u, V{} + 0xefcdab89u, V{} + 0x98badcfeu, V{} + 0x10325476u, V{} + 0xc3d2e1f0u };
+
+  for (uint64_t i = 0; i < length / 64; i++) {
+    for (unsigned int l = 0; l < L; l++)
+      blocks[l] = readers[l].next_block();
+
+    sha1_compress<V, L>(state, blocks);
+  }
+
+  unsigned int final_blocks = 0;
+
+  for (unsigned int l = 0; l < L; l++)
+    final_blocks = readers[l].prepare_final(length);
+
+  for (unsigned int i = 0; i < final_blocks; i++) {
+    for (unsigned int l = 0; l < L; l++)
+      blocks[l] = readers[l].final_block(i);
+
+    sha1_compress<V, L>(state, blocks);
+  }
+
+  for (unsigned int l = 0; l < count; l++)
+    for (unsigned int j = 0; j < 5; j++)
+      sha1_store_be32(digests + l * 20 + j * 4, state[j][l]);
+}
+
+[[gnu::target("sse2")]] void
+sha1_batch_sse2(const sha1_segments* messages, unsigned int count, uint64_t length, char* digests) {
+  sha1_batch_impl<sha1_v4, 4>(messages, count, length, digests);
+}
+
+[[gnu::target("avx2")]] void
+sha1_batch_avx2(const sha1_segments* messages, unsigned int count, uint64_t length, char* digests) {
+  sha1_batch_impl<sha1_v8, 8>(messages, count, length, digests);
+}
+
+[[gnu::target("avx512f")]] void
+sha1_batch_avx512(const sha1_segments* messages, unsigned int count, uint64_t length, char* digests) {
+  sha1_batch_impl<sha1_v16, 16>(messages, count, length, digests);
+}
+
+#endif // USE_SHA1_BATCH_X86
+
+uint64_t
+sha1_segments_length(const sha1_segments& segments) {
+  uint64_t length = 0;
+
+  for (const auto& segment : segments)
+    length += segment.second;
+
+  return length;
+}
+
+void
+sha1_single(const sha1_segments& segments, char* digest) {
+  Sha1 sha1;
+  sha1.init();
+
+  for (const auto& segment : segments)
+    sha1.update(segment.first, segment.second);
+
+  sha1.final_c(digest);
+}
+
+} // namespace
+
+unsigned int
+sha1_batch_lanes() {
+  static const unsigned int lanes = [] {
+#ifdef USE_SHA1_BATCH_X86
+      unsigned int eax, ebx, ecx, edx;
+
+      if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & bit_SHA))
+        return 1u;
+#endif
+      return sha1_batch_max_lanes();
+    }();
+
+  return lanes;
+}
+
+unsigned int
+sha1_batch_max_lanes() {
+#ifdef USE_SHA1_BATCH_X86
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx512f"))
+    return 16;
+
+  if (__builtin_cpu_supports("avx2"))
+    return 8;
+
+  return 4;
+#else
+  return 1;
+#endif
+}
+
+bool
+sha1_batch_is_supported(unsigned int lanes) {
+  switch (lanes) {
+  case 1:
+    return true;
+#ifdef USE_SHA1_BATCH_X86
+  case 4:
+  case 8:
+  case 16:
+    return lanes <= sha1_batch_max_lanes();
+#endif
+  default:
+    return false;
+  }
+}
+
+void
+sha1_batch(const sha1_segments* messages, unsigned int count, char* digests, unsigned int lanes) {
+  if (count == 0)
+    return;
+
+  if (!sha1_batch_is_supported(lanes))
+    throw internal_error("sha1_batch(...) unsupported lane count.");
+
+  uint64_t length = sha1_segments_length(messages[0]);
+
+  for (unsigned int i = 1; i < count; i++)
+    if (sha1_segments_length(messages[i]) != length)
+      throw internal_error("sha1_batch(...) messages are not of equal length.");
+
+  while (count != 0) {
+    unsigned int batch_count = std::min(count, lanes);
+
+    switch (lanes) {
+#ifdef USE_SHA1_BATCH_X86
+    case 4:  sha1_batch_sse2(messages, batch_count, length, digests); break;
+    case 8:  sha1_batch_avx2(messages, batch_count, length, digests); break;
+    case 16: sha1_batch_avx512(messages, batch_count, length, digests); break;
+#endif
+    case 1:
+      sha1_single(messages[0], digests);
+      break;
+    default:
+      throw internal_error("sha1_batch(...) unsupported lane count.");
+    }
+
+    messages += batch_count;
+    digests  += batch_count * 20;
+    count    -= batch_count;
+  }
+}
+
+} // namespace torrent
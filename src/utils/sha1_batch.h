@@ -0,0 +1,36 @@
+#ifndef LIBTORRENT_UTILS_SHA1_BATCH_H
+#define LIBTORRENT_UTILS_SHA1_BATCH_H
+
+#include <cinttypes>
+#include <utility>
+#include <vector>
+
+namespace torrent {
+
+// Hashes several independent messages of equal length in lockstep,
+// one message per SIMD lane. Messages are given as lists of
+// non-contiguous segments, e.g. the mapped parts of a chunk.
+//
+// The number of lanes is selected at runtime from the available CPU
+// features, and is 1 when batching would not be faster than the
+// single message Sha1 class. This is the case when the CPU has the SHA
+// extensions, which OpenSSL already uses.
+
+using sha1_segments = std::vector<std::pair<const char*, uint32_t>>;
+
+// Preferred number of lanes, and the widest supported by the CPU
+// regardless of preference.
+unsigned int sha1_batch_lanes();
+unsigned int sha1_batch_max_lanes();
+
+// True if 'lanes' is a batch width implemented and supported by the
+// CPU, i.e. 1 or a power of two from 4 up to the widest.
+bool         sha1_batch_is_supported(unsigned int lanes);
+
+// Computes 'count' digests of 20 bytes each into 'digests' using
+// 'lanes' wide batches. All messages must have the same total length.
+void         sha1_batch(const sha1_segments* messages, unsigned int count, char* digests, unsigned int lanes);
+
+} // namespace torrent
+
+#endif
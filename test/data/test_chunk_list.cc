@@ -137,4 +137,39 @@ test_chunk_list::test_blocking() {
   CLEANUP_CHUNK_LIST();
 }
 
+// Chunks being written back must not be handed out as writable.
+void
+test_chunk_list::test_writeback() {
+  SETUP_CHUNK_LIST();
+
+  torrent::ChunkHandle handle_0 = chunk_list->get(0, torrent::ChunkList::get_not_hashing | torrent::ChunkList::get_writable);
+  CPPUNIT_ASSERT(handle_0.is_valid());
+
+  chunk_list->release(&handle_0, torrent::ChunkList::release_default);
+
+  CPPUNIT_ASSERT(chunk_list->queue_size() == 1);
+
+  (*chunk_list)[0].set_writeback(true);
+
+  torrent::ChunkHandle handle_0_rw = chunk_list->get(0, torrent::ChunkList::get_not_hashing | torrent::ChunkList::get_writable | torrent::ChunkList::get_nonblock);
+
+  CPPUNIT_ASSERT(!handle_0_rw.is_valid());
+  CPPUNIT_ASSERT(handle_0_rw.error_number() == EAGAIN);
+  CPPUNIT_ASSERT((*chunk_list)[0].writable() == 1);
+
+  torrent::ChunkHandle handle_0_ro = chunk_list->get(0, torrent::ChunkList::get_not_hashing | torrent::ChunkList::get_nonblock);
+  CPPUNIT_ASSERT(handle_0_ro.is_valid());
+
+  chunk_list->release(&handle_0_ro, torrent::ChunkList::release_default);
+
+  (*chunk_list)[0].set_writeback(false);
+
+  handle_0_rw = chunk_list->get(0, torrent::ChunkList::get_not_hashing | torrent::ChunkList::get_writable | torrent::ChunkList::get_nonblock);
+  CPPUNIT_ASSERT(handle_0_rw.is_valid());
+
+  chunk_list->release(&handle_0_rw, torrent::ChunkList::release_default);
+
+  CLEANUP_CHUNK_LIST();
+}
+
 // TODO: Add tests for get_hashing, etc.
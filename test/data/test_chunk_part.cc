@@ -0,0 +1,67 @@
+#include "config.h"
+
+#include "test/data/test_chunk_part.h"
+
+#include <cstdlib>
+#include <vector>
+#include <unistd.h>
+
+#include "data/chunk.h"
+#include "data/socket_file.h"
+#include "test/helpers/test_file.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test_chunk_part);
+
+void
+test_chunk_part::test_read_chunk() {
+  std::vector<char> contents(10000);
+  torrent::SocketFile file(create_test_file(contents));
+
+  auto mc = file.read_chunk(100, 9000, torrent::MemoryChunk::prot_read);
+
+  CPPUNIT_ASSERT(mc.is_valid());
+  CPPUNIT_ASSERT(mc.size() == 9000);
+  CPPUNIT_ASSERT(mc.page_align() == 0);
+  CPPUNIT_ASSERT(std::equal(mc.begin(), mc.end(), contents.begin() + 100));
+
+  std::free(mc.ptr());
+
+  CPPUNIT_ASSERT(!file.read_chunk(9000, 1001, torrent::MemoryChunk::prot_read).is_valid());
+  CPPUNIT_ASSERT(!file.read_chunk(0, 0, torrent::MemoryChunk::prot_read).is_valid());
+
+  file.close();
+}
+
+void
+test_chunk_part::test_buffered_sync() {
+  std::vector<char> contents(10000);
+  torrent::SocketFile file(create_test_file(contents));
+
+  int prot = torrent::MemoryChunk::prot_read | torrent::MemoryChunk::prot_write;
+
+  torrent::Chunk chunk;
+  chunk.push_back(torrent::ChunkPart::MAPPED_BUFFER, file.read_chunk(100, 5000, prot));
+  chunk.back().set_file(nullptr, 100);
+  chunk.back().set_file_descriptor(::dup(file.fd()));
+
+  CPPUNIT_ASSERT(chunk.is_buffered());
+  CPPUNIT_ASSERT(chunk.is_writable());
+
+  std::vector<char> modified(200, 'x');
+  CPPUNIT_ASSERT(chunk.from_buffer(modified.data(), 1000, modified.size()));
+
+  // The file is only modified once synced.
+  std::vector<char> result(contents.size());
+  CPPUNIT_ASSERT(pread(file.fd(), result.data(), result.size(), 0) == static_cast<ssize_t>(result.size()));
+  CPPUNIT_ASSERT(result == contents);
+
+  CPPUNIT_ASSERT(chunk.sync(torrent::MemoryChunk::sync_sync));
+
+  std::copy(modified.begin(), modified.end(), contents.begin() + 1100);
+
+  CPPUNIT_ASSERT(pread(file.fd(), result.data(), result.size(), 0) == static_cast<ssize_t>(result.size()));
+  CPPUNIT_ASSERT(result == contents);
+
+  chunk.clear();
+  file.close();
+}
@@ -0,0 +1,14 @@
+#include "test/helpers/test_fixture.h"
+
+class test_chunk_part : public test_fixture {
+  CPPUNIT_TEST_SUITE(test_chunk_part);
+
+  CPPUNIT_TEST(test_read_chunk);
+  CPPUNIT_TEST(test_buffered_sync);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_read_chunk();
+  void test_buffered_sync();
+};
@@ -0,0 +1,74 @@
+#include "config.h"
+
+#include "test/data/test_chunk_writeback.h"
+
+#include <sys/mman.h>
+
+#include "data/chunk.h"
+#include "data/chunk_writeback.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test_chunk_writeback);
+
+using range_list = torrent::ChunkWriteback::range_list;
+
+void
+test_chunk_writeback::test_coalesce() {
+  auto file_a = reinterpret_cast<torrent::File*>(0x1000);
+  auto file_b = reinterpret_cast<torrent::File*>(0x2000);
+
+  range_list empty;
+  torrent::ChunkWriteback::coalesce(empty);
+  CPPUNIT_ASSERT(empty.empty());
+
+  range_list ranges = {
+    { file_b, 100, 50 },
+    { file_a, 200, 100 },
+    { file_a, 0, 100 },
+    { file_a, 100, 100 },
+    { file_b, 0, 50 },
+    { file_a, 250, 100 },
+    { file_a, 400, 10 },
+  };
+
+  torrent::ChunkWriteback::coalesce(ranges);
+
+  CPPUNIT_ASSERT(ranges.size() == 4);
+
+  CPPUNIT_ASSERT(ranges[0].file == file_a && ranges[0].offset == 0 && ranges[0].length == 350);
+  CPPUNIT_ASSERT(ranges[1].file == file_a && ranges[1].offset == 400 && ranges[1].length == 10);
+  CPPUNIT_ASSERT(ranges[2].file == file_b && ranges[2].offset == 0 && ranges[2].length == 50);
+  CPPUNIT_ASSERT(ranges[3].file == file_b && ranges[3].offset == 100 && ranges[3].length == 50);
+}
+
+void
+test_chunk_writeback::test_perform() {
+  char* memory = (char*)mmap(NULL, 4096, PROT_READ | PROT_WRITE, MAP_ANON | MAP_SHARED, -1, 0);
+  CPPUNIT_ASSERT(memory != MAP_FAILED);
+
+  torrent::Chunk chunk;
+  chunk.push_back(torrent::ChunkPart::MAPPED_MMAP, torrent::MemoryChunk(memory, memory, memory + 4096, torrent::MemoryChunk::prot_read | torrent::MemoryChunk::prot_write, 0));
+
+  torrent::ChunkWriteback writeback(0);
+
+  CPPUNIT_ASSERT(writeback.empty());
+
+  writeback.push_back(nullptr, &chunk, torrent::MemoryChunk::sync_sync, true);
+  writeback.push_back(nullptr, &chunk, torrent::MemoryChunk::sync_async, false);
+  writeback.prepare();
+
+  // Parts without a file have no ranges to start writeback on.
+  CPPUNIT_ASSERT(writeback.chunks().size() == 2);
+  CPPUNIT_ASSERT(writeback.ranges().empty());
+  CPPUNIT_ASSERT(!writeback.is_done());
+
+  writeback.perform();
+  writeback.set_done();
+  writeback.wait_done();
+
+  CPPUNIT_ASSERT(writeback.is_done());
+  CPPUNIT_ASSERT(writeback.failed() == 0);
+  CPPUNIT_ASSERT(writeback.chunks()[0].error == 0);
+  CPPUNIT_ASSERT(writeback.chunks()[1].error == 0);
+
+  chunk.clear();
+}
@@ -0,0 +1,14 @@
+#include "test/helpers/test_fixture.h"
+
+class test_chunk_writeback : public test_fixture {
+  CPPUNIT_TEST_SUITE(test_chunk_writeback);
+
+  CPPUNIT_TEST(test_coalesce);
+  CPPUNIT_TEST(test_perform);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_coalesce();
+  void test_perform();
+};
@@ -0,0 +1,128 @@
+#include "config.h"
+
+#include "test/data/test_hash_cache.h"
+
+#include <unistd.h>
+
+#include "data/hash_cache.h"
+#include "torrent/exceptions.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test_hash_cache);
+
+namespace {
+
+torrent::HashString
+make_info_hash(char c) {
+  torrent::HashString hash;
+  std::fill(hash.begin(), hash.end(), c);
+  return hash;
+}
+
+} // namespace
+
+void
+test_hash_cache::setUp() {
+  test_fixture::setUp();
+
+  char path[] = "/tmp/test_hash_cache.XXXXXX";
+  int fd = mkstemp(path);
+  CPPUNIT_ASSERT(fd != -1);
+  ::close(fd);
+
+  m_path = path;
+}
+
+void
+test_hash_cache::tearDown() {
+  ::unlink(m_path.c_str());
+
+  test_fixture::tearDown();
+}
+
+void
+test_hash_cache::test_basic() {
+  torrent::HashCache hash_cache;
+
+  CPPUNIT_ASSERT(!hash_cache.is_open());
+  CPPUNIT_ASSERT_THROW(hash_cache.open(m_path, 1000), torrent::internal_error);
+
+  hash_cache.open(m_path, 1024);
+
+  CPPUNIT_ASSERT(hash_cache.is_open());
+  CPPUNIT_ASSERT(hash_cache.path() == m_path);
+  CPPUNIT_ASSERT(hash_cache.capacity() == 1024);
+
+  auto info_hash = make_info_hash('a');
+
+  CPPUNIT_ASSERT(!hash_cache.contains(info_hash, 0, 1234));
+
+  hash_cache.insert(info_hash, 0, 1234);
+  hash_cache.insert(info_hash, 1, 0);
+
+  CPPUNIT_ASSERT(hash_cache.contains(info_hash, 0, 1234));
+  CPPUNIT_ASSERT(!hash_cache.contains(info_hash, 0, 4321));
+  CPPUNIT_ASSERT(!hash_cache.contains(info_hash, 0, 0));
+  CPPUNIT_ASSERT(!hash_cache.contains(info_hash, 1, 0));
+  CPPUNIT_ASSERT(!hash_cache.contains(make_info_hash('b'), 0, 1234));
+
+  hash_cache.insert(info_hash, 0, 4321);
+  CPPUNIT_ASSERT(hash_cache.contains(info_hash, 0, 4321));
+
+  hash_cache.erase(info_hash, 0);
+  CPPUNIT_ASSERT(!hash_cache.contains(info_hash, 0, 4321));
+
+  hash_cache.close();
+  CPPUNIT_ASSERT(!hash_cache.is_open());
+  CPPUNIT_ASSERT(!hash_cache.contains(info_hash, 0, 4321));
+}
+
+void
+test_hash_cache::test_persistent() {
+  auto info_hash = make_info_hash('a');
+
+  {
+    torrent::HashCache hash_cache;
+    hash_cache.open(m_path, 1024);
+
+    for (uint32_t i = 0; i < 100; i++)
+      hash_cache.insert(info_hash, i, i + 1);
+  }
+
+  {
+    torrent::HashCache hash_cache;
+    hash_cache.open(m_path, 1024);
+
+    for (uint32_t i = 0; i < 100; i++)
+      CPPUNIT_ASSERT(hash_cache.contains(info_hash, i, i + 1));
+  }
+
+  // A different capacity resets the file.
+  {
+    torrent::HashCache hash_cache;
+    hash_cache.open(m_path, 2048);
+
+    for (uint32_t i = 0; i < 100; i++)
+      CPPUNIT_ASSERT(!hash_cache.contains(info_hash, i, i + 1));
+  }
+}
+
+void
+test_hash_cache::test_eviction() {
+  torrent::HashCache hash_cache;
+  hash_cache.open(m_path, 16);
+
+  auto info_hash = make_info_hash('a');
+
+  for (uint32_t i = 0; i < 64; i++)
+    hash_cache.insert(info_hash, i, i + 1);
+
+  unsigned int found = 0;
+
+  for (uint32_t i = 0; i < 64; i++)
+    found += hash_cache.contains(info_hash, i, i + 1);
+
+  CPPUNIT_ASSERT(found > 0 && found <= 16);
+
+  // The most recent insert is always reachable.
+  CPPUNIT_ASSERT(hash_cache.contains(info_hash, 63, 64));
+}
@@ -0,0 +1,22 @@
+#include "test/helpers/test_fixture.h"
+
+class test_hash_cache : public test_fixture {
+  CPPUNIT_TEST_SUITE(test_hash_cache);
+
+  CPPUNIT_TEST(test_basic);
+  CPPUNIT_TEST(test_persistent);
+  CPPUNIT_TEST(test_eviction);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp() override;
+  void tearDown() override;
+
+  void test_basic();
+  void test_persistent();
+  void test_eviction();
+
+private:
+  std::string m_path;
+};
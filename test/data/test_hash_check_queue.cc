@@ -2,16 +2,25 @@
 
 #include "test_hash_check_queue.h"
 
+#include "helpers/test_file.h"
 #include "helpers/test_thread.h"
 #include "helpers/test_utils.h"
 
 #include <functional>
 #include <csignal>
+#include <cstdlib>
+#include <future>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 #include "data/chunk_handle.h"
 #include "data/chunk_manager.h"
 #include "data/thread_disk.h"
+#include "torrent/data/file.h"
+#include "utils/io_uring.h"
 #include "utils/sha1.h"
+#include "utils/sha1_batch.h"
 #include "torrent/exceptions.h"
 #include "torrent/system/callbacks.h"
 
@@ -191,3 +200,212 @@ test_hash_check_queue::test_thread_interrupt() {
 
   CLEANUP_CHUNK_LIST();
 }
+
+void
+test_hash_check_queue::test_worker_threads() {
+  SETUP_CHUNK_LIST();
+  torrent::HashCheckQueue hash_queue;
+
+  done_chunks_type done_chunks;
+  hash_queue.slot_chunk_done() = std::bind(&chunk_done, &done_chunks, std::placeholders::_1, std::placeholders::_2);
+
+  hash_queue.set_thread_count(4);
+  CPPUNIT_ASSERT(hash_queue.thread_count() == 4);
+
+  handle_list handles;
+
+  for (unsigned int i = 0; i < 20; i++) {
+    handles.push_back(chunk_list->get(i, torrent::ChunkList::get_not_hashing | torrent::ChunkList::get_blocking));
+
+    hash_queue.push_back(new torrent::HashChunk(handles.back()));
+  }
+
+  CPPUNIT_ASSERT(wait_for_true([&done_chunks] {
+    for (unsigned int i = 0; i < 20; i++) {
+      if (!verify_hash(&done_chunks, i, hash_for_index(i)))
+        return false;
+    }
+
+    return true;
+  }));
+
+  hash_queue.set_thread_count(0);
+  CPPUNIT_ASSERT(hash_queue.thread_count() == 0);
+  CPPUNIT_ASSERT(hash_queue.empty());
+
+  for (unsigned int i = 0; i < 20; i++)
+    chunk_list->release(&handles[i], torrent::ChunkList::release_default);
+
+  CLEANUP_CHUNK_LIST();
+}
+
+void
+test_hash_check_queue::test_batch() {
+  SETUP_CHUNK_LIST();
+  torrent::HashCheckQueue hash_queue;
+
+  done_chunks_type done_chunks;
+  hash_queue.slot_chunk_done() = std::bind(&chunk_done, &done_chunks, std::placeholders::_1, std::placeholders::_2);
+
+  // Only widths sha1_batch() implements are accepted, as it would
+  // otherwise throw on the disk thread.
+  for (unsigned int lanes : {0u, 2u, 3u, 5u, 6u, 7u, 12u, 32u})
+    CPPUNIT_ASSERT_THROW(hash_queue.set_batch_lanes(lanes), torrent::internal_error);
+
+  hash_queue.set_batch_lanes(torrent::sha1_batch_max_lanes());
+
+  handle_list handles;
+
+  for (unsigned int i = 0; i < 20; i++) {
+    handles.push_back(chunk_list->get(i, torrent::ChunkList::get_not_hashing | torrent::ChunkList::get_blocking));
+
+    hash_queue.push_back(new torrent::HashChunk(handles.back()));
+  }
+
+  torrent::disk_thread::callback([&hash_queue] { hash_queue.perform(); });
+
+  CPPUNIT_ASSERT(wait_for_true([&done_chunks] {
+    for (unsigned int i = 0; i < 20; i++) {
+      if (!verify_hash(&done_chunks, i, hash_for_index(i)))
+        return false;
+    }
+
+    return true;
+  }));
+
+  for (unsigned int i = 0; i < 20; i++)
+    chunk_list->release(&handles[i], torrent::ChunkList::release_default);
+
+  CLEANUP_CHUNK_LIST();
+}
+
+// The file backed part of the mapping is modified after the file is
+// written, so the hash only matches if the file itself was read. The
+// buffered part must be hashed from memory instead.
+void
+test_hash_check_queue::test_read_depth() {
+  if (!torrent::utils::IoUring::is_supported())
+    return;
+
+  std::vector<char> contents(3 * 4096);
+  int fd = create_test_file(contents);
+
+  auto file_memory = static_cast<char*>(mmap(NULL, contents.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0));
+  auto anon_memory = static_cast<char*>(mmap(NULL, 10, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, -1, 0));
+  CPPUNIT_ASSERT(file_memory != MAP_FAILED && anon_memory != MAP_FAILED);
+
+  std::memset(file_memory, 0, contents.size());
+  std::memset(anon_memory, 0x55, 10);
+
+  torrent::File file;
+  file.set_file_descriptor(fd);
+
+  auto chunk = new torrent::Chunk();
+  chunk->push_back(torrent::ChunkPart::MAPPED_MMAP, torrent::MemoryChunk(file_memory, file_memory + 100, file_memory + 9000, torrent::MemoryChunk::prot_read, 0));
+  chunk->push_back(torrent::ChunkPart::MAPPED_MMAP, torrent::MemoryChunk(anon_memory, anon_memory, anon_memory + 10, torrent::MemoryChunk::prot_read, 0));
+  chunk->front().set_file(&file, 100);
+
+  // Buffered parts may differ from the file until written back.
+  auto buffer_memory = static_cast<char*>(std::aligned_alloc(torrent::MemoryChunk::page_size(), torrent::MemoryChunk::page_size()));
+  std::memset(buffer_memory, 0x33, 100);
+
+  chunk->push_back(torrent::ChunkPart::MAPPED_BUFFER, torrent::MemoryChunk(buffer_memory, buffer_memory, buffer_memory + 100, torrent::MemoryChunk::prot_read, 0));
+  chunk->back().set_file(&file, 9000);
+
+  torrent::ChunkListNode node;
+  node.set_index(0);
+  node.set_chunk(chunk);
+
+  torrent::HashCheckQueue hash_queue;
+
+  done_chunks_type done_chunks;
+  hash_queue.slot_chunk_done() = std::bind(&chunk_done, &done_chunks, std::placeholders::_1, std::placeholders::_2);
+  hash_queue.set_read_depth(4);
+
+  auto hash_chunk = new torrent::HashChunk(torrent::ChunkHandle(&node, false, true));
+  hash_queue.push_back(hash_chunk);
+
+  CPPUNIT_ASSERT(hash_chunk->has_part_fds());
+  CPPUNIT_ASSERT(hash_chunk->part_fds()[0] != -1 && hash_chunk->part_fds()[1] == -1);
+  CPPUNIT_ASSERT(hash_chunk->part_fds()[2] == -1);
+
+  file.reset_file_descriptor();
+  ::close(fd);
+
+  torrent::disk_thread::callback([&hash_queue] { hash_queue.perform(); });
+
+  torrent::Sha1 sha1;
+  torrent::HashString expected;
+  sha1.init();
+  sha1.update(contents.data() + 100, 8900);
+  sha1.update(anon_memory, 10);
+  sha1.update(buffer_memory, 100);
+  sha1.final_c(expected.data());
+
+  CPPUNIT_ASSERT(wait_for_true([&done_chunks, &expected] { return verify_hash(&done_chunks, 0, expected); }));
+
+  delete hash_chunk;
+  delete chunk;
+}
+
+void
+test_hash_check_queue::test_priority() {
+  SETUP_CHUNK_LIST();
+  torrent::HashCheckQueue hash_queue;
+
+  std::vector<uint32_t> done_order;
+  std::mutex            done_lock;
+
+  hash_queue.slot_chunk_done() = [&](torrent::HashChunk* hash_chunk, const torrent::HashString&) {
+      auto guard = std::scoped_lock(done_lock);
+      done_order.push_back(hash_chunk->handle().index());
+    };
+
+  hash_queue.set_batch_lanes(1);
+
+  // Keep the disk thread busy until all chunks are queued.
+  std::promise<void> queued;
+  auto queued_future = queued.get_future().share();
+
+  torrent::disk_thread::callback([queued_future] { queued_future.wait(); });
+
+  int owner_a, owner_b;
+
+  struct { uint32_t index; torrent::HashChunk::priority_enum priority; const void* owner; } chunks[] = {
+    { 0, torrent::HashChunk::priority_recheck,  &owner_a },
+    { 1, torrent::HashChunk::priority_recheck,  &owner_a },
+    { 2, torrent::HashChunk::priority_recheck,  &owner_a },
+    { 3, torrent::HashChunk::priority_recheck,  &owner_b },
+    { 4, torrent::HashChunk::priority_recheck,  &owner_b },
+    { 5, torrent::HashChunk::priority_resume,   &owner_a },
+    { 6, torrent::HashChunk::priority_download, &owner_b },
+  };
+
+  handle_list handles;
+
+  for (auto& c : chunks) {
+    handles.push_back(chunk_list->get(c.index, torrent::ChunkList::get_not_hashing | torrent::ChunkList::get_blocking));
+
+    auto hash_chunk = new torrent::HashChunk(handles.back());
+    hash_chunk->set_priority(c.priority, c.owner);
+
+    hash_queue.push_back(hash_chunk);
+  }
+
+  CPPUNIT_ASSERT(hash_queue.size() == 7);
+
+  queued.set_value();
+
+  CPPUNIT_ASSERT(wait_for_true([&] {
+    auto guard = std::scoped_lock(done_lock);
+    return done_order.size() == 7;
+  }));
+
+  CPPUNIT_ASSERT(hash_queue.empty());
+  CPPUNIT_ASSERT((done_order == std::vector<uint32_t>{6, 5, 0, 3, 1, 4, 2}));
+
+  for (auto& handle : handles)
+    chunk_list->release(&handle, torrent::ChunkList::release_default);
+
+  CLEANUP_CHUNK_LIST();
+}
@@ -4,6 +4,7 @@
 #include <map>
 #include <vector>
 
+#include "data/hash_chunk.h"
 #include "data/hash_queue_node.h"
 #include "data/hash_check_queue.h"
 #include "helpers/test_main_thread.h"
@@ -17,6 +18,10 @@ class test_hash_check_queue : public TestFixtureWithMainAndDiskThread {
   CPPUNIT_TEST(test_erase);
 
   CPPUNIT_TEST(test_thread_interrupt);
+  CPPUNIT_TEST(test_worker_threads);
+  CPPUNIT_TEST(test_batch);
+  CPPUNIT_TEST(test_read_depth);
+  CPPUNIT_TEST(test_priority);
 
   CPPUNIT_TEST_SUITE_END();
 
@@ -26,6 +31,10 @@ public:
   void test_erase();
 
   void test_thread_interrupt();
+  void test_worker_threads();
+  void test_batch();
+  void test_read_depth();
+  void test_priority();
 };
 
 typedef std::map<int, torrent::HashString> done_chunks_type;
@@ -0,0 +1,115 @@
+#include "config.h"
+
+#include "test/data/test_hash_incremental.h"
+
+#include <sys/mman.h>
+
+#include "data/chunk.h"
+#include "data/hash_incremental.h"
+#include "torrent/hash_string.h"
+#include "utils/sha1.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test_hash_incremental);
+
+namespace {
+
+// Chunk of two parts with a boundary that doesn't align with blocks.
+std::unique_ptr<torrent::Chunk>
+create_chunk(uint32_t part1_size, uint32_t part2_size) {
+  auto chunk = std::make_unique<torrent::Chunk>();
+
+  for (auto size : { part1_size, part2_size }) {
+    char* memory = (char*)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, -1, 0);
+    CPPUNIT_ASSERT(memory != MAP_FAILED);
+
+    for (uint32_t i = 0; i < size; i++)
+      memory[i] = static_cast<char>(chunk->chunk_size() + i);
+
+    chunk->push_back(torrent::ChunkPart::MAPPED_MMAP, torrent::MemoryChunk(memory, memory, memory + size, torrent::MemoryChunk::prot_read, 0));
+  }
+
+  return chunk;
+}
+
+torrent::HashString
+full_hash(torrent::Chunk* chunk) {
+  torrent::Sha1       sha1;
+  torrent::HashString hash;
+
+  sha1.init();
+
+  for (auto& part : *chunk)
+    sha1.update(part.chunk().begin(), part.size());
+
+  sha1.final_c(hash.data());
+  return hash;
+}
+
+} // namespace
+
+void
+test_hash_incremental::test_in_order() {
+  auto chunk = create_chunk(40000, 25536);
+  torrent::HashIncremental hash_incremental;
+  torrent::HashString hash;
+
+  for (uint32_t length = 16384; length < chunk->chunk_size(); length += 16384) {
+    hash_incremental.update(0, chunk.get(), length);
+    CPPUNIT_ASSERT(hash_incremental.position(0) == length);
+  }
+
+  CPPUNIT_ASSERT(hash_incremental.finish(0, chunk.get(), hash.data()));
+  CPPUNIT_ASSERT(hash == full_hash(chunk.get()));
+  CPPUNIT_ASSERT(hash_incremental.empty());
+
+  chunk->clear();
+}
+
+void
+test_hash_incremental::test_out_of_order() {
+  auto chunk = create_chunk(20000, 45536);
+  torrent::HashIncremental hash_incremental;
+  torrent::HashString hash;
+
+  // Later blocks finishing first don't move the position, and the
+  // length only grows once the gap is filled.
+  hash_incremental.update(1, chunk.get(), 0);
+  CPPUNIT_ASSERT(hash_incremental.position(1) == 0);
+
+  hash_incremental.update(1, chunk.get(), 49152);
+  CPPUNIT_ASSERT(hash_incremental.position(1) == 49152);
+
+  hash_incremental.update(1, chunk.get(), 16384);
+  CPPUNIT_ASSERT(hash_incremental.position(1) == 49152);
+
+  CPPUNIT_ASSERT(hash_incremental.finish(1, chunk.get(), hash.data()));
+  CPPUNIT_ASSERT(hash == full_hash(chunk.get()));
+
+  chunk->clear();
+}
+
+void
+test_hash_incremental::test_fallback() {
+  auto chunk = create_chunk(torrent::HashIncremental::max_remaining, 16384);
+  torrent::HashIncremental hash_incremental;
+  torrent::HashString hash;
+
+  // No state, e.g. when incremental hashing started mid-chunk.
+  CPPUNIT_ASSERT(!hash_incremental.finish(2, chunk.get(), hash.data()));
+
+  hash_incremental.update(2, chunk.get(), 0);
+  CPPUNIT_ASSERT(hash_incremental.size() == 1);
+
+  CPPUNIT_ASSERT(!hash_incremental.finish(2, chunk.get(), hash.data()));
+  CPPUNIT_ASSERT(hash_incremental.empty());
+
+  hash_incremental.update(3, chunk.get(), 16384);
+  hash_incremental.erase(3);
+  CPPUNIT_ASSERT(hash_incremental.empty());
+
+  hash_incremental.update(4, chunk.get(), 16384);
+  CPPUNIT_ASSERT(hash_incremental.finish(4, chunk.get(), hash.data()));
+  CPPUNIT_ASSERT(hash == full_hash(chunk.get()));
+
+  chunk->clear();
+}
@@ -0,0 +1,16 @@
+#include "test/helpers/test_fixture.h"
+
+class test_hash_incremental : public test_fixture {
+  CPPUNIT_TEST_SUITE(test_hash_incremental);
+
+  CPPUNIT_TEST(test_in_order);
+  CPPUNIT_TEST(test_out_of_order);
+  CPPUNIT_TEST(test_fallback);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_in_order();
+  void test_out_of_order();
+  void test_fallback();
+};
@@ -139,6 +139,73 @@ test_hash_queue::test_erase_stress() {
   CLEANUP_CHUNK_LIST();
 }
 
-// Test erase of different id's.
+void
+test_hash_queue::test_erase_interleaved() {
+  SETUP_CHUNK_LIST();
+  SETUP_HASH_QUEUE();
+
+  // Only the addresses are used as ids.
+  auto id_0 = reinterpret_cast<torrent::HashQueueNode::id_type>(uintptr_t{0x10});
+  auto id_1 = reinterpret_cast<torrent::HashQueueNode::id_type>(uintptr_t{0x20});
+
+  for (unsigned int i = 0; i < 20; i++)
+    hash_queue->push_back(chunk_list->get(i, torrent::ChunkList::get_not_hashing | torrent::ChunkList::get_blocking),
+                          i % 2 == 0 ? id_0 : id_1,
+                          std::bind(&chunk_done, chunk_list, &done_chunks, std::placeholders::_1, std::placeholders::_2));
+
+  hash_queue->remove(id_0);
+  CPPUNIT_ASSERT(hash_queue->size() == 10);
+
+  // The remaining chunks must still find their own queue nodes.
+  for (unsigned int i = 1; i < 20; i += 2) {
+    CPPUNIT_ASSERT(wait_for_true(std::bind(&check_for_chunk_done, hash_queue.get(), &done_chunks, i)));
+    CPPUNIT_ASSERT(done_chunks[i] == hash_for_index(i));
+  }
+
+  for (unsigned int i = 0; i < 20; i += 2)
+    CPPUNIT_ASSERT(done_chunks.find(i) == done_chunks.end());
+
+  CPPUNIT_ASSERT(hash_queue->empty());
+  CPPUNIT_ASSERT(torrent::ThreadDisk::thread_disk()->hash_check_queue()->empty());
+  hash_queue.reset();
+
+  CLEANUP_CHUNK_LIST();
+}
 
 // Current code doesn't work well if we remove a hash...
+
+void
+test_hash_queue::test_hashed() {
+  SETUP_CHUNK_LIST();
+  SETUP_HASH_QUEUE();
+
+  // Hashed chunks are only passed to the owner from work(), and are
+  // removed like any other chunk.
+  for (unsigned int i = 0; i < 2; i++)
+    hash_queue->push_back_hashed(chunk_list->get(i, torrent::ChunkList::get_not_hashing | torrent::ChunkList::get_blocking),
+                                 NULL, std::bind(&chunk_done, chunk_list, &done_chunks, std::placeholders::_1, std::placeholders::_2),
+                                 hash_for_index(i));
+
+  CPPUNIT_ASSERT(hash_queue->size() == 2);
+  CPPUNIT_ASSERT(done_chunks.empty());
+
+  hash_queue->work();
+
+  CPPUNIT_ASSERT(hash_queue->empty());
+  CPPUNIT_ASSERT(done_chunks.size() == 2);
+  CPPUNIT_ASSERT(done_chunks[0] == hash_for_index(0));
+  CPPUNIT_ASSERT(done_chunks[1] == hash_for_index(1));
+
+  hash_queue->push_back_hashed(chunk_list->get(2, torrent::ChunkList::get_not_hashing | torrent::ChunkList::get_blocking),
+                               NULL, std::bind(&chunk_done, chunk_list, &done_chunks, std::placeholders::_1, std::placeholders::_2),
+                               hash_for_index(2));
+  hash_queue->remove(NULL);
+
+  CPPUNIT_ASSERT(hash_queue->empty());
+  CPPUNIT_ASSERT(done_chunks.find(2) == done_chunks.end());
+
+  CPPUNIT_ASSERT(torrent::ThreadDisk::thread_disk()->hash_check_queue()->empty());
+  hash_queue.reset();
+
+  CLEANUP_CHUNK_LIST();
+}
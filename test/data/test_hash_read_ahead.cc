@@ -0,0 +1,60 @@
+#include "config.h"
+
+#include "test/data/test_hash_read_ahead.h"
+
+#include "data/hash_read_ahead.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test_hash_read_ahead);
+
+using namespace std::chrono_literals;
+
+void
+test_hash_read_ahead::test_disabled() {
+  torrent::HashReadAhead read_ahead;
+
+  CPPUNIT_ASSERT(!read_ahead.is_enabled());
+  CPPUNIT_ASSERT(read_ahead.window_chunks() == 0);
+
+  read_ahead.reset(1 << 20, 0, 0us);
+  read_ahead.record_hashed(1 << 20, 2s);
+
+  CPPUNIT_ASSERT(!read_ahead.is_enabled());
+  CPPUNIT_ASSERT(read_ahead.window_bytes() == 0);
+  CPPUNIT_ASSERT(read_ahead.rate() == 0);
+}
+
+void
+test_hash_read_ahead::test_window() {
+  torrent::HashReadAhead read_ahead;
+
+  read_ahead.reset(1 << 20, 64 << 20, 0us);
+
+  CPPUNIT_ASSERT(read_ahead.is_enabled());
+  CPPUNIT_ASSERT(read_ahead.window_bytes() == (16 << 20));
+  CPPUNIT_ASSERT(read_ahead.window_chunks() == 16);
+
+  // No update until a full sample interval has passed.
+  read_ahead.record_hashed(100 << 20, 500ms);
+  CPPUNIT_ASSERT(read_ahead.window_bytes() == (16 << 20));
+
+  // 200 MiB/s averaged with the old window, capped at the maximum.
+  read_ahead.record_hashed(100 << 20, 1s);
+  CPPUNIT_ASSERT(read_ahead.rate() == (200 << 20));
+  CPPUNIT_ASSERT(read_ahead.window_bytes() == (64 << 20));
+
+  // A slow disk shrinks the window, but never below two chunks.
+  read_ahead.record_hashed(1 << 20, 11s);
+  CPPUNIT_ASSERT(read_ahead.rate() == (1 << 20) / 10);
+  CPPUNIT_ASSERT(read_ahead.window_bytes() < (64 << 20));
+
+  for (int i = 0; i < 16; i++)
+    read_ahead.record_hashed(0, 12s + i * 1s);
+
+  CPPUNIT_ASSERT(read_ahead.window_bytes() == (2 << 20));
+  CPPUNIT_ASSERT(read_ahead.window_chunks() == 2);
+
+  // Never larger than the maximum, even if smaller than two chunks.
+  read_ahead.reset(1 << 20, 1 << 20, 0us);
+  CPPUNIT_ASSERT(read_ahead.window_bytes() == (1 << 20));
+  CPPUNIT_ASSERT(read_ahead.window_chunks() == 1);
+}
@@ -0,0 +1,14 @@
+#include "test/helpers/test_fixture.h"
+
+class test_hash_read_ahead : public test_fixture {
+  CPPUNIT_TEST_SUITE(test_hash_read_ahead);
+
+  CPPUNIT_TEST(test_disabled);
+  CPPUNIT_TEST(test_window);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_disabled();
+  void test_window();
+};
@@ -0,0 +1,151 @@
+#include "config.h"
+
+#include "test/download/test_availability_index.h"
+
+#include "download/availability_index.h"
+#include "torrent/exceptions.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test_availability_index);
+
+using torrent::AvailabilityIndex;
+
+static auto accept_all = [](uint32_t) { return true; };
+
+void
+test_availability_index::test_basic() {
+  AvailabilityIndex index;
+
+  CPPUNIT_ASSERT(index.empty());
+
+  index.initialize(8);
+
+  CPPUNIT_ASSERT(index.size() == 8);
+  CPPUNIT_ASSERT(index.size_tracked() == 0);
+  CPPUNIT_ASSERT(index.availability(0) == 0);
+  CPPUNIT_ASSERT(!index.is_tracked(0));
+
+  CPPUNIT_ASSERT(index.increment(3) == 1);
+  CPPUNIT_ASSERT(index.increment(3) == 2);
+  CPPUNIT_ASSERT(index.decrement(3) == 1);
+  CPPUNIT_ASSERT(index.availability(3) == 1);
+
+  CPPUNIT_ASSERT_THROW(index.decrement(4), torrent::internal_error);
+  CPPUNIT_ASSERT_THROW(index.initialize(8), torrent::internal_error);
+
+  index.clear();
+
+  CPPUNIT_ASSERT(index.empty());
+  CPPUNIT_ASSERT(index.find_rarest(0, 0, accept_all) == AvailabilityIndex::invalid_index);
+}
+
+void
+test_availability_index::test_tracking() {
+  AvailabilityIndex index;
+  index.initialize(4);
+
+  index.increment(1);
+  index.insert(1);
+  index.insert(2);
+
+  CPPUNIT_ASSERT(index.size_tracked() == 2);
+  CPPUNIT_ASSERT(index.is_tracked(1));
+  CPPUNIT_ASSERT_THROW(index.insert(1), torrent::internal_error);
+
+  // Availability is kept for untracked chunks.
+  index.erase(1);
+  index.increment(1);
+
+  CPPUNIT_ASSERT(!index.is_tracked(1));
+  CPPUNIT_ASSERT(index.availability(1) == 2);
+  CPPUNIT_ASSERT_THROW(index.erase(1), torrent::internal_error);
+
+  index.insert(1);
+  index.erase(2);
+
+  CPPUNIT_ASSERT(index.size_tracked() == 1);
+  CPPUNIT_ASSERT(index.find_rarest(0, 0, accept_all) == 1);
+}
+
+void
+test_availability_index::test_find_rarest() {
+  AvailabilityIndex index;
+  index.initialize(6);
+
+  for (uint32_t i = 0; i < 6; i++) {
+    for (uint32_t j = 0; j < 6 - i; j++)
+      index.increment(i);
+
+    index.insert(i);
+  }
+
+  CPPUNIT_ASSERT(index.find_rarest(0, 0, accept_all) == 5);
+  CPPUNIT_ASSERT(index.find_rarest(0, 0, [](uint32_t i) { return i < 4; }) == 3);
+  CPPUNIT_ASSERT(index.find_rarest(0, 0, [](uint32_t i) { return i == 0; }) == 0);
+  CPPUNIT_ASSERT(index.find_rarest(0, 0, [](uint32_t) { return false; }) == AvailabilityIndex::invalid_index);
+
+  // Buckets below the minimum availability are skipped.
+  CPPUNIT_ASSERT(index.find_rarest(0, 2, accept_all) == 4);
+  CPPUNIT_ASSERT(index.find_rarest(0, 7, accept_all) == AvailabilityIndex::invalid_index);
+
+  // Moving chunks between buckets changes the order.
+  index.increment(5);
+  index.increment(5);
+  index.decrement(2);
+  index.decrement(2);
+  index.decrement(2);
+
+  CPPUNIT_ASSERT(index.availability(2) == 1);
+  CPPUNIT_ASSERT(index.find_rarest(0, 0, accept_all) == 2);
+  CPPUNIT_ASSERT(index.find_rarest(0, 0, [](uint32_t i) { return i != 2 && i != 4; }) == 3);
+
+  index.erase(4);
+  index.erase(2);
+
+  CPPUNIT_ASSERT(index.find_rarest(0, 0, accept_all) == 3);
+}
+
+void
+test_availability_index::test_find_rarest_seed() {
+  AvailabilityIndex index;
+  index.initialize(4);
+
+  for (uint32_t i = 0; i < 4; i++)
+    index.insert(i);
+
+  bool seen[4] = {};
+
+  for (uint32_t seed = 0; seed < 4; seed++)
+    seen[index.find_rarest(seed, 0, accept_all)] = true;
+
+  for (bool s : seen)
+    CPPUNIT_ASSERT(s);
+}
+
+void
+test_availability_index::test_find_rarest_budget() {
+  AvailabilityIndex index;
+  index.initialize(100);
+
+  for (uint32_t i = 0; i < 100; i++)
+    index.insert(i);
+
+  uint32_t calls  = 0;
+  uint32_t budget = 10;
+
+  // Gives up once the budget of rejected chunks is used.
+  CPPUNIT_ASSERT(index.find_rarest(0, 0, &budget, [&calls](uint32_t) { calls++; return false; }) == AvailabilityIndex::invalid_index);
+  CPPUNIT_ASSERT(budget == 0);
+  CPPUNIT_ASSERT(calls == 10);
+
+  // Accepted chunks do not use the budget.
+  budget = 10;
+
+  CPPUNIT_ASSERT(index.find_rarest(0, 0, &budget, [](uint32_t i) { return i == 5; }) == 5);
+  CPPUNIT_ASSERT(budget == 5);
+
+  // An exhausted search is told apart from there being no chunk.
+  budget = 1000;
+
+  CPPUNIT_ASSERT(index.find_rarest(0, 0, &budget, [](uint32_t) { return false; }) == AvailabilityIndex::invalid_index);
+  CPPUNIT_ASSERT(budget == 900);
+}
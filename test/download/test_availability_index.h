@@ -0,0 +1,20 @@
+#include "test/helpers/test_fixture.h"
+
+class test_availability_index : public test_fixture {
+  CPPUNIT_TEST_SUITE(test_availability_index);
+
+  CPPUNIT_TEST(test_basic);
+  CPPUNIT_TEST(test_tracking);
+  CPPUNIT_TEST(test_find_rarest);
+  CPPUNIT_TEST(test_find_rarest_seed);
+  CPPUNIT_TEST(test_find_rarest_budget);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_basic();
+  void test_tracking();
+  void test_find_rarest();
+  void test_find_rarest_seed();
+  void test_find_rarest_budget();
+};
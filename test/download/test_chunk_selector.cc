@@ -0,0 +1,238 @@
+#include "config.h"
+
+#include "test/download/test_chunk_selector.h"
+
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+#include "download/chunk_selector.h"
+#include "download/chunk_statistics.h"
+#include "protocol/peer_chunks.h"
+#include "torrent/data/download_data.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test_chunk_selector);
+
+namespace {
+
+constexpr uint32_t selector_chunks = 10;
+
+class test_download_data : public torrent::download_data {
+public:
+  using download_data::mutable_completed_bitfield;
+  using download_data::mutable_high_priority;
+  using download_data::mutable_normal_priority;
+};
+
+// A rarest-first selector over 'size' untouched chunks, all of normal
+// priority.
+class test_selector {
+public:
+  test_selector(uint32_t size = selector_chunks);
+  ~test_selector();
+
+  torrent::ChunkSelector* selector()              { return &m_selector; }
+  test_download_data*     data()                  { return &m_data; }
+
+  torrent::PeerChunks*    connect(std::initializer_list<uint32_t> chunks);
+  torrent::PeerChunks*    connect_seeder();
+  torrent::PeerChunks*    connect_bitfield(const torrent::Bitfield& bitfield);
+
+private:
+  uint32_t                  m_size;
+  test_download_data        m_data;
+  torrent::ChunkStatistics  m_statistics;
+  torrent::ChunkSelector    m_selector{&m_data};
+
+  std::vector<std::unique_ptr<torrent::PeerChunks>> m_peers;
+};
+
+test_selector::test_selector(uint32_t size) :
+  m_size(size) {
+
+  m_data.mutable_completed_bitfield()->set_size_bits(m_size);
+  m_data.mutable_completed_bitfield()->allocate();
+  m_data.mutable_completed_bitfield()->unset_all();
+  m_data.mutable_normal_priority()->insert(0, m_size);
+
+  m_statistics.set_availability_index(true);
+  m_statistics.initialize(m_size);
+
+  m_selector.initialize(&m_statistics);
+  m_selector.set_picker(torrent::PICKER_RAREST_FIRST);
+  m_selector.update_priorities();
+}
+
+test_selector::~test_selector() {
+  for (auto& pc : m_peers)
+    m_statistics.received_disconnect(pc.get());
+
+  m_selector.cleanup();
+  m_statistics.clear();
+}
+
+torrent::PeerChunks*
+test_selector::connect(std::initializer_list<uint32_t> chunks) {
+  auto pc = m_peers.emplace_back(std::make_unique<torrent::PeerChunks>()).get();
+
+  pc->bitfield()->set_size_bits(m_size);
+  pc->bitfield()->allocate();
+  pc->bitfield()->unset_all();
+
+  for (auto index : chunks)
+    pc->bitfield()->set(index);
+
+  m_statistics.received_connect(pc);
+  return pc;
+}
+
+torrent::PeerChunks*
+test_selector::connect_seeder() {
+  auto pc = m_peers.emplace_back(std::make_unique<torrent::PeerChunks>()).get();
+
+  pc->bitfield()->set_size_bits(m_size);
+  pc->bitfield()->allocate();
+  pc->bitfield()->set_all();
+
+  m_statistics.received_connect(pc);
+  return pc;
+}
+
+torrent::PeerChunks*
+test_selector::connect_bitfield(const torrent::Bitfield& bitfield) {
+  auto pc = m_peers.emplace_back(std::make_unique<torrent::PeerChunks>()).get();
+
+  pc->bitfield()->copy(bitfield);
+
+  m_statistics.received_connect(pc);
+  return pc;
+}
+
+} // namespace
+
+void
+test_chunk_selector::test_rarest_first() {
+  test_selector selector;
+
+  // Availability: 0-1 and 6-7 are at one, 2 and 5 at two, 3-4 at three.
+  auto pc_0 = selector.connect({0, 1, 2, 3, 4, 5});
+  auto pc_1 = selector.connect({2, 3, 4, 5, 6, 7});
+  auto pc_2 = selector.connect({3, 4});
+
+  for (int i = 0; i < 16; i++) {
+    auto index = selector.selector()->find(pc_0, false);
+    CPPUNIT_ASSERT(index == 0 || index == 1);
+
+    index = selector.selector()->find(pc_1, false);
+    CPPUNIT_ASSERT(index == 6 || index == 7);
+
+    index = selector.selector()->find(pc_2, false);
+    CPPUNIT_ASSERT(index == 3 || index == 4);
+  }
+
+  // Chunks in use are no longer picked.
+  selector.selector()->using_index(0);
+  selector.selector()->using_index(1);
+
+  for (int i = 0; i < 16; i++) {
+    auto index = selector.selector()->find(pc_0, false);
+    CPPUNIT_ASSERT(index == 2 || index == 5);
+  }
+
+  selector.selector()->not_using_index(1);
+
+  CPPUNIT_ASSERT(selector.selector()->find(pc_0, false) == 1);
+}
+
+void
+test_chunk_selector::test_rarest_first_priority() {
+  test_selector selector;
+
+  auto pc_0 = selector.connect({0, 1, 2, 3, 4, 5});
+  auto pc_1 = selector.connect({2, 3, 4, 5});
+  selector.connect({4});
+
+  // High priority chunks are picked first, even when less rare.
+  selector.data()->mutable_high_priority()->insert(4, 6);
+
+  for (int i = 0; i < 16; i++) {
+    CPPUNIT_ASSERT(selector.selector()->find(pc_0, false) == 5);
+    CPPUNIT_ASSERT(selector.selector()->find(pc_1, false) == 5);
+  }
+
+  // Only high priority chunks are left to pick.
+  selector.data()->mutable_normal_priority()->clear();
+  selector.selector()->using_index(5);
+
+  CPPUNIT_ASSERT(selector.selector()->find(pc_0, false) == 4);
+
+  selector.data()->mutable_high_priority()->clear();
+
+  CPPUNIT_ASSERT(selector.selector()->find(pc_0, false) == torrent::ChunkSelector::invalid_chunk);
+}
+
+// Seeders are not counted in the availability index, so chunks no
+// other peer has are only picked from them.
+void
+test_chunk_selector::test_rarest_first_seeder() {
+  test_selector selector;
+
+  auto pc_0   = selector.connect({0, 1, 2, 3, 4, 5, 6, 7});
+  auto seeder = selector.connect_seeder();
+
+  for (int i = 0; i < 16; i++) {
+    auto index = selector.selector()->find(seeder, false);
+    CPPUNIT_ASSERT(index == 8 || index == 9);
+
+    CPPUNIT_ASSERT(selector.selector()->find(pc_0, false) < 8);
+  }
+
+  selector.selector()->using_index(8);
+  selector.selector()->using_index(9);
+
+  CPPUNIT_ASSERT(selector.selector()->find(seeder, false) < 8);
+}
+
+// A peer with only a few chunks of a large torrent, where nearly all
+// tracked chunks in the rarest buckets are ones it lacks.
+void
+test_chunk_selector::test_rarest_first_sparse() {
+  constexpr uint32_t size = 100000;
+
+  test_selector selector(size);
+
+  // Availability: 99990 and all the dense peer has at one, 10 and 50000
+  // at two, 70000 at three.
+  torrent::Bitfield dense;
+  dense.set_size_bits(size);
+  dense.allocate();
+  dense.set_all();
+  dense.unset(10);
+  dense.unset(50000);
+  dense.unset(99990);
+
+  selector.connect_bitfield(dense);
+
+  auto pc_0 = selector.connect({10, 50000, 99990});
+  auto pc_1 = selector.connect({50000, 70000});
+  selector.connect({10, 70000});
+
+  for (int i = 0; i < 16; i++) {
+    CPPUNIT_ASSERT(selector.selector()->find(pc_0, false) == 99990);
+    CPPUNIT_ASSERT(selector.selector()->find(pc_1, false) == 50000);
+  }
+
+  // High priority chunks are still preferred after falling back.
+  selector.data()->mutable_high_priority()->insert(10, 11);
+
+  CPPUNIT_ASSERT(selector.selector()->find(pc_0, false) == 10);
+  CPPUNIT_ASSERT(selector.selector()->find(pc_1, false) == 50000);
+
+  selector.selector()->using_index(50000);
+
+  CPPUNIT_ASSERT(selector.selector()->find(pc_1, false) == 70000);
+
+  selector.selector()->using_index(70000);
+
+  CPPUNIT_ASSERT(selector.selector()->find(pc_1, false) == torrent::ChunkSelector::invalid_chunk);
+}
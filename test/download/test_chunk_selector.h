@@ -0,0 +1,18 @@
+#include "test/helpers/test_fixture.h"
+
+class test_chunk_selector : public test_fixture {
+  CPPUNIT_TEST_SUITE(test_chunk_selector);
+
+  CPPUNIT_TEST(test_rarest_first);
+  CPPUNIT_TEST(test_rarest_first_priority);
+  CPPUNIT_TEST(test_rarest_first_seeder);
+  CPPUNIT_TEST(test_rarest_first_sparse);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_rarest_first();
+  void test_rarest_first_priority();
+  void test_rarest_first_seeder();
+  void test_rarest_first_sparse();
+};
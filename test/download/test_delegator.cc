@@ -0,0 +1,376 @@
+#include "config.h"
+
+#include "test/download/test_delegator.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "download/delegator.h"
+#include "protocol/peer_chunks.h"
+#include "protocol/request_list.h"
+#include "test/helpers/network.h"
+#include "torrent/data/block.h"
+#include "torrent/data/block_list.h"
+#include "torrent/peer/peer_info.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test_delegator);
+
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr uint32_t swarm_chunk_size = 1 << 16;
+constexpr uint32_t swarm_pipe_size  = 4;
+constexpr auto     swarm_step       = 100ms;
+
+struct swarm_peer {
+  std::unique_ptr<torrent::PeerInfo>    peer_info;
+  std::unique_ptr<torrent::PeerChunks>  peer_chunks;
+  std::unique_ptr<torrent::RequestList> request_list;
+
+  uint64_t rate{0};
+  uint64_t credit{0};
+  unsigned int deadline_chunks{0};
+  uint64_t     endgame_duplicates{0};
+};
+
+// Seeders downloading whole blocks at fixed rates, with the chunk
+// selection of ChunkSelector reduced to ascending index order.
+class test_swarm {
+public:
+  test_swarm(TestMainThread* main_thread, uint32_t chunks, const std::vector<uint64_t>& rates);
+  ~test_swarm();
+
+  torrent::Delegator* delegator()                       { return &m_delegator; }
+  swarm_peer*         peer(size_t i)                    { return &m_peers[i]; }
+
+  void                set_deadline(uint32_t index, std::chrono::microseconds t) { m_deadlines[index] = t; }
+
+  bool                is_completed(uint32_t index) const  { return m_completed[index] != std::chrono::microseconds{}; }
+  std::chrono::microseconds completed(uint32_t index) const { return m_completed[index]; }
+  bool                is_transfering(uint32_t index)      { return m_delegator.transfer_list()->find(index) != m_delegator.transfer_list()->end(); }
+  bool                is_all_completed() const;
+
+  // The most requests for a single block seen outstanding at once.
+  unsigned int        max_block_requests() const          { return m_max_block_requests; }
+
+  std::chrono::microseconds now() const                 { return m_now; }
+
+  void                step();
+  void                run_until(std::chrono::microseconds t);
+
+private:
+  uint32_t            find_chunk(torrent::PeerChunks* pc);
+  uint32_t            find_deadline_chunk(torrent::PeerChunks* pc);
+  uint64_t            average_rate();
+  void                chunk_completed(uint32_t index);
+  void                update_max_block_requests();
+
+  TestMainThread*     m_main_thread;
+  std::chrono::microseconds m_now{1s};
+
+  torrent::Delegator  m_delegator;
+  std::vector<swarm_peer> m_peers;
+
+  std::vector<bool>   m_untouched;
+  std::vector<std::chrono::microseconds> m_completed;
+  std::map<uint32_t, std::chrono::microseconds> m_deadlines;
+
+  unsigned int        m_max_block_requests{0};
+};
+
+test_swarm::test_swarm(TestMainThread* main_thread, uint32_t chunks, const std::vector<uint64_t>& rates) :
+    m_main_thread(main_thread),
+    m_untouched(chunks, true),
+    m_completed(chunks) {
+
+  m_main_thread->test_set_cached_time(m_now);
+
+  m_delegator.slot_chunk_find()          = [this](auto pc, auto) { return find_chunk(pc); };
+  m_delegator.slot_chunk_size()          = [](auto) { return swarm_chunk_size; };
+  m_delegator.slot_deadline_find_chunk() = [this](auto pc) { return find_deadline_chunk(pc); };
+  m_delegator.slot_chunk_deadline()      = [this](auto i) { return m_deadlines.count(i) != 0 ? m_deadlines[i] : 0us; };
+  m_delegator.slot_fast_peer_rate()      = [this] { return average_rate(); };
+
+  m_delegator.transfer_list()->slot_canceled()  = [this](auto i) { m_untouched[i] = true; };
+  m_delegator.transfer_list()->slot_queued()    = [this](auto i) { m_untouched[i] = false; };
+  m_delegator.transfer_list()->slot_completed() = [this](auto i) { chunk_completed(i); };
+  m_delegator.transfer_list()->slot_corrupt()   = [](auto) {};
+
+  m_peers.resize(rates.size());
+
+  for (size_t i = 0; i < rates.size(); i++) {
+    auto& peer = m_peers[i];
+
+    peer.rate = rates[i];
+    peer.peer_info = std::make_unique<torrent::PeerInfo>(wrap_ai_get_first_sa(("10.0.0." + std::to_string(i + 1)).c_str(), "6881").get());
+    peer.peer_chunks = std::make_unique<torrent::PeerChunks>();
+    peer.peer_chunks->set_peer_info(peer.peer_info.get());
+    peer.peer_chunks->bitfield()->set_size_bits(chunks);
+    peer.peer_chunks->bitfield()->allocate();
+    peer.peer_chunks->bitfield()->set_all();
+
+    peer.request_list = std::make_unique<torrent::RequestList>();
+    peer.request_list->set_delegator(&m_delegator);
+    peer.request_list->set_peer_chunks(peer.peer_chunks.get());
+  }
+}
+
+test_swarm::~test_swarm() {
+  for (auto& peer : m_peers)
+    peer.request_list->clear();
+
+  m_delegator.transfer_list()->clear();
+  m_peers.clear();
+}
+
+void
+test_swarm::step() {
+  m_now += swarm_step;
+  m_main_thread->test_set_cached_time(m_now);
+  m_main_thread->test_process_events_without_cached_time();
+
+  for (auto& peer : m_peers) {
+    auto request_list = peer.request_list.get();
+
+    peer.credit += peer.rate * std::chrono::duration_cast<std::chrono::microseconds>(swarm_step).count() / 1000000;
+
+    while (true) {
+      if (request_list->queued_size() < swarm_pipe_size) {
+        auto duplicates = m_delegator.endgame_duplicates();
+
+        for (auto piece : request_list->delegate(swarm_pipe_size - request_list->queued_size()))
+          peer.deadline_chunks += m_deadlines.count(piece->index()) != 0;
+
+        peer.endgame_duplicates += m_delegator.endgame_duplicates() - duplicates;
+        update_max_block_requests();
+      }
+
+      if (request_list->queued_empty())
+        break;
+
+      auto piece = request_list->next_queued_piece();
+
+      if (piece.length() > peer.credit)
+        break;
+
+      peer.credit -= piece.length();
+      peer.peer_chunks->download_throttle()->rate()->insert(piece.length());
+
+      if (request_list->downloading(piece)) {
+        request_list->transfer()->adjust_position(piece.length());
+        request_list->finished();
+      } else {
+        request_list->skipped();
+      }
+    }
+  }
+}
+
+void
+test_swarm::run_until(std::chrono::microseconds t) {
+  while (m_now < t)
+    step();
+}
+
+bool
+test_swarm::is_all_completed() const {
+  return std::none_of(m_completed.begin(), m_completed.end(), [](auto t) { return t == std::chrono::microseconds{}; });
+}
+
+void
+test_swarm::update_max_block_requests() {
+  for (auto block_list : *m_delegator.transfer_list())
+    for (auto& block : *block_list)
+      m_max_block_requests = std::max<unsigned int>(m_max_block_requests, block.size_not_stalled());
+}
+
+uint32_t
+test_swarm::find_chunk(torrent::PeerChunks* pc) {
+  for (uint32_t i = 0; i < m_untouched.size(); i++) {
+    if (!m_untouched[i] || !pc->bitfield()->get(i))
+      continue;
+
+    if (m_delegator.is_deadline_mode() && m_deadlines.count(i) != 0)
+      continue;
+
+    return i;
+  }
+
+  return ~uint32_t{0};
+}
+
+uint32_t
+test_swarm::find_deadline_chunk(torrent::PeerChunks* pc) {
+  uint32_t result = ~uint32_t{0};
+
+  for (auto& [index, deadline] : m_deadlines) {
+    if (!m_untouched[index] || !pc->bitfield()->get(index))
+      continue;
+
+    if (result == ~uint32_t{0} || deadline < m_deadlines[result])
+      result = index;
+  }
+
+  return result;
+}
+
+uint64_t
+test_swarm::average_rate() {
+  uint64_t total = 0;
+  uint64_t count = 0;
+
+  for (auto& peer : m_peers) {
+    auto rate = peer.peer_chunks->download_throttle()->rate()->rate();
+
+    total += rate;
+    count += rate != 0;
+  }
+
+  return count != 0 ? total / count : 0;
+}
+
+void
+test_swarm::chunk_completed(uint32_t index) {
+  m_completed[index] = m_now;
+  m_deadlines.erase(index);
+
+  m_delegator.transfer_list()->erase(m_delegator.transfer_list()->find(index));
+}
+
+// Rates in bytes per second of one fast, one medium and two slow
+// peers.
+const std::vector<uint64_t> swarm_rates = { 512 << 10, 256 << 10, 32 << 10, 32 << 10 };
+
+} // namespace
+
+void
+test_delegator::test_deadline_order() {
+  // The deadline chunks are at the end of the download order, so
+  // without deadline mode they are requested last.
+  auto run = [this](bool deadline_mode) {
+      test_swarm swarm(m_main_thread.get(), 64, swarm_rates);
+      swarm.delegator()->set_deadline_mode(deadline_mode);
+
+      swarm.run_until(3s);
+
+      for (uint32_t i = 0; i < 8; i++)
+        swarm.set_deadline(56 + i, swarm.now() + 1s + i * 500ms);
+
+      auto deadlines_start = swarm.now();
+
+      swarm.run_until(20s);
+
+      unsigned int missed = 0;
+
+      for (uint32_t i = 0; i < 8; i++)
+        missed += !swarm.is_completed(56 + i) || swarm.completed(56 + i) > deadlines_start + 1s + i * 500ms;
+
+      return missed;
+    };
+
+  CPPUNIT_ASSERT(run(true) == 0);
+  CPPUNIT_ASSERT(run(false) != 0);
+}
+
+void
+test_delegator::test_deadline_fast_peers() {
+  test_swarm swarm(m_main_thread.get(), 64, swarm_rates);
+  swarm.delegator()->set_deadline_mode(true);
+
+  // Let the peer rates settle before adding deadlines.
+  swarm.run_until(5s);
+
+  auto deadlines_start = swarm.now();
+
+  for (uint32_t i = 0; i < 8; i++)
+    swarm.set_deadline(40 + i, deadlines_start + 2s + i * 500ms);
+
+  swarm.run_until(15s);
+
+  for (uint32_t i = 0; i < 8; i++)
+    CPPUNIT_ASSERT(swarm.is_completed(40 + i) && swarm.completed(40 + i) <= deadlines_start + 2s + i * 500ms);
+
+  CPPUNIT_ASSERT(swarm.peer(0)->deadline_chunks != 0);
+  CPPUNIT_ASSERT(swarm.peer(2)->deadline_chunks == 0);
+  CPPUNIT_ASSERT(swarm.peer(3)->deadline_chunks == 0);
+}
+
+void
+test_delegator::test_deadline_duplicates() {
+  test_swarm swarm(m_main_thread.get(), 64, swarm_rates);
+  swarm.delegator()->set_deadline_mode(true);
+
+  swarm.run_until(5s);
+
+  // Find a chunk a slow peer is working on, and give it a deadline
+  // the slow peer alone can't meet.
+  uint32_t index = ~uint32_t{0};
+
+  for (uint32_t i = 0; i < 64 && index == ~uint32_t{0}; i++)
+    if (swarm.is_transfering(i) && swarm.peer(2)->request_list->queued_size() != 0 &&
+        swarm.peer(2)->request_list->next_queued_piece().index() == i)
+      index = i;
+
+  CPPUNIT_ASSERT(index != ~uint32_t{0});
+
+  auto deadline = swarm.now() + 1500ms;
+  swarm.set_deadline(index, deadline);
+
+  swarm.run_until(deadline);
+
+  CPPUNIT_ASSERT(swarm.is_completed(index));
+  CPPUNIT_ASSERT(swarm.delegator()->deadline_duplicates() != 0);
+}
+
+void
+test_delegator::test_endgame_tail() {
+  // The slow peer ends up with the last chunks, which without
+  // end-game the fast peer can only wait for.
+  auto run = [this](bool aggressive) {
+      test_swarm swarm(m_main_thread.get(), 16, { 512 << 10, 32 << 10 });
+      swarm.delegator()->set_aggressive(aggressive);
+
+      while (!swarm.is_all_completed() && swarm.now() < 60s)
+        swarm.step();
+
+      return swarm.now();
+    };
+
+  auto endgame_time = run(true);
+  auto normal_time  = run(false);
+
+  CPPUNIT_ASSERT(endgame_time < 60s);
+  CPPUNIT_ASSERT(endgame_time + 1s < normal_time);
+}
+
+void
+test_delegator::test_endgame_duplicate_limit() {
+  test_swarm swarm(m_main_thread.get(), 4, std::vector<uint64_t>(12, 64 << 10));
+  swarm.delegator()->set_aggressive(true);
+
+  swarm.run_until(10s);
+
+  CPPUNIT_ASSERT(swarm.is_all_completed());
+  CPPUNIT_ASSERT(swarm.delegator()->endgame_duplicates() != 0);
+  CPPUNIT_ASSERT(swarm.max_block_requests() == 1 + torrent::Delegator::endgame_max_duplicates);
+}
+
+void
+test_delegator::test_endgame_fast_peers() {
+  test_swarm swarm(m_main_thread.get(), 64, swarm_rates);
+
+  swarm.run_until(3s);
+  swarm.delegator()->set_aggressive(true);
+
+  while (!swarm.is_all_completed() && swarm.now() < 60s)
+    swarm.step();
+
+  CPPUNIT_ASSERT(swarm.is_all_completed());
+  CPPUNIT_ASSERT(swarm.peer(0)->endgame_duplicates != 0);
+  CPPUNIT_ASSERT(swarm.peer(2)->endgame_duplicates == 0);
+  CPPUNIT_ASSERT(swarm.peer(3)->endgame_duplicates == 0);
+}
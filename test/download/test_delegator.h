@@ -0,0 +1,22 @@
+#include "test/helpers/test_main_thread.h"
+
+class test_delegator : public TestFixtureWithMainThread {
+  CPPUNIT_TEST_SUITE(test_delegator);
+
+  CPPUNIT_TEST(test_deadline_order);
+  CPPUNIT_TEST(test_deadline_fast_peers);
+  CPPUNIT_TEST(test_deadline_duplicates);
+  CPPUNIT_TEST(test_endgame_tail);
+  CPPUNIT_TEST(test_endgame_duplicate_limit);
+  CPPUNIT_TEST(test_endgame_fast_peers);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_deadline_order();
+  void test_deadline_fast_peers();
+  void test_deadline_duplicates();
+  void test_endgame_tail();
+  void test_endgame_duplicate_limit();
+  void test_endgame_fast_peers();
+};
@@ -0,0 +1,31 @@
+#ifndef LIBTORRENT_TEST_FILE_H
+#define LIBTORRENT_TEST_FILE_H
+
+#include <cstdlib>
+#include <vector>
+#include <unistd.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+inline void
+fill_test_contents(std::vector<char>& contents) {
+  for (size_t i = 0; i < contents.size(); i++)
+    contents[i] = static_cast<char>(i * 7);
+}
+
+// Fills 'contents' and writes it to an unlinked temporary file, the
+// descriptor of which is returned.
+inline int
+create_test_file(std::vector<char>& contents) {
+  char path[] = "/tmp/libtorrent_test_file.XXXXXX";
+  int fd = mkstemp(path);
+  CPPUNIT_ASSERT(fd != -1);
+  unlink(path);
+
+  fill_test_contents(contents);
+
+  CPPUNIT_ASSERT(pwrite(fd, contents.data(), contents.size(), 0) == static_cast<ssize_t>(contents.size()));
+
+  return fd;
+}
+
+#endif // LIBTORRENT_TEST_FILE_H
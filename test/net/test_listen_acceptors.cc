@@ -0,0 +1,169 @@
+#include "config.h"
+
+#include "test/net/test_listen_acceptors.h"
+
+#include <chrono>
+#include <thread>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "net/listen_acceptors.h"
+#include "torrent/net/fd.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test_listen_acceptors);
+
+namespace {
+
+int
+open_reuse_port_listen(uint16_t* port) {
+  int fd = torrent::fd_open(torrent::fd_flag_stream | torrent::fd_flag_nonblock | torrent::fd_flag_v4only | torrent::fd_flag_reuse_port);
+  CPPUNIT_ASSERT(fd != -1);
+
+  sockaddr_in sa{};
+  sa.sin_family      = AF_INET;
+  sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  sa.sin_port        = *port;
+
+  CPPUNIT_ASSERT(::bind(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0);
+  CPPUNIT_ASSERT(::listen(fd, 64) == 0);
+
+  socklen_t length = sizeof(sa);
+  CPPUNIT_ASSERT(::getsockname(fd, reinterpret_cast<sockaddr*>(&sa), &length) == 0);
+
+  *port = sa.sin_port;
+  return fd;
+}
+
+bool
+bind_loopback(int fd, uint16_t port) {
+  sockaddr_in sa{};
+  sa.sin_family      = AF_INET;
+  sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  sa.sin_port        = port;
+
+  return ::bind(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0;
+}
+
+int
+connect_client(uint16_t port) {
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  CPPUNIT_ASSERT(fd != -1);
+
+  sockaddr_in sa{};
+  sa.sin_family      = AF_INET;
+  sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  sa.sin_port        = port;
+
+  CPPUNIT_ASSERT(::connect(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0);
+  return fd;
+}
+
+} // namespace
+
+void
+test_listen_acceptors::test_accept() {
+  uint16_t port = 0;
+  int listen_fds[2];
+
+  listen_fds[0] = open_reuse_port_listen(&port);
+  listen_fds[1] = open_reuse_port_listen(&port);
+
+  std::vector<int> accepted;
+
+  {
+    torrent::ListenAcceptors acceptors({listen_fds[0], listen_fds[1]}, 4, [&](int fd, const sockaddr* sa) {
+        CPPUNIT_ASSERT(sa->sa_family == AF_INET);
+        accepted.push_back(fd);
+      });
+
+    CPPUNIT_ASSERT(acceptors.size() == 2);
+
+    std::vector<int> clients;
+
+    for (int i = 0; i < 16; i++)
+      clients.push_back(connect_client(port));
+
+    auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+    while (accepted.size() < clients.size() && std::chrono::steady_clock::now() < timeout) {
+      m_main_thread->test_process_events_without_cached_time();
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    CPPUNIT_ASSERT(accepted.size() == clients.size());
+
+    for (int fd : clients)
+      ::close(fd);
+  }
+
+  for (int fd : accepted)
+    ::close(fd);
+
+  ::close(listen_fds[0]);
+  ::close(listen_fds[1]);
+}
+
+void
+test_listen_acceptors::test_close_pending() {
+  uint16_t port = 0;
+  int listen_fd = open_reuse_port_listen(&port);
+  int accepted_count = 0;
+
+  int client_fd;
+
+  {
+    torrent::ListenAcceptors acceptors({listen_fd}, 16, [&](int fd, const sockaddr*) {
+        accepted_count++;
+        ::close(fd);
+      });
+
+    client_fd = connect_client(port);
+
+    // Wait for the accepted connection to be queued without processing
+    // the main thread callbacks, the destructor must close it.
+    auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+    while (!m_main_thread->test_has_callbacks() && std::chrono::steady_clock::now() < timeout)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    CPPUNIT_ASSERT(m_main_thread->test_has_callbacks());
+  }
+
+  m_main_thread->test_process_events_without_cached_time();
+  CPPUNIT_ASSERT(accepted_count == 0);
+
+  // The peer sees the connection closed.
+  char buffer;
+  CPPUNIT_ASSERT(::read(client_fd, &buffer, 1) == 0);
+
+  ::close(client_fd);
+  ::close(listen_fd);
+}
+
+// Listen binds the probing socket without SO_REUSEPORT and only enables
+// it before listening, verify the kernel behaves as that relies on.
+void
+test_listen_acceptors::test_exclusive_port() {
+  uint16_t port = 0;
+  int foreign_fd = open_reuse_port_listen(&port);
+
+  int probe_fd = torrent::fd_open(torrent::fd_flag_stream | torrent::fd_flag_nonblock | torrent::fd_flag_v4only | torrent::fd_flag_reuse_address);
+  CPPUNIT_ASSERT(probe_fd != -1);
+  CPPUNIT_ASSERT(!bind_loopback(probe_fd, port));
+
+  ::close(foreign_fd);
+
+  CPPUNIT_ASSERT(bind_loopback(probe_fd, port));
+  CPPUNIT_ASSERT(torrent::fd_set_reuse_port(probe_fd, true));
+  CPPUNIT_ASSERT(::listen(probe_fd, 64) == 0);
+
+  int reuse_fd = open_reuse_port_listen(&port);
+
+  int client_fd = connect_client(port);
+
+  ::close(client_fd);
+  ::close(reuse_fd);
+  ::close(probe_fd);
+}
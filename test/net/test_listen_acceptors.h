@@ -0,0 +1,21 @@
+#ifndef LIBTORRENT_TEST_NET_TEST_LISTEN_ACCEPTORS_H
+#define LIBTORRENT_TEST_NET_TEST_LISTEN_ACCEPTORS_H
+
+#include "test/helpers/test_main_thread.h"
+
+class test_listen_acceptors : public TestFixtureWithMainThread {
+  CPPUNIT_TEST_SUITE(test_listen_acceptors);
+
+  CPPUNIT_TEST(test_accept);
+  CPPUNIT_TEST(test_close_pending);
+  CPPUNIT_TEST(test_exclusive_port);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_accept();
+  void test_close_pending();
+  void test_exclusive_port();
+};
+
+#endif
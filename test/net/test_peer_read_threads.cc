@@ -0,0 +1,238 @@
+#include "config.h"
+
+#include "test/net/test_peer_read_threads.h"
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "net/peer_read_threads.h"
+#include "torrent/net/fd.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test_peer_read_threads);
+
+namespace {
+
+struct socket_pair {
+  socket_pair() {
+    torrent::fd_open_socket_pair(local, remote);
+
+    CPPUNIT_ASSERT(torrent::fd_set_nonblock(local));
+    CPPUNIT_ASSERT(torrent::fd_set_nonblock(remote));
+  }
+
+  ~socket_pair() {
+    if (local != -1)
+      ::close(local);
+
+    if (remote != -1)
+      ::close(remote);
+  }
+
+  int local{-1};
+  int remote{-1};
+};
+
+} // namespace
+
+// Processes main thread callbacks and scheduled tasks until 'func'
+// returns true or ten seconds pass.
+template <typename Func>
+bool
+test_peer_read_threads::wait_for(Func func) {
+  auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+  while (!func()) {
+    if (std::chrono::steady_clock::now() >= timeout)
+      return false;
+
+    m_main_thread->test_add_cached_time(std::chrono::milliseconds(1));
+    m_main_thread->test_process_events_without_cached_time();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  return true;
+}
+
+void
+test_peer_read_threads::test_read() {
+  socket_pair sockets;
+  torrent::PeerReadThreads threads(2);
+
+  std::string received;
+
+  torrent::PeerReadBuffer* buffer{};
+
+  buffer = threads.open(sockets.local, [&]() {
+      char data[64];
+      int  length;
+
+      while ((length = buffer->read(data, sizeof(data))) > 0)
+        received.append(data, length);
+
+      CPPUNIT_ASSERT(length == -1 && errno == EAGAIN);
+    });
+
+  threads.insert_read(buffer);
+
+  CPPUNIT_ASSERT(::write(sockets.remote, "hello", 5) == 5);
+  CPPUNIT_ASSERT(wait_for([&]() { return received.size() == 5; }));
+
+  CPPUNIT_ASSERT(::write(sockets.remote, " world", 6) == 6);
+  CPPUNIT_ASSERT(wait_for([&]() { return received.size() == 11; }));
+
+  CPPUNIT_ASSERT(received == "hello world");
+
+  threads.close(buffer);
+}
+
+// The read thread stops receiving when the buffer is full, and resumes
+// once the main thread has read half of it.
+void
+test_peer_read_threads::test_backpressure() {
+  socket_pair sockets;
+  torrent::PeerReadThreads threads(1);
+
+  int send_size = torrent::PeerReadBuffer::capacity * 4;
+  CPPUNIT_ASSERT(::setsockopt(sockets.remote, SOL_SOCKET, SO_SNDBUF, &send_size, sizeof(send_size)) == 0);
+
+  auto buffer = threads.open(sockets.local, []() {});
+
+  std::string sent;
+
+  for (uint32_t i = 0; i < torrent::PeerReadBuffer::capacity * 4; i++)
+    sent.push_back(static_cast<char>(i % 251));
+
+  size_t written = 0;
+
+  auto write_more = [&]() {
+      ssize_t result;
+
+      while (written < sent.size() && (result = ::write(sockets.remote, sent.data() + written, sent.size() - written)) > 0)
+        written += result;
+    };
+
+  std::string received;
+  char        data[torrent::PeerReadBuffer::capacity];
+
+  while (received.size() < sent.size()) {
+    write_more();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    int length = buffer->read(data, sizeof(data));
+
+    if (length == -1) {
+      CPPUNIT_ASSERT(errno == EAGAIN);
+      continue;
+    }
+
+    CPPUNIT_ASSERT(length > 0 && static_cast<uint32_t>(length) <= torrent::PeerReadBuffer::capacity);
+    received.append(data, length);
+  }
+
+  CPPUNIT_ASSERT(received == sent);
+
+  threads.close(buffer);
+}
+
+void
+test_peer_read_threads::test_eof() {
+  socket_pair sockets;
+  torrent::PeerReadThreads threads(1);
+
+  int  result = -1;
+  bool called = false;
+
+  torrent::PeerReadBuffer* buffer{};
+
+  buffer = threads.open(sockets.local, [&]() {
+      char data[64];
+
+      called = true;
+      result = buffer->read(data, sizeof(data));
+
+      if (result == 2)
+        result = buffer->read(data, sizeof(data));
+    });
+
+  threads.insert_read(buffer);
+
+  CPPUNIT_ASSERT(::write(sockets.remote, "ab", 2) == 2);
+
+  ::close(sockets.remote);
+  sockets.remote = -1;
+
+  CPPUNIT_ASSERT(wait_for([&]() { return called && result == 0; }));
+
+  threads.close(buffer);
+}
+
+// Data received while the connection does not want to read is kept
+// until insert_read().
+void
+test_peer_read_threads::test_remove_read() {
+  socket_pair sockets;
+  torrent::PeerReadThreads threads(1);
+
+  int calls = 0;
+
+  torrent::PeerReadBuffer* buffer{};
+
+  buffer = threads.open(sockets.local, [&]() {
+      char data[64];
+
+      calls++;
+      CPPUNIT_ASSERT(buffer->read(data, sizeof(data)) == 5);
+    });
+
+  threads.insert_read(buffer);
+  threads.remove_read(buffer);
+
+  CPPUNIT_ASSERT(::write(sockets.remote, "hello", 5) == 5);
+
+  for (int i = 0; i < 20; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    m_main_thread->test_add_cached_time(std::chrono::milliseconds(1));
+    m_main_thread->test_process_events_without_cached_time();
+  }
+
+  CPPUNIT_ASSERT(calls == 0);
+
+  threads.insert_read(buffer);
+
+  CPPUNIT_ASSERT(wait_for([&]() { return calls == 1; }));
+
+  threads.close(buffer);
+}
+
+void
+test_peer_read_threads::test_close() {
+  socket_pair sockets;
+  torrent::PeerReadThreads threads(1);
+
+  int calls = 0;
+
+  auto buffer = threads.open(sockets.local, [&]() { calls++; });
+
+  threads.insert_read(buffer);
+  threads.close(buffer);
+
+  CPPUNIT_ASSERT(::write(sockets.remote, "hello", 5) == 5);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  m_main_thread->test_add_cached_time(std::chrono::milliseconds(1));
+  m_main_thread->test_process_events_without_cached_time();
+
+  CPPUNIT_ASSERT(calls == 0);
+
+  // The socket is no longer read by the thread.
+  char data[8];
+  CPPUNIT_ASSERT(::read(sockets.local, data, sizeof(data)) == 5);
+}
@@ -0,0 +1,29 @@
+#ifndef LIBTORRENT_TEST_NET_TEST_PEER_READ_THREADS_H
+#define LIBTORRENT_TEST_NET_TEST_PEER_READ_THREADS_H
+
+#include "test/helpers/test_main_thread.h"
+
+class test_peer_read_threads : public TestFixtureWithMainThread {
+  CPPUNIT_TEST_SUITE(test_peer_read_threads);
+
+  CPPUNIT_TEST(test_read);
+  CPPUNIT_TEST(test_backpressure);
+  CPPUNIT_TEST(test_eof);
+  CPPUNIT_TEST(test_remove_read);
+  CPPUNIT_TEST(test_close);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_read();
+  void test_backpressure();
+  void test_eof();
+  void test_remove_read();
+  void test_close();
+
+private:
+  template <typename Func>
+  bool wait_for(Func func);
+};
+
+#endif
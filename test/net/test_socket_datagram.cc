@@ -0,0 +1,109 @@
+#include "config.h"
+
+#include "test/net/test_socket_datagram.h"
+
+#include <cerrno>
+#include <string>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "net/socket_datagram.h"
+#include "torrent/exceptions.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test_socket_datagram);
+
+namespace {
+
+class test_datagram : public torrent::SocketDatagram {
+public:
+  test_datagram() {
+    int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    CPPUNIT_ASSERT(fd != -1);
+    CPPUNIT_ASSERT(fcntl(fd, F_SETFL, O_NONBLOCK) == 0);
+
+    sockaddr_in sa{};
+    sa.sin_family      = AF_INET;
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    CPPUNIT_ASSERT(::bind(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0);
+
+    socklen_t length = sizeof(m_address);
+    CPPUNIT_ASSERT(::getsockname(fd, reinterpret_cast<sockaddr*>(&m_address), &length) == 0);
+
+    set_file_descriptor(fd);
+  }
+
+  ~test_datagram() override { ::close(file_descriptor()); }
+
+  const char* type_name() const override { return "test_datagram"; }
+
+  void event_read() override {}
+  void event_write() override {}
+  void event_error() override {}
+
+  const sockaddr*     address() const { return reinterpret_cast<const sockaddr*>(&m_address); }
+  uint16_t            port() const    { return m_address.sin_port; }
+
+private:
+  sockaddr_in         m_address{};
+};
+
+} // namespace
+
+void
+test_socket_datagram::test_batch() {
+  test_datagram sender;
+  test_datagram receiver;
+
+  std::string messages[5] = { "first", "second", "third datagram", "4", "fifth" };
+  torrent::SocketDatagram::write_entry write_entries[5];
+
+  for (int i = 0; i < 5; i++)
+    write_entries[i] = { messages[i].data(), static_cast<unsigned int>(messages[i].size()), receiver.address() };
+
+  CPPUNIT_ASSERT(sender.write_datagrams_sa(write_entries, 5) == 5);
+
+  for (int i = 0; i < 5; i++)
+    CPPUNIT_ASSERT(write_entries[i].length == messages[i].size());
+
+  char        buffers[torrent::SocketDatagram::max_batch][64];
+  sockaddr_in addresses[torrent::SocketDatagram::max_batch];
+  torrent::SocketDatagram::read_entry read_entries[torrent::SocketDatagram::max_batch];
+
+  for (unsigned int i = 0; i < torrent::SocketDatagram::max_batch; i++)
+    read_entries[i] = { buffers[i], sizeof(buffers[i]), reinterpret_cast<sockaddr*>(&addresses[i]), sizeof(addresses[i]) };
+
+  CPPUNIT_ASSERT(receiver.read_datagrams_sa(read_entries, torrent::SocketDatagram::max_batch) == 5);
+
+  for (int i = 0; i < 5; i++) {
+    CPPUNIT_ASSERT(std::string(buffers[i], read_entries[i].length) == messages[i]);
+    CPPUNIT_ASSERT(read_entries[i].address_length == sizeof(sockaddr_in));
+    CPPUNIT_ASSERT(addresses[i].sin_port == sender.port());
+  }
+
+  read_entries[0].length = sizeof(buffers[0]);
+  read_entries[0].address_length = sizeof(addresses[0]);
+
+  CPPUNIT_ASSERT(receiver.read_datagrams_sa(read_entries, 1) == -1);
+  CPPUNIT_ASSERT(errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+void
+test_socket_datagram::test_batch_invalid() {
+  test_datagram socket;
+
+  char buffer[16];
+  sockaddr_in address;
+
+  torrent::SocketDatagram::read_entry  read_entry{buffer, sizeof(buffer), reinterpret_cast<sockaddr*>(&address), sizeof(address)};
+  torrent::SocketDatagram::write_entry write_entry{buffer, 0, socket.address()};
+
+  CPPUNIT_ASSERT_THROW(socket.read_datagrams_sa(&read_entry, 0), torrent::internal_error);
+  CPPUNIT_ASSERT_THROW(socket.read_datagrams_sa(&read_entry, torrent::SocketDatagram::max_batch + 1), torrent::internal_error);
+  CPPUNIT_ASSERT_THROW(socket.write_datagrams_sa(&write_entry, 1), torrent::internal_error);
+
+  read_entry.address = nullptr;
+  CPPUNIT_ASSERT_THROW(socket.read_datagrams_sa(&read_entry, 1), torrent::internal_error);
+}
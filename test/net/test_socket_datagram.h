@@ -0,0 +1,19 @@
+#ifndef LIBTORRENT_TEST_NET_TEST_SOCKET_DATAGRAM_H
+#define LIBTORRENT_TEST_NET_TEST_SOCKET_DATAGRAM_H
+
+#include "test/helpers/test_fixture.h"
+
+class test_socket_datagram : public test_fixture {
+  CPPUNIT_TEST_SUITE(test_socket_datagram);
+
+  CPPUNIT_TEST(test_batch);
+  CPPUNIT_TEST(test_batch_invalid);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_batch();
+  void test_batch_invalid();
+};
+
+#endif
@@ -0,0 +1,141 @@
+#include "config.h"
+
+#include "test/net/test_socket_stream.h"
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "net/socket_stream.h"
+#include "test/helpers/test_file.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test_socket_stream);
+
+namespace {
+
+class test_stream : public torrent::SocketStream {
+public:
+  test_stream(int fd) { set_file_descriptor(fd); }
+  ~test_stream() override { ::close(file_descriptor()); }
+
+  void event_read() override {}
+  void event_write() override {}
+  void event_error() override {}
+};
+
+} // namespace
+
+void
+test_socket_stream::test_write_vector() {
+  int fds[2];
+  CPPUNIT_ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+  test_stream stream(fds[0]);
+
+  char header[] = "header";
+  char part_a[] = "first part";
+  char part_b[] = "second";
+
+  iovec vec[3] = { { header, 6 }, { part_a, 10 }, { part_b, 6 } };
+
+  CPPUNIT_ASSERT(stream.write_vector_throws(vec, 3) == 22);
+
+  char result[22];
+  CPPUNIT_ASSERT(recv(fds[1], result, sizeof(result), MSG_WAITALL) == 22);
+  CPPUNIT_ASSERT(std::string(result, 22) == "headerfirst partsecond");
+
+  ::close(fds[1]);
+}
+
+void
+test_socket_stream::test_sendfile() {
+  if (!torrent::SocketStream::is_sendfile_supported())
+    return;
+
+  std::vector<char> contents(8192);
+  int file_fd = create_test_file(contents);
+
+  int fds[2];
+  CPPUNIT_ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+  test_stream stream(fds[0]);
+
+  CPPUNIT_ASSERT(stream.sendfile_stream_throws(file_fd, 1000, 3000) == 3000);
+
+  std::vector<char> result(3000);
+  CPPUNIT_ASSERT(recv(fds[1], result.data(), result.size(), MSG_WAITALL) == 3000);
+  CPPUNIT_ASSERT(std::equal(result.begin(), result.end(), contents.begin() + 1000));
+
+  // Reading past the end of the file is a storage error rather than a
+  // closed connection.
+  CPPUNIT_ASSERT_THROW(stream.sendfile_stream_throws(file_fd, contents.size(), 100), torrent::storage_error);
+
+  ::close(fds[1]);
+  ::close(file_fd);
+}
+
+// Zero-copy is only supported on TCP sockets, on loopback the kernel
+// copies the data but still reports the completions.
+void
+test_socket_stream::test_zerocopy() {
+  if (!torrent::SocketStream::is_zerocopy_supported())
+    return;
+
+  sockaddr_in sa{};
+  sa.sin_family      = AF_INET;
+  sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  socklen_t sa_length = sizeof(sa);
+
+  int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+  CPPUNIT_ASSERT(listen_fd != -1);
+  CPPUNIT_ASSERT(bind(listen_fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0);
+  CPPUNIT_ASSERT(listen(listen_fd, 1) == 0);
+  CPPUNIT_ASSERT(getsockname(listen_fd, reinterpret_cast<sockaddr*>(&sa), &sa_length) == 0);
+
+  int send_fd = socket(AF_INET, SOCK_STREAM, 0);
+  CPPUNIT_ASSERT(send_fd != -1);
+  CPPUNIT_ASSERT(connect(send_fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0);
+
+  int recv_fd = accept(listen_fd, nullptr, nullptr);
+  CPPUNIT_ASSERT(recv_fd != -1);
+  ::close(listen_fd);
+
+  test_stream stream(send_fd);
+
+  if (!stream.try_enable_zerocopy()) {
+    ::close(recv_fd);
+    return;
+  }
+
+  CPPUNIT_ASSERT(stream.is_zerocopy_enabled());
+  CPPUNIT_ASSERT(stream.is_zerocopy_completed(stream.zerocopy_sent()));
+
+  std::vector<char> contents(32 << 10);
+  fill_test_contents(contents);
+
+  uint32_t sent = stream.write_zerocopy_throws(contents.data(), contents.size());
+
+  CPPUNIT_ASSERT(sent != 0);
+  CPPUNIT_ASSERT(stream.zerocopy_sent() == 1);
+
+  std::vector<char> result(sent);
+  CPPUNIT_ASSERT(recv(recv_fd, result.data(), result.size(), MSG_WAITALL) == static_cast<ssize_t>(sent));
+  CPPUNIT_ASSERT(std::equal(result.begin(), result.end(), contents.begin()));
+
+  for (int i = 0; i < 100 && !stream.is_zerocopy_completed(stream.zerocopy_sent()); i++) {
+    pollfd pfd{send_fd, 0, 0};
+    poll(&pfd, 1, 10);
+
+    CPPUNIT_ASSERT(stream.read_zerocopy_completions());
+  }
+
+  CPPUNIT_ASSERT(stream.is_zerocopy_completed(stream.zerocopy_sent()));
+  CPPUNIT_ASSERT(stream.zerocopy_completed() == 1);
+
+  ::close(recv_fd);
+}
@@ -0,0 +1,21 @@
+#ifndef LIBTORRENT_TEST_NET_TEST_SOCKET_STREAM_H
+#define LIBTORRENT_TEST_NET_TEST_SOCKET_STREAM_H
+
+#include "test/helpers/test_fixture.h"
+
+class test_socket_stream : public test_fixture {
+  CPPUNIT_TEST_SUITE(test_socket_stream);
+
+  CPPUNIT_TEST(test_write_vector);
+  CPPUNIT_TEST(test_sendfile);
+  CPPUNIT_TEST(test_zerocopy);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_write_vector();
+  void test_sendfile();
+  void test_zerocopy();
+};
+
+#endif
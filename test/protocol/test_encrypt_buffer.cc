@@ -0,0 +1,88 @@
+#include "config.h"
+
+#include "test/protocol/test_encrypt_buffer.h"
+
+#include <memory>
+#include <vector>
+
+#include "protocol/encrypt_buffer.h"
+#include "torrent/exceptions.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test_encrypt_buffer);
+
+using torrent::EncryptBuffer;
+
+void
+test_encrypt_buffer::tearDown() {
+  EncryptBuffer::pool_clear();
+  test_fixture::tearDown();
+}
+
+void
+test_encrypt_buffer::test_size_for() {
+  CPPUNIT_ASSERT(EncryptBuffer::size_for(0, 16 << 10) == EncryptBuffer::min_size);
+  CPPUNIT_ASSERT(EncryptBuffer::size_for(64 << 10, 16 << 10) == (16 << 10));
+  CPPUNIT_ASSERT(EncryptBuffer::size_for(64 << 10, 128 << 10) == (16 << 10));
+  CPPUNIT_ASSERT(EncryptBuffer::size_for(65 << 10, 128 << 10) == (32 << 10));
+  CPPUNIT_ASSERT(EncryptBuffer::size_for(10 << 20, 16 << 10) == (16 << 10));
+  CPPUNIT_ASSERT(EncryptBuffer::size_for(10 << 20, 100 << 10) == (128 << 10));
+  CPPUNIT_ASSERT(EncryptBuffer::size_for(10 << 20, 1 << 20) == EncryptBuffer::max_size);
+}
+
+void
+test_encrypt_buffer::test_basic() {
+  EncryptBuffer buffer(16 << 10);
+
+  CPPUNIT_ASSERT(buffer.reserved() == (16 << 10));
+  CPPUNIT_ASSERT(buffer.remaining() == 0);
+  CPPUNIT_ASSERT(buffer.reserved_left() == (16 << 10));
+
+  buffer.move_end(1000);
+  CPPUNIT_ASSERT(buffer.remaining() == 1000);
+  CPPUNIT_ASSERT(buffer.reserved_left() == (16 << 10) - 1000);
+
+  CPPUNIT_ASSERT(!buffer.consume(600));
+  CPPUNIT_ASSERT(buffer.position() == buffer.begin() + 600);
+  CPPUNIT_ASSERT(buffer.consume(400));
+
+  buffer.reset_size(64 << 10);
+  CPPUNIT_ASSERT(buffer.reserved() == (64 << 10));
+  CPPUNIT_ASSERT(buffer.remaining() == 0);
+  CPPUNIT_ASSERT(buffer.size_end() == 0);
+
+  CPPUNIT_ASSERT_THROW(buffer.reset_size(3000), torrent::internal_error);
+  CPPUNIT_ASSERT_THROW(EncryptBuffer(EncryptBuffer::max_size * 2), torrent::internal_error);
+}
+
+void
+test_encrypt_buffer::test_pool_reuse() {
+  CPPUNIT_ASSERT(EncryptBuffer::pool_cached() == 0);
+
+  auto buffer = std::make_unique<EncryptBuffer>(32 << 10);
+  auto begin  = buffer->begin();
+
+  buffer.reset();
+  CPPUNIT_ASSERT(EncryptBuffer::pool_cached() == (32 << 10));
+
+  // Other size classes don't take the cached slab.
+  auto other = std::make_unique<EncryptBuffer>(16 << 10);
+  CPPUNIT_ASSERT(EncryptBuffer::pool_cached() == (32 << 10));
+
+  other->reset_size(32 << 10);
+  CPPUNIT_ASSERT(other->begin() == begin);
+  CPPUNIT_ASSERT(EncryptBuffer::pool_cached() == (16 << 10));
+}
+
+void
+test_encrypt_buffer::test_pool_limit() {
+  std::vector<std::unique_ptr<EncryptBuffer>> buffers;
+
+  for (size_t i = 0; i < EncryptBuffer::pool_max_cached / EncryptBuffer::max_size + 4; i++)
+    buffers.emplace_back(new EncryptBuffer(EncryptBuffer::max_size));
+
+  buffers.clear();
+  CPPUNIT_ASSERT(EncryptBuffer::pool_cached() == EncryptBuffer::pool_max_cached);
+
+  EncryptBuffer::pool_clear();
+  CPPUNIT_ASSERT(EncryptBuffer::pool_cached() == 0);
+}
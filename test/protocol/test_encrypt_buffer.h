@@ -0,0 +1,20 @@
+#include "test/helpers/test_fixture.h"
+
+class test_encrypt_buffer : public test_fixture {
+  CPPUNIT_TEST_SUITE(test_encrypt_buffer);
+
+  CPPUNIT_TEST(test_size_for);
+  CPPUNIT_TEST(test_basic);
+  CPPUNIT_TEST(test_pool_reuse);
+  CPPUNIT_TEST(test_pool_limit);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void tearDown() override;
+
+  void test_size_for();
+  void test_basic();
+  void test_pool_reuse();
+  void test_pool_limit();
+};
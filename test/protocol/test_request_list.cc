@@ -263,3 +263,69 @@ TestRequestList::test_choke_unchoke_transfer() {
 
   CLEAR_TRANSFERS();
 }
+
+#define DOWNLOAD_PIECE(piece)                                           \
+  CPPUNIT_ASSERT(request_list->downloading(*piece));                    \
+  request_list->transfer()->adjust_position(piece->length());           \
+  request_list->finished();
+
+void
+TestRequestList::test_rtt() {
+  SETUP_ALL_WITH_3(basic);
+
+  CPPUNIT_ASSERT(request_list->rtt() == 0us);
+
+  // Only the first request was sent with nothing ahead of it.
+  test_main_thread->test_set_cached_time(200ms);
+  DOWNLOAD_PIECE(piece_1);
+  CPPUNIT_ASSERT(request_list->rtt() == 200ms);
+
+  test_main_thread->test_set_cached_time(500ms);
+  DOWNLOAD_PIECE(piece_2);
+  test_main_thread->test_set_cached_time(600ms);
+  DOWNLOAD_PIECE(piece_3);
+  CPPUNIT_ASSERT(request_list->rtt() == 200ms);
+
+  test_main_thread->test_set_cached_time(1s);
+  auto piece_4 = request_list->delegate(1).at(0);
+
+  test_main_thread->test_set_cached_time(1s + 100ms);
+  DOWNLOAD_PIECE(piece_4);
+  CPPUNIT_ASSERT(request_list->rtt() == 187500us);
+
+  // A queued request answered sooner than the estimate lowers it.
+  test_main_thread->test_set_cached_time(2s);
+  auto queued_pieces = request_list->delegate(2);
+  CPPUNIT_ASSERT(queued_pieces.size() == 2);
+
+  test_main_thread->test_set_cached_time(2s + 10ms);
+  DOWNLOAD_PIECE(queued_pieces[1]);
+  CPPUNIT_ASSERT(request_list->rtt() == 10ms);
+
+  DOWNLOAD_PIECE(queued_pieces[0]);
+  CPPUNIT_ASSERT(request_list->rtt() == 10ms);
+}
+
+void
+TestRequestList::test_adaptive_pipe_size() {
+  SETUP_ALL(basic);
+
+  delegator->set_adaptive_pipelining(true);
+
+  CPPUNIT_ASSERT(request_list->calculate_pipe_size(512 << 10) == 120);
+
+  auto piece = request_list->delegate(1).at(0);
+
+  test_main_thread->test_set_cached_time(2s);
+  DOWNLOAD_PIECE(piece);
+  CPPUNIT_ASSERT(request_list->rtt() == 2s);
+
+  // Twice the 1 MB bandwidth-delay product in blocks, plus two.
+  CPPUNIT_ASSERT(request_list->calculate_pipe_size(512 << 10) == 130);
+  CPPUNIT_ASSERT(request_list->calculate_pipe_size(8 << 20) == torrent::RequestList::pipe_max_size);
+  CPPUNIT_ASSERT(request_list->delivery_rate() == (1 << 10) / torrent::RequestList::delivery_rate_span);
+
+  delegator->set_adaptive_pipelining(false);
+
+  CPPUNIT_ASSERT(request_list->calculate_pipe_size(512 << 10) == 120);
+}
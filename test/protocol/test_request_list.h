@@ -11,6 +11,9 @@ class TestRequestList : public test_fixture {
   CPPUNIT_TEST(test_choke_unchoke_discard);
   CPPUNIT_TEST(test_choke_unchoke_transfer);
 
+  CPPUNIT_TEST(test_rtt);
+  CPPUNIT_TEST(test_adaptive_pipe_size);
+
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -22,4 +25,7 @@ public:
   void test_choke_normal();
   void test_choke_unchoke_discard();
   void test_choke_unchoke_transfer();
+
+  void test_rtt();
+  void test_adaptive_pipe_size();
 };
@@ -0,0 +1,133 @@
+#include "config.h"
+
+#include "test/torrent/download/test_download_manager.h"
+
+#include <algorithm>
+
+#include "download/download_wrapper.h"
+#include "torrent/download_info.h"
+#include "torrent/exceptions.h"
+#include "torrent/download/download_manager.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test_download_manager);
+
+namespace {
+
+torrent::HashString
+make_hash(char c) {
+  torrent::HashString hash;
+  std::fill(hash.begin(), hash.end(), c);
+  return hash;
+}
+
+torrent::DownloadWrapper*
+make_download(char hash, char hash_obfuscated) {
+  auto download = new torrent::DownloadWrapper;
+
+  download->info()->mutable_hash()            = make_hash(hash);
+  download->info()->mutable_hash_obfuscated() = make_hash(hash_obfuscated);
+
+  return download;
+}
+
+} // namespace
+
+void
+test_download_manager::test_insert_erase() {
+  torrent::DownloadManager manager;
+
+  auto download_a = make_download('a', 'A');
+  auto download_b = make_download('b', 'B');
+
+  manager.insert(download_a);
+  manager.insert(download_b);
+
+  CPPUNIT_ASSERT(manager.size() == 2);
+  CPPUNIT_ASSERT(*manager.find(make_hash('a')) == download_a);
+  CPPUNIT_ASSERT(*manager.find(make_hash('b')) == download_b);
+  CPPUNIT_ASSERT(manager.find(make_hash('c')) == manager.end());
+
+  CPPUNIT_ASSERT(manager.find_main(make_hash('a').data()) == download_a->main());
+  CPPUNIT_ASSERT(manager.find_main_obfuscated(make_hash('B').data()) == download_b->main());
+
+  // Lookups use the matching hash only.
+  CPPUNIT_ASSERT(manager.find_main(make_hash('A').data()) == nullptr);
+  CPPUNIT_ASSERT(manager.find_main_obfuscated(make_hash('a').data()) == nullptr);
+
+  manager.erase(download_a);
+
+  CPPUNIT_ASSERT(manager.size() == 1);
+  CPPUNIT_ASSERT(manager.find(make_hash('a')) == manager.end());
+  CPPUNIT_ASSERT(manager.find_main(make_hash('a').data()) == nullptr);
+  CPPUNIT_ASSERT(manager.find_main_obfuscated(make_hash('A').data()) == nullptr);
+  CPPUNIT_ASSERT(manager.find_main_obfuscated(make_hash('B').data()) == download_b->main());
+
+  CPPUNIT_ASSERT_THROW(manager.erase(download_a), torrent::internal_error);
+
+  // The hashes of an erased download may be reused.
+  auto download_c = make_download('a', 'A');
+  manager.insert(download_c);
+
+  CPPUNIT_ASSERT(*manager.find(make_hash('a')) == download_c);
+  CPPUNIT_ASSERT(manager.find_main_obfuscated(make_hash('A').data()) == download_c->main());
+}
+
+void
+test_download_manager::test_clear() {
+  torrent::DownloadManager manager;
+
+  manager.insert(make_download('a', 'A'));
+  manager.insert(make_download('b', 'B'));
+  manager.clear();
+
+  CPPUNIT_ASSERT(manager.empty());
+  CPPUNIT_ASSERT(manager.find(make_hash('a')) == manager.end());
+  CPPUNIT_ASSERT(manager.find_main(make_hash('b').data()) == nullptr);
+  CPPUNIT_ASSERT(manager.find_main_obfuscated(make_hash('A').data()) == nullptr);
+
+  auto download = make_download('a', 'A');
+  manager.insert(download);
+
+  CPPUNIT_ASSERT(manager.find_main_obfuscated(make_hash('A').data()) == download->main());
+}
+
+void
+test_download_manager::test_duplicate_hash() {
+  torrent::DownloadManager manager;
+
+  auto download_a = make_download('a', 'A');
+  auto download_b = make_download('a', 'B');
+
+  manager.insert(download_a);
+
+  CPPUNIT_ASSERT_THROW(manager.insert(download_b), torrent::internal_error);
+  delete download_b;
+
+  CPPUNIT_ASSERT(manager.size() == 1);
+  CPPUNIT_ASSERT(*manager.find(make_hash('a')) == download_a);
+  CPPUNIT_ASSERT(manager.find_main_obfuscated(make_hash('B').data()) == nullptr);
+}
+
+// A colliding obfuscated hash must not leave the info hash indexed.
+void
+test_download_manager::test_duplicate_obfuscated_hash() {
+  torrent::DownloadManager manager;
+
+  auto download_a = make_download('a', 'A');
+  auto download_b = make_download('b', 'A');
+
+  manager.insert(download_a);
+
+  CPPUNIT_ASSERT_THROW(manager.insert(download_b), torrent::internal_error);
+  delete download_b;
+
+  CPPUNIT_ASSERT(manager.size() == 1);
+  CPPUNIT_ASSERT(manager.find(make_hash('b')) == manager.end());
+  CPPUNIT_ASSERT(manager.find_main(make_hash('b').data()) == nullptr);
+  CPPUNIT_ASSERT(manager.find_main_obfuscated(make_hash('A').data()) == download_a->main());
+
+  auto download_c = make_download('b', 'C');
+  manager.insert(download_c);
+
+  CPPUNIT_ASSERT(*manager.find(make_hash('b')) == download_c);
+}
@@ -0,0 +1,18 @@
+#include "test/helpers/test_main_thread.h"
+
+class test_download_manager : public TestFixtureWithMainAndTrackerThread {
+  CPPUNIT_TEST_SUITE(test_download_manager);
+
+  CPPUNIT_TEST(test_insert_erase);
+  CPPUNIT_TEST(test_clear);
+  CPPUNIT_TEST(test_duplicate_hash);
+  CPPUNIT_TEST(test_duplicate_obfuscated_hash);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_insert_erase();
+  void test_clear();
+  void test_duplicate_hash();
+  void test_duplicate_obfuscated_hash();
+};
@@ -0,0 +1,146 @@
+#include "config.h"
+
+#include "test/utils/test_bitfield_ops.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "torrent/bitfield.h"
+#include "utils/bitfield_ops.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test_bitfield_ops);
+
+// Sizes around the byte, word and vector boundaries.
+static const uint32_t test_sizes[] = { 0, 1, 7, 8, 9, 31, 32, 33, 63, 64, 65, 127, 128, 129, 255, 256, 257, 1000, 4099 };
+
+static bool
+reference_get(const std::vector<uint8_t>& data, uint32_t index) {
+  return data[index / 8] & (0x80 >> (index % 8));
+}
+
+static std::vector<uint8_t>
+random_bits(std::mt19937& rng, uint32_t size_bits, unsigned int density) {
+  std::vector<uint8_t> data((size_bits + 7) / 8);
+
+  for (uint32_t i = 0; i < size_bits; i++)
+    if (rng() % 100 < density)
+      data[i / 8] |= 0x80 >> (i % 8);
+
+  return data;
+}
+
+void
+test_bitfield_ops::test_count() {
+  std::mt19937 rng(1);
+
+  for (auto size : test_sizes) {
+    auto a = random_bits(rng, size, 50);
+    auto b = random_bits(rng, size, 50);
+
+    uint32_t count = 0;
+    uint32_t count_and = 0;
+
+    for (uint32_t i = 0; i < size; i++) {
+      count     += reference_get(a, i);
+      count_and += reference_get(a, i) && reference_get(b, i);
+    }
+
+    CPPUNIT_ASSERT(torrent::bitfield_count(a.data(), size) == count);
+    CPPUNIT_ASSERT(torrent::bitfield_count_and(a.data(), b.data(), size) == count_and);
+  }
+
+  // Bits past the size are ignored.
+  uint8_t full[2] = { 0xff, 0xff };
+
+  CPPUNIT_ASSERT(torrent::bitfield_count(full, 9) == 9);
+}
+
+void
+test_bitfield_ops::test_find_next() {
+  std::mt19937 rng(2);
+
+  for (auto size : test_sizes) {
+    for (unsigned int density : { 0, 2, 50, 100 }) {
+      auto a = random_bits(rng, size, density);
+      auto b = random_bits(rng, size, 50);
+
+      for (uint32_t first = 0; first <= size; first += 1 + first / 8) {
+        uint32_t expected = first;
+        uint32_t expected_and = first;
+
+        while (expected < size && !reference_get(a, expected))
+          expected++;
+
+        while (expected_and < size && !(reference_get(a, expected_and) && reference_get(b, expected_and)))
+          expected_and++;
+
+        CPPUNIT_ASSERT(torrent::bitfield_find_next(a.data(), nullptr, first, size) == expected);
+        CPPUNIT_ASSERT(torrent::bitfield_find_next(a.data(), b.data(), first, size) == expected_and);
+      }
+    }
+  }
+
+  uint8_t data[2] = { 0x00, 0x40 };
+
+  CPPUNIT_ASSERT(torrent::bitfield_find_next(data, nullptr, 0, 16) == 9);
+  CPPUNIT_ASSERT(torrent::bitfield_find_next(data, nullptr, 0, 9) == 9);
+  CPPUNIT_ASSERT(torrent::bitfield_find_next(data, nullptr, 10, 16) == 16);
+  CPPUNIT_ASSERT(torrent::bitfield_find_next(data, nullptr, 12, 10) == 10);
+}
+
+void
+test_bitfield_ops::test_counters() {
+  std::mt19937 rng(3);
+
+  for (auto size : test_sizes) {
+    std::vector<uint8_t> counters(size);
+    std::vector<uint8_t> expected(size);
+    std::vector<std::vector<uint8_t>> peers;
+
+    for (unsigned int density : { 0, 5, 50, 100, 50 }) {
+      peers.push_back(random_bits(rng, size, density));
+
+      torrent::bitfield_increment_counters(counters.data(), peers.back().data(), size);
+
+      for (uint32_t i = 0; i < size; i++)
+        expected[i] += reference_get(peers.back(), i);
+
+      CPPUNIT_ASSERT(counters == expected);
+    }
+
+    for (const auto& peer : peers) {
+      torrent::bitfield_decrement_counters(counters.data(), peer.data(), size);
+
+      for (uint32_t i = 0; i < size; i++)
+        expected[i] -= reference_get(peer, i);
+
+      CPPUNIT_ASSERT(counters == expected);
+    }
+
+    CPPUNIT_ASSERT(std::all_of(counters.begin(), counters.end(), [](auto c) { return c == 0; }));
+  }
+}
+
+void
+test_bitfield_ops::test_bitfield() {
+  torrent::Bitfield bitfield;
+  bitfield.set_size_bits(100);
+  bitfield.allocate();
+  bitfield.unset_all();
+
+  CPPUNIT_ASSERT(bitfield.find_first_set(0, 100) == 100);
+
+  bitfield.set(70);
+  bitfield.set(99);
+
+  CPPUNIT_ASSERT(bitfield.find_first_set(0, 100) == 70);
+  CPPUNIT_ASSERT(bitfield.find_first_set(71, 100) == 99);
+  CPPUNIT_ASSERT(bitfield.find_first_set(0, 70) == 70);
+
+  // Unused tail bits are cleared before counting.
+  bitfield.begin()[12] = 0xff;
+  bitfield.update();
+
+  CPPUNIT_ASSERT(bitfield.size_set() == 5);
+}
@@ -0,0 +1,18 @@
+#include "test/helpers/test_fixture.h"
+
+class test_bitfield_ops : public test_fixture {
+  CPPUNIT_TEST_SUITE(test_bitfield_ops);
+
+  CPPUNIT_TEST(test_count);
+  CPPUNIT_TEST(test_find_next);
+  CPPUNIT_TEST(test_counters);
+  CPPUNIT_TEST(test_bitfield);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_count();
+  void test_find_next();
+  void test_counters();
+  void test_bitfield();
+};
@@ -0,0 +1,100 @@
+#include "config.h"
+
+#include "test/utils/test_diffie_hellman_pool.h"
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "protocol/handshake_encryption.h"
+#include "torrent/exceptions.h"
+#include "utils/diffie_hellman.h"
+#include "utils/diffie_hellman_pool.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test_diffie_hellman_pool);
+
+namespace {
+
+std::unique_ptr<torrent::DiffieHellmanPool>
+create_pool() {
+  return std::make_unique<torrent::DiffieHellmanPool>(torrent::HandshakeEncryption::dh_prime, torrent::HandshakeEncryption::dh_prime_length,
+                                                      torrent::HandshakeEncryption::dh_generator, torrent::HandshakeEncryption::dh_generator_length);
+}
+
+bool
+wait_for_size(torrent::DiffieHellmanPool* pool, size_t size) {
+  auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+  while (pool->size() != size) {
+    if (std::chrono::steady_clock::now() > timeout)
+      return false;
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  return true;
+}
+
+} // namespace
+
+void
+test_diffie_hellman_pool::test_on_demand() {
+  auto pool = create_pool();
+
+  CPPUNIT_ASSERT(pool->reserve() == 0);
+  CPPUNIT_ASSERT(pool->size() == 0);
+
+  auto key = pool->take();
+
+  CPPUNIT_ASSERT(key != nullptr);
+  CPPUNIT_ASSERT(key->is_valid());
+  CPPUNIT_ASSERT(pool->size() == 0);
+
+  CPPUNIT_ASSERT_THROW(pool->set_reserve(torrent::DiffieHellmanPool::max_reserve + 1), torrent::input_error);
+}
+
+void
+test_diffie_hellman_pool::test_reserve() {
+  auto pool = create_pool();
+
+  pool->set_reserve(4);
+  CPPUNIT_ASSERT(wait_for_size(pool.get(), 4));
+
+  auto key = pool->take();
+  CPPUNIT_ASSERT(key->is_valid());
+
+  // The worker refills the reserve after a key is taken.
+  CPPUNIT_ASSERT(wait_for_size(pool.get(), 4));
+
+  pool->set_reserve(2);
+  CPPUNIT_ASSERT(pool->size() == 2);
+
+  pool->set_reserve(0);
+  CPPUNIT_ASSERT(pool->size() == 0);
+  CPPUNIT_ASSERT(pool->take()->is_valid());
+}
+
+void
+test_diffie_hellman_pool::test_shared_secret() {
+  auto pool = create_pool();
+
+  pool->set_reserve(2);
+  CPPUNIT_ASSERT(wait_for_size(pool.get(), 2));
+
+  auto key_a = pool->take();
+  auto key_b = pool->take();
+
+  unsigned char pub_a[96];
+  unsigned char pub_b[96];
+
+  key_a->store_pub_key(pub_a, 96);
+  key_b->store_pub_key(pub_b, 96);
+
+  // Pooled keys are never handed out twice.
+  CPPUNIT_ASSERT(std::memcmp(pub_a, pub_b, 96) != 0);
+
+  CPPUNIT_ASSERT(key_a->compute_secret(pub_b, 96));
+  CPPUNIT_ASSERT(key_b->compute_secret(pub_a, 96));
+
+  CPPUNIT_ASSERT(key_a->secret_str() == key_b->secret_str());
+}
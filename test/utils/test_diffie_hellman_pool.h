@@ -0,0 +1,16 @@
+#include "test/helpers/test_fixture.h"
+
+class test_diffie_hellman_pool : public test_fixture {
+  CPPUNIT_TEST_SUITE(test_diffie_hellman_pool);
+
+  CPPUNIT_TEST(test_on_demand);
+  CPPUNIT_TEST(test_reserve);
+  CPPUNIT_TEST(test_shared_secret);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_on_demand();
+  void test_reserve();
+  void test_shared_secret();
+};
@@ -0,0 +1,111 @@
+#include "config.h"
+
+#include "test/utils/test_io_uring.h"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <pthread.h>
+#include <thread>
+#include <unistd.h>
+
+#include "utils/io_uring.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test_io_uring);
+
+using namespace std::chrono_literals;
+
+namespace {
+
+void
+interrupt_handler(int) {
+}
+
+} // namespace
+
+void
+test_io_uring::test_read() {
+  if (!torrent::utils::IoUring::is_supported())
+    return;
+
+  int fds[2];
+  CPPUNIT_ASSERT(pipe(fds) == 0);
+  CPPUNIT_ASSERT(write(fds[1], "abcd", 4) == 4);
+
+  torrent::utils::IoUring ring(4);
+  char buffer[4]{};
+
+  CPPUNIT_ASSERT(ring.is_valid());
+  CPPUNIT_ASSERT(ring.prepare_read(fds[0], buffer, 4, 0, 7));
+  CPPUNIT_ASSERT(ring.submit_and_wait(1));
+
+  uint64_t user_data;
+  int32_t  result;
+
+  CPPUNIT_ASSERT(ring.pop_completion(&user_data, &result));
+  CPPUNIT_ASSERT(user_data == 7 && result == 4);
+  CPPUNIT_ASSERT(std::memcmp(buffer, "abcd", 4) == 0);
+  CPPUNIT_ASSERT(!ring.pop_completion(&user_data, &result));
+
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+// Signals delivered while waiting must neither lose the prepared
+// entries nor leave the caller waiting for a read never submitted.
+void
+test_io_uring::test_interrupted_wait() {
+  if (!torrent::utils::IoUring::is_supported())
+    return;
+
+  struct sigaction action{};
+  struct sigaction old_action{};
+  action.sa_handler = &interrupt_handler;
+  sigemptyset(&action.sa_mask);
+
+  CPPUNIT_ASSERT(sigaction(SIGUSR1, &action, &old_action) == 0);
+
+  int fds[2];
+  CPPUNIT_ASSERT(pipe(fds) == 0);
+
+  torrent::utils::IoUring ring(4);
+  char buffer[4]{};
+
+  CPPUNIT_ASSERT(ring.prepare_read(fds[0], buffer, 4, 0, 7));
+
+  std::atomic<bool> done{false};
+  pthread_t waiter = pthread_self();
+
+  std::thread interrupter([&done, waiter, fd = fds[1]] {
+      for (int i = 0; i < 5 && !done; i++) {
+        std::this_thread::sleep_for(20ms);
+        pthread_kill(waiter, SIGUSR1);
+      }
+
+      if (write(fd, "abcd", 4) != 4)
+        std::abort();
+    });
+
+  uint64_t user_data;
+  int32_t  result;
+  bool     completed = false;
+  bool     submitted = true;
+
+  for (int i = 0; i < 100 && submitted && !completed; i++) {
+    submitted = ring.submit_and_wait(1);
+    completed = ring.pop_completion(&user_data, &result);
+  }
+
+  done = true;
+  interrupter.join();
+
+  CPPUNIT_ASSERT(submitted && completed);
+  CPPUNIT_ASSERT(user_data == 7 && result == 4);
+  CPPUNIT_ASSERT(std::memcmp(buffer, "abcd", 4) == 0);
+
+  sigaction(SIGUSR1, &old_action, nullptr);
+
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
@@ -0,0 +1,14 @@
+#include "test/helpers/test_fixture.h"
+
+class test_io_uring : public test_fixture {
+  CPPUNIT_TEST_SUITE(test_io_uring);
+
+  CPPUNIT_TEST(test_read);
+  CPPUNIT_TEST(test_interrupted_wait);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_read();
+  void test_interrupted_wait();
+};
@@ -0,0 +1,88 @@
+#include "config.h"
+
+#include "test/utils/test_mpsc_ring.h"
+
+#include <thread>
+#include <vector>
+
+#include "torrent/exceptions.h"
+#include "utils/mpsc_ring.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test_mpsc_ring);
+
+void
+test_mpsc_ring::test_basic() {
+  CPPUNIT_ASSERT_THROW(torrent::utils::MpscRing<int>(0), torrent::internal_error);
+  CPPUNIT_ASSERT_THROW(torrent::utils::MpscRing<int>(12), torrent::internal_error);
+
+  torrent::utils::MpscRing<int> ring(4);
+  int value;
+
+  CPPUNIT_ASSERT(ring.capacity() == 4);
+  CPPUNIT_ASSERT(!ring.try_pop(value));
+
+  for (int i = 0; i < 10; i++) {
+    CPPUNIT_ASSERT(ring.try_push(i));
+    CPPUNIT_ASSERT(ring.try_pop(value));
+    CPPUNIT_ASSERT(value == i);
+  }
+
+  CPPUNIT_ASSERT(!ring.try_pop(value));
+}
+
+void
+test_mpsc_ring::test_full() {
+  torrent::utils::MpscRing<int> ring(4);
+  int value;
+
+  for (int i = 0; i < 4; i++)
+    CPPUNIT_ASSERT(ring.try_push(i));
+
+  CPPUNIT_ASSERT(!ring.try_push(4));
+
+  CPPUNIT_ASSERT(ring.try_pop(value) && value == 0);
+  CPPUNIT_ASSERT(ring.try_push(4));
+
+  for (int i = 1; i < 5; i++)
+    CPPUNIT_ASSERT(ring.try_pop(value) && value == i);
+
+  CPPUNIT_ASSERT(!ring.try_pop(value));
+}
+
+void
+test_mpsc_ring::test_producers() {
+  const int producer_count = 4;
+  const int value_count = 20000;
+
+  torrent::utils::MpscRing<int> ring(64);
+  std::vector<std::thread> producers;
+
+  for (int p = 0; p < producer_count; p++)
+    producers.emplace_back([&ring, p] {
+        for (int i = 0; i < value_count; i++)
+          while (!ring.try_push(p * value_count + i))
+            std::this_thread::yield();
+      });
+
+  std::vector<int> last_value(producer_count, -1);
+  int received = 0;
+
+  while (received != producer_count * value_count) {
+    int value;
+
+    if (!ring.try_pop(value)) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    // Values from each producer must arrive in order.
+    int producer = value / value_count;
+    CPPUNIT_ASSERT(value % value_count == last_value[producer] + 1);
+
+    last_value[producer] = value % value_count;
+    received++;
+  }
+
+  for (auto& producer : producers)
+    producer.join();
+}
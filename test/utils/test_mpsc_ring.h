@@ -0,0 +1,16 @@
+#include "test/helpers/test_fixture.h"
+
+class test_mpsc_ring : public test_fixture {
+  CPPUNIT_TEST_SUITE(test_mpsc_ring);
+
+  CPPUNIT_TEST(test_basic);
+  CPPUNIT_TEST(test_full);
+  CPPUNIT_TEST(test_producers);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_basic();
+  void test_full();
+  void test_producers();
+};
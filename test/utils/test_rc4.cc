@@ -0,0 +1,95 @@
+#include "config.h"
+
+#include "test/utils/test_rc4.h"
+
+#include <algorithm>
+#include <string>
+
+#include "utils/rc4.h"
+#include "utils/rc4_portable.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test_rc4);
+
+namespace {
+
+template <typename Cipher>
+std::string
+rc4_crypt(const std::string& key, const std::string& data) {
+  Cipher rc4(reinterpret_cast<const unsigned char*>(key.data()), key.size());
+  std::string result(data.size(), '\0');
+
+  rc4.crypt(data.data(), &result[0], data.size());
+  return result;
+}
+
+std::string
+make_data(uint32_t length) {
+  std::string data(length, '\0');
+
+  for (uint32_t i = 0; i < length; i++)
+    data[i] = static_cast<char>(i * 13 + 5);
+
+  return data;
+}
+
+template <typename Cipher>
+void
+check_vectors() {
+  CPPUNIT_ASSERT(rc4_crypt<Cipher>("Key", "Plaintext") == std::string("\xBB\xF3\x16\xE8\xD9\x40\xAF\x0A\xD3", 9));
+  CPPUNIT_ASSERT(rc4_crypt<Cipher>("Wiki", "pedia") == std::string("\x10\x21\xBF\x04\x20", 5));
+  CPPUNIT_ASSERT(rc4_crypt<Cipher>("Secret", "Attack at dawn") == std::string("\x45\xA0\x1F\x64\x5F\xC3\x5B\x38\x35\x52\x54\x4B\x9B\xF5", 14));
+
+  // RFC 6229, 40 bit key, keystream at offsets 0 and 4096.
+  std::string key("\x01\x02\x03\x04\x05", 5);
+  std::string keystream = rc4_crypt<Cipher>(key, std::string(4112, '\0'));
+
+  CPPUNIT_ASSERT(keystream.substr(0, 16) == std::string("\xb2\x39\x63\x05\xf0\x3d\xc0\x27\xcc\xc3\x52\x4a\x0a\x11\x18\xa8", 16));
+  CPPUNIT_ASSERT(keystream.substr(4096, 16) == std::string("\xff\x25\xb5\x89\x95\x99\x67\x07\xe5\x1f\xbd\xf0\x8b\x34\xd8\x75", 16));
+}
+
+} // namespace
+
+void
+test_rc4::test_vectors() {
+  check_vectors<torrent::RC4>();
+  check_vectors<torrent::RC4Portable>();
+}
+
+void
+test_rc4::test_split() {
+  std::string key("split key");
+  std::string data = make_data(1000);
+  std::string expected = rc4_crypt<torrent::RC4>(key, data);
+
+  // The portable cipher is compared against RC4, which may be OpenSSL.
+  for (unsigned int step : { 1, 3, 7, 8, 9, 64, 333 }) {
+    torrent::RC4Portable rc4(reinterpret_cast<const unsigned char*>(key.data()), key.size());
+    std::string result(data.size(), '\0');
+
+    // Odd step sizes leave the 8 byte blocks unaligned.
+    for (unsigned int offset = 0; offset < data.size(); offset += step) {
+      unsigned int length = std::min<unsigned int>(step, data.size() - offset);
+      rc4.crypt(data.data() + offset, &result[offset], length);
+    }
+
+    CPPUNIT_ASSERT_MESSAGE("step " + std::to_string(step), result == expected);
+  }
+}
+
+void
+test_rc4::test_in_place() {
+  std::string key("in place key");
+  std::string data = make_data(517);
+  std::string expected = rc4_crypt<torrent::RC4>(key, data.substr(1));
+
+  torrent::RC4Portable rc4(reinterpret_cast<const unsigned char*>(key.data()), key.size());
+  std::string result = data;
+
+  rc4.crypt(&result[1], &result[1], 516);
+  CPPUNIT_ASSERT(result[0] == data[0]);
+  CPPUNIT_ASSERT(result.substr(1) == expected);
+
+  torrent::RC4Portable decrypt(reinterpret_cast<const unsigned char*>(key.data()), key.size());
+  decrypt.crypt(&result[1], &result[1], 516);
+  CPPUNIT_ASSERT(result == data);
+}
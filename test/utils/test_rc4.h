@@ -0,0 +1,16 @@
+#include "test/helpers/test_fixture.h"
+
+class test_rc4 : public test_fixture {
+  CPPUNIT_TEST_SUITE(test_rc4);
+
+  CPPUNIT_TEST(test_vectors);
+  CPPUNIT_TEST(test_split);
+  CPPUNIT_TEST(test_in_place);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_vectors();
+  void test_split();
+  void test_in_place();
+};
@@ -0,0 +1,104 @@
+#include "config.h"
+
+#include "test/utils/test_sha1_batch.h"
+
+#include <string>
+#include <vector>
+
+#include "torrent/exceptions.h"
+#include "torrent/hash_string.h"
+#include "utils/sha1.h"
+#include "utils/sha1_batch.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test_sha1_batch);
+
+namespace {
+
+torrent::HashString
+sha1_reference(const std::string& data) {
+  torrent::Sha1 sha1;
+  torrent::HashString hash;
+
+  sha1.init();
+  sha1.update(data.data(), data.size());
+  sha1.final_c(hash.data());
+
+  return hash;
+}
+
+std::string
+make_message(unsigned int index, uint32_t length) {
+  std::string data(length, '\0');
+
+  for (uint32_t i = 0; i < length; i++)
+    data[i] = static_cast<char>(index * 31 + i * 7);
+
+  return data;
+}
+
+// Splits each message into segments of 'segment_size', with the
+// first segment offset by the message index to vary block alignment.
+bool
+verify_batch(unsigned int lanes, unsigned int count, uint32_t length, uint32_t segment_size) {
+  std::vector<std::string>            data;
+  std::vector<torrent::sha1_segments> messages(count);
+
+  for (unsigned int i = 0; i < count; i++)
+    data.push_back(make_message(i, length));
+
+  for (unsigned int i = 0; i < count; i++) {
+    uint32_t position = 0;
+    uint32_t next     = std::min(length, i % 13);
+
+    while (position != length) {
+      messages[i].emplace_back(data[i].data() + position, next - position);
+
+      position = next;
+      next     = position + std::min(segment_size, length - position);
+    }
+  }
+
+  std::vector<char> digests(count * torrent::HashString::size_data);
+  torrent::sha1_batch(messages.data(), count, digests.data(), lanes);
+
+  for (unsigned int i = 0; i < count; i++)
+    if (*torrent::HashString::cast_from(digests.data() + i * torrent::HashString::size_data) != sha1_reference(data[i]))
+      return false;
+
+  return true;
+}
+
+} // namespace
+
+void
+test_sha1_batch::test_lengths() {
+  for (unsigned int lanes = 1; lanes <= torrent::sha1_batch_max_lanes(); lanes *= 2) {
+    if (lanes == 2)
+      continue;
+
+    for (uint32_t length : {0, 1, 55, 56, 63, 64, 65, 119, 120, 128, 16384, 100003})
+      CPPUNIT_ASSERT(verify_batch(lanes, lanes + 3, length, ~uint32_t()));
+  }
+}
+
+void
+test_sha1_batch::test_segments() {
+  for (unsigned int lanes = 1; lanes <= torrent::sha1_batch_max_lanes(); lanes *= 2) {
+    if (lanes == 2)
+      continue;
+
+    for (uint32_t segment_size : {1, 7, 64, 100, 4096})
+      CPPUNIT_ASSERT(verify_batch(lanes, lanes - 1, 10000, segment_size));
+  }
+}
+
+void
+test_sha1_batch::test_unequal_length() {
+  std::string first(100, 'a');
+  std::string second(101, 'b');
+
+  torrent::sha1_segments messages[2] = { {{first.data(), first.size()}}, {{second.data(), second.size()}} };
+  char digests[2 * torrent::HashString::size_data];
+
+  CPPUNIT_ASSERT_THROW(torrent::sha1_batch(messages, 2, digests, torrent::sha1_batch_max_lanes()), torrent::internal_error);
+}
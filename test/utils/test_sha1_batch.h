@@ -0,0 +1,16 @@
+#include "test/helpers/test_fixture.h"
+
+class test_sha1_batch : public test_fixture {
+  CPPUNIT_TEST_SUITE(test_sha1_batch);
+
+  CPPUNIT_TEST(test_lengths);
+  CPPUNIT_TEST(test_segments);
+  CPPUNIT_TEST(test_unequal_length);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_lengths();
+  void test_segments();
+  void test_unequal_length();
+};